@@ -1,3 +1,3 @@
-#include "MsQuicApi.h"
-
+#include "MsQuicApi.h"
+
 MsQuicApi const* MsQuic = new MsQuicApi();
\ No newline at end of file
@@ -1,5 +1,5 @@
-#pragma once
-#include <msquic.hpp>
-
-extern MsQuicApi const * MsQuic;
-
+#pragma once
+#include <msquic.hpp>
+
+extern MsQuicApi const * MsQuic;
+
@@ -0,0 +1,229 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "MsquicMetrics.h"
+
+namespace hope {
+    namespace utils {
+
+        // 发送缓冲区的分级 slab 池
+        // 每个线程一个分片：本线程分配、释放只操作普通链表；其他线程释放（如 msquic 工作线程上的 SEND_COMPLETE）
+        // 压进所属分片的无锁栈，分片空了再整体取回
+        // 块头嵌在数据前面，记录所属分片和级别，释放时不需要查找
+        class MsquicBufferPool {
+        public:
+
+            static constexpr size_t CLASS_COUNT = 5;
+
+            static constexpr size_t SIZE_CLASSES[CLASS_COUNT] = { 256, 1024, 4096, 16 * 1024, 64 * 1024 };
+
+            // 每次向系统申请的 slab 大小，切成同级别的块
+            static constexpr size_t SLAB_BYTES = 256 * 1024;
+
+            // 超过最大级别直接走 operator new
+            static constexpr uint32_t LARGE_CLASS = UINT32_MAX;
+
+            static unsigned char* allocate(size_t size) {
+
+                uint32_t sizeClass = classOf(size);
+
+                if (sizeClass == LARGE_CLASS) {
+
+                    MsquicMetrics::add(MsquicMetrics::instance().largeBufferAllocations);
+
+                    Block* block = static_cast<Block*>(::operator new(sizeof(Block) + size));
+
+                    block->owner = nullptr;
+
+                    block->sizeClass = LARGE_CLASS;
+
+                    return block->data();
+                }
+
+                return localShard().allocate(sizeClass)->data();
+            }
+
+            static void release(unsigned char* data) {
+
+                if (!data) {
+                    return;
+                }
+
+                Block* block = Block::fromData(data);
+
+                if (block->sizeClass == LARGE_CLASS) {
+                    ::operator delete(block);
+                    return;
+                }
+
+                if (block->owner == currentShard()) {
+                    block->owner->freeLocal(block);
+                }
+                else {
+                    block->owner->freeRemote(block);
+                }
+            }
+
+            // 实际可用容量，不小于申请的大小
+            static size_t capacity(size_t size) {
+
+                uint32_t sizeClass = classOf(size);
+
+                return sizeClass == LARGE_CLASS ? size : SIZE_CLASSES[sizeClass];
+            }
+
+        private:
+
+            struct Shard;
+
+            // 16 字节块头，空闲时数据区的前 8 字节存链表指针
+            struct alignas(16) Block {
+
+                Shard* owner;
+
+                uint32_t sizeClass;
+
+                uint32_t reserved;
+
+                unsigned char* data() { return reinterpret_cast<unsigned char*>(this + 1); }
+
+                Block*& next() { return *reinterpret_cast<Block**>(data()); }
+
+                static Block* fromData(unsigned char* data) { return reinterpret_cast<Block*>(data) - 1; }
+
+            };
+
+            struct Shard {
+
+                Block* freeList[CLASS_COUNT] = {};
+
+                // 其他线程归还的块，只整体取走，不存在 ABA
+                alignas(64) std::atomic<Block*> remoteFree[CLASS_COUNT] = {};
+
+                Block* allocate(uint32_t sizeClass) {
+
+                    Block* block = freeList[sizeClass];
+
+                    if (!block) {
+                        block = remoteFree[sizeClass].exchange(nullptr, std::memory_order_acquire);
+                    }
+
+                    if (!block) {
+                        block = carve(sizeClass);
+                    }
+
+                    freeList[sizeClass] = block->next();
+
+                    return block;
+                }
+
+                void freeLocal(Block* block) {
+
+                    block->next() = freeList[block->sizeClass];
+
+                    freeList[block->sizeClass] = block;
+                }
+
+                void freeRemote(Block* block) {
+
+                    std::atomic<Block*>& head = remoteFree[block->sizeClass];
+
+                    Block* expected = head.load(std::memory_order_relaxed);
+
+                    do {
+                        block->next() = expected;
+                    } while (!head.compare_exchange_weak(expected, block, std::memory_order_release, std::memory_order_relaxed));
+                }
+
+                // 新 slab 切块并串成链表，slab 在进程生命周期内复用，不归还系统
+                Block* carve(uint32_t sizeClass) {
+
+                    MsquicMetrics::add(MsquicMetrics::instance().bufferSlabs);
+
+                    size_t stride = sizeof(Block) + SIZE_CLASSES[sizeClass];
+
+                    size_t count = SLAB_BYTES / stride > 0 ? SLAB_BYTES / stride : 1;
+
+                    unsigned char* slab = static_cast<unsigned char*>(::operator new(stride * count));
+
+                    Block* head = nullptr;
+
+                    for (size_t i = count; i-- > 0;) {
+
+                        Block* block = reinterpret_cast<Block*>(slab + i * stride);
+
+                        block->owner = this;
+
+                        block->sizeClass = sizeClass;
+
+                        block->next() = head;
+
+                        head = block;
+                    }
+
+                    return head;
+                }
+
+            };
+
+            static uint32_t classOf(size_t size) {
+
+                for (uint32_t i = 0; i < CLASS_COUNT; ++i) {
+                    if (size <= SIZE_CLASSES[i]) {
+                        return i;
+                    }
+                }
+
+                return LARGE_CLASS;
+            }
+
+            static Shard*& currentShard() {
+                thread_local Shard* shard = nullptr;
+                return shard;
+            }
+
+            // 分片随线程首次分配创建，线程退出后也不释放：别的线程可能还持有它的块
+            static Shard& localShard() {
+
+                Shard*& shard = currentShard();
+
+                if (!shard) {
+                    shard = new Shard();
+                }
+
+                return *shard;
+            }
+        };
+
+        // 从 MsquicBufferPool 取内存的 std 分配器，shared_ptr 控制块这类小对象借此复用 slab，可在任意线程释放
+        template<class T>
+        struct MsquicPoolAllocator {
+
+            static_assert(alignof(T) <= 16, "pool blocks are 16-byte aligned");
+
+            using value_type = T;
+
+            MsquicPoolAllocator() noexcept = default;
+
+            template<class U>
+            MsquicPoolAllocator(const MsquicPoolAllocator<U>&) noexcept {}
+
+            T* allocate(size_t n) {
+                return reinterpret_cast<T*>(MsquicBufferPool::allocate(n * sizeof(T)));
+            }
+
+            void deallocate(T* p, size_t) noexcept {
+                MsquicBufferPool::release(reinterpret_cast<unsigned char*>(p));
+            }
+
+            template<class U>
+            bool operator==(const MsquicPoolAllocator<U>&) const noexcept { return true; }
+
+            template<class U>
+            bool operator!=(const MsquicPoolAllocator<U>&) const noexcept { return false; }
+        };
+    }
+}
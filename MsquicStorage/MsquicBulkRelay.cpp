@@ -0,0 +1,403 @@
+#include "MsquicBulkRelay.h"
+#include "MsquicSocket.h"
+
+#include "MsQuicApi.h"
+#include "MsquicMetrics.h"
+#include "MsquicSharedBuffer.h"
+
+#include "Utils.h"
+
+namespace hope {
+
+    namespace quic {
+
+        MsquicBulkRelay::MsquicBulkRelay(std::weak_ptr<MsquicSocket> source, HQUIC sourceStream)
+            : source(std::move(source))
+        {
+            sourceState.handle = sourceStream;
+        }
+
+        MsquicBulkRelay::~MsquicBulkRelay()
+        {
+            LOG_INFO("Bulk transfer to %s finished: %llu bytes relayed", std::string(getTargetId()).c_str(), static_cast<unsigned long long>(relayedBytes));
+        }
+
+        void MsquicBulkRelay::start()
+        {
+            self = shared_from_this();
+
+            MsQuic->SetCallbackHandler(sourceState.handle, MsquicBulkSourceHandle, this);
+        }
+
+        std::string_view MsquicBulkRelay::getTargetId() const
+        {
+            if (!headerParsed) {
+                return {};
+            }
+
+            return std::string_view(reinterpret_cast<const char*>(header.data() + DATAGRAM_HEADER_SIZE), header[1]);
+        }
+
+        bool MsquicBulkRelay::attach(MsquicSocket& target, std::string_view sourceId)
+        {
+            // 占住源流，开目标流期间源流不会被关闭，自持有的引用也不会释放
+            HQUIC sourceStream = acquireStream(sourceState);
+
+            if (!sourceStream) {
+                return false;
+            }
+
+            HQUIC targetStream = target.openBulkStream(MsquicBulkTargetHandle, this);
+
+            if (!targetStream) {
+                releaseStream(sourceState);
+                return false;
+            }
+
+            bool finished = false;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                targetState.handle = targetStream;
+
+                finished = sourceFinished;
+            }
+
+            // 流头改写为源 ID，缓冲区作为 ClientContext 在 SEND_COMPLETE 时归还
+            sourceId = sourceId.substr(0, UINT8_MAX);
+
+            unsigned char* targetHeader = hope::utils::MsquicSharedBuffer::allocateRaw(DATAGRAM_HEADER_SIZE + sourceId.size());
+
+            targetHeaderBuffer = QUIC_BUFFER{ static_cast<uint32_t>(encodeDatagramHeader(targetHeader, sourceId)), targetHeader };
+
+            if (QUIC_FAILED(MsQuic->StreamSend(targetStream, &targetHeaderBuffer, 1, QUIC_SEND_FLAG_NONE, targetHeader))) {
+
+                hope::utils::MsquicSharedBuffer::release(targetHeader);
+
+                releaseStream(sourceState);
+
+                return false;
+            }
+
+            // 没有负载的传输在路由完成前就已经结束
+            if (finished) {
+                MsQuic->StreamShutdown(targetStream, QUIC_STREAM_SHUTDOWN_FLAG_GRACEFUL, 0);
+            }
+            else {
+                MsQuic->StreamReceiveSetEnabled(sourceStream, true);
+            }
+
+            releaseStream(sourceState);
+
+            return true;
+        }
+
+        void MsquicBulkRelay::abort(uint64_t errorCode)
+        {
+            if (HQUIC stream = acquireStream(sourceState)) {
+
+                MsQuic->StreamShutdown(stream, QUIC_STREAM_SHUTDOWN_FLAG_ABORT_RECEIVE, errorCode);
+
+                releaseStream(sourceState);
+            }
+
+            if (HQUIC stream = acquireStream(targetState)) {
+
+                MsQuic->StreamShutdown(stream, QUIC_STREAM_SHUTDOWN_FLAG_ABORT_SEND, errorCode);
+
+                releaseStream(targetState);
+            }
+        }
+
+        HQUIC MsquicBulkRelay::acquireStream(StreamState& state)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (!state.handle || state.shutdown) {
+                return nullptr;
+            }
+
+            ++state.users;
+
+            return state.handle;
+        }
+
+        void MsquicBulkRelay::releaseStream(StreamState& state)
+        {
+            HQUIC closing = nullptr;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                if (--state.users == 0 && state.shutdown) {
+                    closing = std::exchange(state.handle, nullptr);
+                }
+            }
+
+            // msquic 调用都在锁外，两个连接可能在同一个工作线程上内联回调
+            if (closing) {
+                MsQuic->StreamClose(closing);
+            }
+
+            finishIfClosed();
+        }
+
+        void MsquicBulkRelay::onShutdownComplete(StreamState& state)
+        {
+            HQUIC closing = nullptr;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                state.shutdown = true;
+
+                if (state.users == 0) {
+                    closing = std::exchange(state.handle, nullptr);
+                }
+            }
+
+            if (closing) {
+                MsQuic->StreamClose(closing);
+            }
+
+            finishIfClosed();
+        }
+
+        void MsquicBulkRelay::finishIfClosed()
+        {
+            std::shared_ptr<MsquicBulkRelay> last;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                if (!sourceState.handle && !targetState.handle) {
+                    last = std::move(self);
+                }
+            }
+        }
+
+        QUIC_STATUS MsquicBulkRelay::receiveHeader(QUIC_STREAM_EVENT* event)
+        {
+            auto* rev = &event->RECEIVE;
+
+            size_t before = headerLength;
+
+            for (uint32_t i = 0; i < rev->BufferCount && headerLength < header.size(); ++i) {
+
+                size_t take = std::min<size_t>(rev->Buffers[i].Length, header.size() - headerLength);
+
+                memcpy(header.data() + headerLength, rev->Buffers[i].Buffer, take);
+
+                headerLength += take;
+            }
+
+            int64_t headerSize = bulkHeaderSize(header.data(), headerLength);
+
+            if (headerSize < 0) {
+
+                LOG_WARNING("Bulk transfer header invalid, abort");
+
+                MsQuic->StreamShutdown(sourceState.handle, QUIC_STREAM_SHUTDOWN_FLAG_ABORT_RECEIVE, BULK_ERROR_INVALID_HEADER);
+
+                return QUIC_STATUS_SUCCESS;
+            }
+
+            // 流头还没收齐，本次数据全部拷走
+            if (headerSize == 0) {
+                return QUIC_STATUS_SUCCESS;
+            }
+
+            // 只消费流头部分，负载留在 msquic 里，目标流建好后再恢复接收
+            rev->TotalBufferLength = static_cast<uint64_t>(headerSize) - before;
+
+            headerLength = static_cast<size_t>(headerSize);
+
+            headerParsed = true;
+
+            MsQuic->StreamReceiveSetEnabled(sourceState.handle, false);
+
+            std::shared_ptr<MsquicSocket> socket = source.lock();
+
+            if (!socket) {
+
+                MsQuic->StreamShutdown(sourceState.handle, QUIC_STREAM_SHUTDOWN_FLAG_ABORT_RECEIVE, BULK_ERROR_ABORTED);
+
+                return QUIC_STATUS_SUCCESS;
+            }
+
+            socket->requestBulkRoute(shared_from_this(), getTargetId());
+
+            return QUIC_STATUS_SUCCESS;
+        }
+
+        QUIC_STATUS MsquicBulkRelay::onSourceReceive(QUIC_STREAM_EVENT* event)
+        {
+            if (!headerParsed) {
+                return receiveHeader(event);
+            }
+
+            auto* rev = &event->RECEIVE;
+
+            if (rev->TotalBufferLength == 0) {
+                return QUIC_STATUS_SUCCESS;
+            }
+
+            HQUIC targetStream = acquireStream(targetState);
+
+            if (!targetStream) {
+
+                MsQuic->StreamShutdown(sourceState.handle, QUIC_STREAM_SHUTDOWN_FLAG_ABORT_RECEIVE, BULK_ERROR_ABORTED);
+
+                return QUIC_STATUS_SUCCESS;
+            }
+
+            // 源流句柄一直占到目标 SEND_COMPLETE，届时还要 StreamReceiveComplete
+            acquireStream(sourceState);
+
+            inflight.assign(rev->Buffers, rev->Buffers + rev->BufferCount);
+
+            inflightLength = rev->TotalBufferLength;
+
+            QUIC_STATUS status = MsQuic->StreamSend(targetStream, inflight.data(), static_cast<uint32_t>(inflight.size()), QUIC_SEND_FLAG_NONE, this);
+
+            releaseStream(targetState);
+
+            if (QUIC_FAILED(status)) {
+
+                releaseStream(sourceState);
+
+                MsQuic->StreamShutdown(sourceState.handle, QUIC_STREAM_SHUTDOWN_FLAG_ABORT_RECEIVE, BULK_ERROR_ABORTED);
+
+                return QUIC_STATUS_SUCCESS;
+            }
+
+            // 缓冲区借给目标流，msquic 在 StreamReceiveComplete 之前不会再投递该流的数据
+            return QUIC_STATUS_PENDING;
+        }
+
+        void MsquicBulkRelay::onSourceFinished()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                sourceFinished = true;
+            }
+
+            // 所有数据都已完成接收才会有 PEER_SEND_SHUTDOWN，此时没有在途的块
+            if (HQUIC stream = acquireStream(targetState)) {
+
+                MsQuic->StreamShutdown(stream, QUIC_STREAM_SHUTDOWN_FLAG_GRACEFUL, 0);
+
+                releaseStream(targetState);
+            }
+        }
+
+        void MsquicBulkRelay::onTargetSendComplete(void* clientContext, bool canceled)
+        {
+            // 流头
+            if (clientContext != this) {
+                hope::utils::MsquicSharedBuffer::release(static_cast<unsigned char*>(clientContext));
+                return;
+            }
+
+            uint64_t length = std::exchange(inflightLength, 0);
+
+            // 接收时已占住，这里句柄一定有效
+            HQUIC sourceStream = sourceState.handle;
+
+            if (canceled) {
+                MsQuic->StreamShutdown(sourceStream, QUIC_STREAM_SHUTDOWN_FLAG_ABORT_RECEIVE, BULK_ERROR_ABORTED);
+            }
+            else {
+
+                relayedBytes += length;
+
+                hope::utils::MsquicMetrics::add(hope::utils::MsquicMetrics::instance().bulkBytesRelayed, length);
+
+                MsQuic->StreamReceiveComplete(sourceStream, length);
+            }
+
+            releaseStream(sourceState);
+        }
+
+        // 源流：发送方开的单向流
+        QUIC_STATUS QUIC_API MsquicBulkSourceHandle(HQUIC stream, void* context, QUIC_STREAM_EVENT* event)
+        {
+            MsquicBulkRelay* relay = static_cast<MsquicBulkRelay*>(context);
+
+            if (relay == nullptr || event == nullptr) {
+                return QUIC_STATUS_INVALID_PARAMETER;
+            }
+
+            switch (event->Type) {
+
+            case QUIC_STREAM_EVENT_RECEIVE:
+            {
+                return relay->onSourceReceive(event);
+            }
+
+            case QUIC_STREAM_EVENT_PEER_SEND_SHUTDOWN:
+            {
+                relay->onSourceFinished();
+                break;
+            }
+
+            case QUIC_STREAM_EVENT_PEER_SEND_ABORTED:
+            {
+                relay->abort(event->PEER_SEND_ABORTED.ErrorCode);
+                break;
+            }
+
+            case QUIC_STREAM_EVENT_SHUTDOWN_COMPLETE:
+            {
+                relay->onShutdownComplete(relay->sourceState);
+                break;
+            }
+
+            default:
+                break;
+            }
+
+            return QUIC_STATUS_SUCCESS;
+        }
+
+        // 目标流：服务端在目标连接上开的单向流
+        QUIC_STATUS QUIC_API MsquicBulkTargetHandle(HQUIC stream, void* context, QUIC_STREAM_EVENT* event)
+        {
+            MsquicBulkRelay* relay = static_cast<MsquicBulkRelay*>(context);
+
+            if (relay == nullptr || event == nullptr) {
+                return QUIC_STATUS_INVALID_PARAMETER;
+            }
+
+            switch (event->Type) {
+
+            case QUIC_STREAM_EVENT_SEND_COMPLETE:
+            {
+                relay->onTargetSendComplete(event->SEND_COMPLETE.ClientContext, event->SEND_COMPLETE.Canceled);
+                break;
+            }
+
+            case QUIC_STREAM_EVENT_PEER_RECEIVE_ABORTED:
+            {
+                relay->abort(event->PEER_RECEIVE_ABORTED.ErrorCode);
+                break;
+            }
+
+            case QUIC_STREAM_EVENT_SHUTDOWN_COMPLETE:
+            {
+                relay->onShutdownComplete(relay->targetState);
+                break;
+            }
+
+            default:
+                break;
+            }
+
+            return QUIC_STATUS_SUCCESS;
+        }
+
+    }
+
+}
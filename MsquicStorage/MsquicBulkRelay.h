@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <msquic.hpp>
+
+#include "MsquicProtocol.h"
+
+namespace hope {
+
+	namespace quic {
+
+		class MsquicSocket;
+
+		// 一次批量传输的中转：源流是发送方开的单向流，目标流是服务端在目标连接上开的单向流
+		// 源流收到的缓冲区原样交给目标流 StreamSend，目标 SEND_COMPLETE 之后才 StreamReceiveComplete，
+		// 同一时刻只有一块数据在途，内存占用与负载大小无关；目标发得慢时源流不再归还流控窗口，发送方自然被限速
+		class MsquicBulkRelay : public std::enable_shared_from_this<MsquicBulkRelay> {
+
+			friend QUIC_STATUS QUIC_API MsquicBulkSourceHandle(HQUIC stream, void* context, QUIC_STREAM_EVENT* event);
+
+			friend QUIC_STATUS QUIC_API MsquicBulkTargetHandle(HQUIC stream, void* context, QUIC_STREAM_EVENT* event);
+
+		public:
+
+			MsquicBulkRelay(std::weak_ptr<MsquicSocket> source, HQUIC sourceStream);
+
+			~MsquicBulkRelay();
+
+			MsquicBulkRelay(const MsquicBulkRelay&) = delete;
+
+			MsquicBulkRelay& operator=(const MsquicBulkRelay&) = delete;
+
+			// 接管源流的回调，之后两条流都关闭时释放自己
+			void start();
+
+			// 在目标所在的逻辑线程调用：开目标流并写入带源 ID 的流头，然后恢复源流接收
+			bool attach(MsquicSocket& target, std::string_view sourceId);
+
+			// 路由失败或任一端中止时，两条流都带 errorCode 中止
+			void abort(uint64_t errorCode);
+
+			std::string_view getTargetId() const;
+
+		private:
+
+			// 流句柄及其使用者计数：SHUTDOWN_COMPLETE 之后等没有线程再使用句柄才 StreamClose
+			struct StreamState {
+
+				HQUIC handle = nullptr;
+
+				int users = 0;
+
+				bool shutdown = false;
+
+			};
+
+			// 流已关闭或正在关闭时返回 nullptr，否则占用句柄直到 releaseStream
+			HQUIC acquireStream(StreamState& state);
+
+			void releaseStream(StreamState& state);
+
+			void onShutdownComplete(StreamState& state);
+
+			// 两条流都已关闭时释放自持有的引用
+			void finishIfClosed();
+
+			QUIC_STATUS onSourceReceive(QUIC_STREAM_EVENT* event);
+
+			// 流头还没收齐时把数据拷进 header，收齐后暂停接收并请求路由
+			QUIC_STATUS receiveHeader(QUIC_STREAM_EVENT* event);
+
+			void onSourceFinished();
+
+			void onTargetSendComplete(void* clientContext, bool canceled);
+
+			std::mutex mutex;
+
+			std::weak_ptr<MsquicSocket> source;
+
+			StreamState sourceState;
+
+			StreamState targetState;
+
+			// 发送方的流头，最长 DATAGRAM_HEADER_SIZE + 255
+			std::array<unsigned char, DATAGRAM_HEADER_SIZE + UINT8_MAX> header{};
+
+			size_t headerLength = 0;
+
+			bool headerParsed = false;
+
+			// 发送方已发完（PEER_SEND_SHUTDOWN），目标流在途数据发完后正常结束
+			bool sourceFinished = false;
+
+			// 目标流头的描述符，msquic 在 SEND_COMPLETE 前引用
+			QUIC_BUFFER targetHeaderBuffer{};
+
+			// 正在交给目标流的那一块，描述符由 msquic 在 SEND_COMPLETE 前引用
+			std::vector<QUIC_BUFFER> inflight;
+
+			uint64_t inflightLength = 0;
+
+			uint64_t relayedBytes = 0;
+
+			std::shared_ptr<MsquicBulkRelay> self;
+
+		};
+
+		QUIC_STATUS QUIC_API MsquicBulkSourceHandle(HQUIC stream, void* context, QUIC_STREAM_EVENT* event);
+
+		QUIC_STATUS QUIC_API MsquicBulkTargetHandle(HQUIC stream, void* context, QUIC_STREAM_EVENT* event);
+
+	}
+
+}
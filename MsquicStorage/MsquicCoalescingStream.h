@@ -0,0 +1,517 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/beast/websocket.hpp>
+
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+#endif
+
+#include "MsquicFunction.h"
+#include "MsquicMetrics.h"
+
+namespace hope {
+
+	namespace quic {
+
+		// WebSocket 的下层流：beast 每条消息的 async_write_some 只拷进合并缓冲区并立即完成，
+		// 攒下的字节由一次 async_write 发出。数据帧、pong、close 都经过这里，
+		// 同一时刻只有一个 flush 在写 socket，帧之间不会交错
+		// cork 期间只攒不发，uncork 时发出整批
+		// Linux 上可开启 MSG_ZEROCOPY：整批超过阈值时内核直接引用合并缓冲区的页，
+		// 缓冲区留到错误队列报告完成才释放
+		// socket 和缓冲区都放在共享的 State 里，异步回调只持有 State，不引用流对象本身
+		template<class NextLayer>
+		class MsquicCoalescingStream {
+
+		public:
+
+			using next_layer_type = NextLayer;
+
+			using executor_type = typename NextLayer::executor_type;
+
+			// 积压超过该值后写入要等当前 flush 完成才返回，慢连接的反压传回 beast
+			static constexpr size_t HIGH_WATERMARK = 1024 * 1024;
+
+			// flush 完成后缓冲区超过该容量就释放，空闲连接不长期占着大块内存
+			static constexpr size_t RETAIN_CAPACITY = 64 * 1024;
+
+			template<class... Args>
+			explicit MsquicCoalescingStream(Args&&... args)
+				: state(std::make_shared<State>(std::forward<Args>(args)...)) {
+			}
+
+			// 未完成的回调还持有 State，这里关闭 socket 让它们以 operation_aborted 结束并释放 State
+			~MsquicCoalescingStream() {
+
+				boost::system::error_code ec;
+
+				state->nextLayer.close(ec);
+			}
+
+			MsquicCoalescingStream(const MsquicCoalescingStream&) = delete;
+
+			MsquicCoalescingStream& operator=(const MsquicCoalescingStream&) = delete;
+
+			executor_type get_executor() noexcept {
+
+				return state->nextLayer.get_executor();
+			}
+
+			NextLayer& next_layer() noexcept {
+
+				return state->nextLayer;
+			}
+
+			const NextLayer& next_layer() const noexcept {
+
+				return state->nextLayer;
+			}
+
+			// 打开 SO_ZEROCOPY，之后不小于 threshold 的批次走零拷贝发送；内核或平台不支持时返回 false
+			bool enableZeroCopy(size_t threshold) {
+
+#if defined(__linux__) && defined(SO_ZEROCOPY)
+				int on = 1;
+
+				if (setsockopt(state->nextLayer.native_handle(), SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on)) != 0) {
+					return false;
+				}
+
+				state->zeroCopyThreshold = threshold;
+
+				return true;
+#else
+				return false;
+#endif
+			}
+
+			void cork() {
+
+				state->corked = true;
+			}
+
+			void uncork() {
+
+				state->corked = false;
+
+				flush(state);
+			}
+
+			size_t bufferedBytes() const {
+
+				return state->pending.size() + state->inflight.size();
+			}
+
+			template<class MutableBufferSequence, class ReadToken>
+			auto async_read_some(const MutableBufferSequence& buffers, ReadToken&& token) {
+
+				return state->nextLayer.async_read_some(buffers, std::forward<ReadToken>(token));
+			}
+
+			template<class MutableBufferSequence>
+			size_t read_some(const MutableBufferSequence& buffers, boost::system::error_code& ec) {
+
+				return state->nextLayer.read_some(buffers, ec);
+			}
+
+			template<class MutableBufferSequence>
+			size_t read_some(const MutableBufferSequence& buffers) {
+
+				return state->nextLayer.read_some(buffers);
+			}
+
+			// 同步写只在关闭阶段出现（同步 close 帧），先写完积压再直接写
+			template<class ConstBufferSequence>
+			size_t write_some(const ConstBufferSequence& buffers, boost::system::error_code& ec) {
+
+				if (!state->flushing && !state->pending.empty()) {
+
+					boost::asio::write(state->nextLayer, boost::asio::buffer(state->pending), ec);
+
+					state->pending.clear();
+
+					if (ec) {
+						return 0;
+					}
+				}
+
+				return state->nextLayer.write_some(buffers, ec);
+			}
+
+			template<class ConstBufferSequence>
+			size_t write_some(const ConstBufferSequence& buffers) {
+
+				boost::system::error_code ec;
+
+				size_t written = write_some(buffers, ec);
+
+				if (ec) {
+					throw boost::system::system_error(ec);
+				}
+
+				return written;
+			}
+
+			template<class ConstBufferSequence, class WriteToken>
+			auto async_write_some(const ConstBufferSequence& buffers, WriteToken&& token) {
+
+				return boost::asio::async_initiate<WriteToken, void(boost::system::error_code, size_t)>(
+					[this](auto handler, const ConstBufferSequence& buffers) {
+
+						size_t size = boost::asio::buffer_size(buffers);
+
+						boost::system::error_code ec = state->error;
+
+						if (!ec) {
+
+							size_t offset = state->pending.size();
+
+							state->pending.resize(offset + size);
+
+							boost::asio::buffer_copy(boost::asio::buffer(state->pending.data() + offset, size), buffers);
+
+							flush(state);
+						}
+
+						auto executor = boost::asio::get_associated_executor(handler, get_executor());
+
+						auto complete = [handler = std::move(handler), executor, size](boost::system::error_code ec) mutable {
+							boost::asio::post(executor, [handler = std::move(handler), ec, size]() mutable {
+								handler(ec, ec ? 0 : size);
+								});
+							};
+
+						if (!ec && state->flushing && bufferedBytes() > HIGH_WATERMARK) {
+
+							state->waiters.emplace_back(std::move(complete));
+
+							return;
+						}
+
+						complete(ec);
+
+					}, token, buffers);
+			}
+
+		private:
+
+			// 已交给内核、等完成通知的零拷贝批次，覆盖 [firstId, firstId + count) 这些发送调用
+			struct ZeroCopyBatch {
+
+				std::vector<char> data;
+
+				uint32_t firstId = 0;
+
+				uint32_t count = 0;
+
+				uint32_t remaining = 0;
+
+			};
+
+			// 异步回调持有它，流析构后回调仍能安全收尾
+			struct State {
+
+				template<class... Args>
+				explicit State(Args&&... args)
+					: nextLayer(std::forward<Args>(args)...) {
+				}
+
+				NextLayer nextLayer;
+
+				std::vector<char> pending;
+
+				std::vector<char> inflight;
+
+				std::vector<hope::utils::MsquicFunction<void(boost::system::error_code), 256>> waiters;
+
+				boost::system::error_code error;
+
+				bool flushing = false;
+
+				bool corked = false;
+
+				// 内核按发送调用递增的零拷贝序号，下一次成功发送将使用的值
+				uint32_t zeroCopyNextId = 0;
+
+				// 本批第一次发送的序号
+				uint32_t zeroCopyBatchId = 0;
+
+				// 内核确认（ACK）后才会通知完成，积压量大致不超过发送缓冲区
+				std::deque<ZeroCopyBatch> zeroCopyHeld;
+
+				bool zeroCopyWatching = false;
+
+				// 0 表示不走零拷贝
+				size_t zeroCopyThreshold = 0;
+
+			};
+
+			static void flush(const std::shared_ptr<State>& state) {
+
+				if (state->flushing || state->corked || state->pending.empty() || state->error) {
+					return;
+				}
+
+				state->flushing = true;
+
+				std::swap(state->pending, state->inflight);
+
+#if defined(__linux__) && defined(SO_ZEROCOPY)
+				if (state->zeroCopyThreshold != 0 && state->inflight.size() >= state->zeroCopyThreshold) {
+
+					state->zeroCopyBatchId = state->zeroCopyNextId;
+
+					zeroCopyWrite(state, 0);
+
+					return;
+				}
+#endif
+
+				boost::asio::async_write(state->nextLayer, boost::asio::buffer(state->inflight),
+					[state](boost::system::error_code ec, size_t) {
+
+						completeFlush(*state, ec);
+
+						flush(state);
+					});
+			}
+
+			static void completeFlush(State& state, boost::system::error_code ec) {
+
+				state.flushing = false;
+
+				state.inflight.clear();
+
+				if (state.inflight.capacity() > RETAIN_CAPACITY) {
+					std::vector<char>().swap(state.inflight);
+				}
+
+				if (ec) {
+					state.error = ec;
+				}
+
+				auto waiters = std::move(state.waiters);
+
+				state.waiters.clear();
+
+				for (auto& waiter : waiters) {
+					waiter(ec);
+				}
+			}
+
+#if defined(__linux__) && defined(SO_ZEROCOPY)
+			// 从 offset 开始非阻塞发送本批剩余部分，发送缓冲区满时等可写再继续
+			static void zeroCopyWrite(const std::shared_ptr<State>& state, size_t offset) {
+
+				std::vector<char>& data = state->inflight;
+
+				while (offset < data.size()) {
+
+					ssize_t sent = ::send(state->nextLayer.native_handle(), data.data() + offset, data.size() - offset, MSG_ZEROCOPY | MSG_DONTWAIT | MSG_NOSIGNAL);
+
+					if (sent >= 0) {
+
+						// 每次成功的调用占用一个序号，完成通知按序号区间上报
+						++state->zeroCopyNextId;
+
+						offset += static_cast<size_t>(sent);
+
+						continue;
+					}
+
+					if (errno == EINTR) {
+						continue;
+					}
+
+					if (errno == EAGAIN || errno == EWOULDBLOCK) {
+
+						state->nextLayer.async_wait(NextLayer::wait_write, [state, offset](boost::system::error_code ec) {
+
+							if (ec) {
+								completeFlush(*state, ec);
+								return;
+							}
+
+							zeroCopyWrite(state, offset);
+						});
+
+						return;
+					}
+
+					// optmem 用完时内核拒绝锁页，剩余部分走普通拷贝
+					if (errno == ENOBUFS) {
+
+						boost::asio::async_write(state->nextLayer, boost::asio::buffer(data.data() + offset, data.size() - offset),
+							[state](boost::system::error_code ec, size_t) {
+
+								if (ec) {
+									completeFlush(*state, ec);
+									return;
+								}
+
+								finishZeroCopyBatch(state);
+							});
+
+						return;
+					}
+
+					completeFlush(*state, boost::system::error_code(errno, boost::system::system_category()));
+
+					return;
+				}
+
+				finishZeroCopyBatch(state);
+			}
+
+			// 本批发完：缓冲区转入等待列表，换一个新的 inflight 接着用
+			static void finishZeroCopyBatch(const std::shared_ptr<State>& state) {
+
+				uint32_t count = state->zeroCopyNextId - state->zeroCopyBatchId;
+
+				if (count != 0) {
+
+					hope::utils::MsquicMetrics::add(hope::utils::MsquicMetrics::instance().zeroCopyBytes, state->inflight.size());
+
+					state->zeroCopyHeld.push_back(ZeroCopyBatch{ std::move(state->inflight), state->zeroCopyBatchId, count, count });
+
+					state->inflight = std::vector<char>();
+
+					watchZeroCopy(state);
+				}
+
+				completeFlush(*state, {});
+
+				flush(state);
+			}
+
+			// 完成通知走套接字错误队列，epoll 以 EPOLLERR 报告
+			static void watchZeroCopy(const std::shared_ptr<State>& state) {
+
+				if (state->zeroCopyWatching || state->zeroCopyHeld.empty()) {
+					return;
+				}
+
+				state->zeroCopyWatching = true;
+
+				state->nextLayer.async_wait(NextLayer::wait_error, [state](boost::system::error_code ec) {
+
+					state->zeroCopyWatching = false;
+
+					// 连接关闭时等待中的批次随 State 一起释放
+					if (ec) {
+						return;
+					}
+
+					readZeroCopyCompletions(*state);
+
+					watchZeroCopy(state);
+				});
+			}
+
+			static void readZeroCopyCompletions(State& state) {
+
+				for (;;) {
+
+					char control[CMSG_SPACE(sizeof(sock_extended_err)) + CMSG_SPACE(sizeof(sockaddr_in6))];
+
+					msghdr message{};
+
+					message.msg_control = control;
+
+					message.msg_controllen = sizeof(control);
+
+					if (::recvmsg(state.nextLayer.native_handle(), &message, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+						return;
+					}
+
+					for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header)) {
+
+						bool recvErr = (header->cmsg_level == SOL_IP && header->cmsg_type == IP_RECVERR)
+							|| (header->cmsg_level == SOL_IPV6 && header->cmsg_type == IPV6_RECVERR);
+
+						if (!recvErr) {
+							continue;
+						}
+
+						const sock_extended_err* error = reinterpret_cast<const sock_extended_err*>(CMSG_DATA(header));
+
+						if (error->ee_errno != 0 || error->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+							continue;
+						}
+
+						// 内核退化为拷贝（例如回环或网卡不支持分散聚集），数据照常发出，只计数
+						if (error->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+							hope::utils::MsquicMetrics::add(hope::utils::MsquicMetrics::instance().zeroCopyCopied, error->ee_data - error->ee_info + 1);
+						}
+
+						releaseZeroCopy(state, error->ee_info, error->ee_data);
+					}
+				}
+			}
+
+			// 通知覆盖序号区间 [first, last]，序号会回绕，统一换算成相对最早批次的偏移
+			static void releaseZeroCopy(State& state, uint32_t first, uint32_t last) {
+
+				if (state.zeroCopyHeld.empty()) {
+					return;
+				}
+
+				uint32_t base = state.zeroCopyHeld.front().firstId;
+
+				uint64_t from = static_cast<uint32_t>(first - base);
+
+				uint64_t to = static_cast<uint64_t>(static_cast<uint32_t>(last - base)) + 1;
+
+				for (ZeroCopyBatch& batch : state.zeroCopyHeld) {
+
+					uint64_t begin = static_cast<uint32_t>(batch.firstId - base);
+
+					uint64_t end = begin + batch.count;
+
+					uint64_t overlapBegin = std::max(begin, from);
+
+					uint64_t overlapEnd = std::min(end, to);
+
+					if (overlapBegin < overlapEnd) {
+						batch.remaining -= static_cast<uint32_t>(overlapEnd - overlapBegin);
+					}
+				}
+
+				std::erase_if(state.zeroCopyHeld, [](const ZeroCopyBatch& batch) { return batch.remaining == 0; });
+			}
+#endif
+
+			std::shared_ptr<State> state;
+
+		};
+
+		// beast 关闭 WebSocket 时通过 ADL 找到的拆除函数，转给下层 socket
+		template<class NextLayer>
+		void teardown(boost::beast::role_type role, MsquicCoalescingStream<NextLayer>& stream, boost::system::error_code& ec) {
+
+			using boost::beast::websocket::teardown;
+
+			teardown(role, stream.next_layer(), ec);
+		}
+
+		template<class NextLayer, class TeardownHandler>
+		void async_teardown(boost::beast::role_type role, MsquicCoalescingStream<NextLayer>& stream, TeardownHandler&& handler) {
+
+			using boost::beast::websocket::async_teardown;
+
+			async_teardown(role, stream.next_layer(), std::forward<TeardownHandler>(handler));
+		}
+
+	}
+
+}
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include <zstd.h>
+#include <lz4.h>
+
+#include "MsquicProtocol.h"
+
+namespace hope {
+
+	namespace quic {
+
+		enum class CompressionAlgorithm {
+
+			None = 0,
+
+			Zstd = 1,   // 压缩率高，可配合信令样本训练出的字典（zstd --train）
+
+			Lz4 = 2,    // CPU 开销低，适合高负载节点
+
+		};
+
+		// 二进制帧负载压缩，flags 标记算法，压缩后的负载为 originalSize:u32 + 压缩数据
+		// 启动时由 MsquicServer::initialize 配置一次，之后只读；压缩上下文每线程一份
+		class MsquicCompression {
+
+		public:
+
+			static constexpr size_t SIZE_PREFIX = sizeof(uint32_t);
+
+			static MsquicCompression& instance() {
+
+				static MsquicCompression compression;
+
+				return compression;
+			}
+
+			~MsquicCompression() {
+
+				ZSTD_freeCDict(compressDictionary);
+
+				ZSTD_freeDDict(decompressDictionary);
+			}
+
+			static CompressionAlgorithm algorithmFromName(std::string_view name) {
+
+				if (name == "zstd") return CompressionAlgorithm::Zstd;
+
+				if (name == "lz4") return CompressionAlgorithm::Lz4;
+
+				return CompressionAlgorithm::None;
+			}
+
+			// 字典加载失败时退化为无字典 zstd，返回 false 由调用方打日志
+			bool configure(CompressionAlgorithm algorithm, size_t threshold, int level, const std::string& dictionaryPath) {
+
+				this->algorithm = algorithm;
+
+				this->threshold = threshold;
+
+				this->level = level;
+
+				if (algorithm != CompressionAlgorithm::Zstd || dictionaryPath.empty()) {
+					return true;
+				}
+
+				std::ifstream file(dictionaryPath, std::ios::binary);
+
+				std::vector<char> dictionary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+				if (dictionary.empty()) {
+					return false;
+				}
+
+				compressDictionary = ZSTD_createCDict(dictionary.data(), dictionary.size(), level);
+
+				decompressDictionary = ZSTD_createDDict(dictionary.data(), dictionary.size());
+
+				return compressDictionary && decompressDictionary;
+			}
+
+			// 低于阈值或未启用时不压缩
+			bool shouldCompress(size_t size) const {
+
+				return algorithm != CompressionAlgorithm::None && size >= threshold;
+			}
+
+			// 压缩输出的最大长度（含长度前缀）
+			size_t compressBound(size_t size) const {
+
+				if (algorithm == CompressionAlgorithm::Lz4) {
+					return SIZE_PREFIX + static_cast<size_t>(LZ4_compressBound(static_cast<int>(size)));
+				}
+
+				return SIZE_PREFIX + ZSTD_compressBound(size);
+			}
+
+			// out 至少有 compressBound(input.size()) 字节，返回写入长度；失败或没有变小返回 0，调用方按原文发送
+			size_t compress(std::string_view input, unsigned char* out, uint8_t& flags) const {
+
+				size_t written = 0;
+
+				char* dst = reinterpret_cast<char*>(out + SIZE_PREFIX);
+
+				size_t capacity = compressBound(input.size()) - SIZE_PREFIX;
+
+				if (algorithm == CompressionAlgorithm::Lz4) {
+
+					int result = LZ4_compress_default(input.data(), dst, static_cast<int>(input.size()), static_cast<int>(capacity));
+
+					written = result > 0 ? static_cast<size_t>(result) : 0;
+
+				}
+				else if (algorithm == CompressionAlgorithm::Zstd) {
+
+					ZSTD_CCtx* context = compressContext();
+
+					size_t result = compressDictionary
+						? ZSTD_compress_usingCDict(context, dst, capacity, input.data(), input.size(), compressDictionary)
+						: ZSTD_compressCCtx(context, dst, capacity, input.data(), input.size(), level);
+
+					written = ZSTD_isError(result) ? 0 : result;
+
+				}
+
+				if (written == 0 || SIZE_PREFIX + written >= input.size()) {
+					return 0;
+				}
+
+				storeLittleEndian32(out, static_cast<uint32_t>(input.size()));
+
+				flags |= algorithm == CompressionAlgorithm::Lz4 ? BINARY_FLAG_LZ4 : BINARY_FLAG_ZSTD;
+
+				return SIZE_PREFIX + written;
+			}
+
+			// 压缩负载声明的原始长度，不足长度前缀返回 0；解压前用它预先计入内存预算
+			static size_t originalSize(std::string_view input) {
+
+				if (input.size() < SIZE_PREFIX) {
+					return 0;
+				}
+
+				return loadLittleEndian32(reinterpret_cast<const unsigned char*>(input.data()));
+			}
+
+			// 按 flags 解压到 out，原始长度超过 maxSize 视为非法
+			bool decompress(uint8_t flags, std::string_view input, std::string& out, size_t maxSize) const {
+
+				if (input.size() < SIZE_PREFIX) {
+					return false;
+				}
+
+				size_t originalSize = loadLittleEndian32(reinterpret_cast<const unsigned char*>(input.data()));
+
+				if (originalSize > maxSize) {
+					return false;
+				}
+
+				const char* src = input.data() + SIZE_PREFIX;
+
+				size_t srcSize = input.size() - SIZE_PREFIX;
+
+				out.resize(originalSize);
+
+				if (flags & BINARY_FLAG_LZ4) {
+
+					int result = LZ4_decompress_safe(src, out.data(), static_cast<int>(srcSize), static_cast<int>(originalSize));
+
+					return result >= 0 && static_cast<size_t>(result) == originalSize;
+				}
+
+				if (flags & BINARY_FLAG_ZSTD) {
+
+					ZSTD_DCtx* context = decompressContext();
+
+					size_t result = decompressDictionary
+						? ZSTD_decompress_usingDDict(context, out.data(), originalSize, src, srcSize, decompressDictionary)
+						: ZSTD_decompressDCtx(context, out.data(), originalSize, src, srcSize);
+
+					return !ZSTD_isError(result) && result == originalSize;
+				}
+
+				return false;
+			}
+
+		private:
+
+			MsquicCompression() = default;
+
+			// 上下文按线程复用，字典可在多个上下文间共享
+			struct ThreadContexts {
+
+				ZSTD_CCtx* compress = nullptr;
+
+				ZSTD_DCtx* decompress = nullptr;
+
+				~ThreadContexts() {
+
+					ZSTD_freeCCtx(compress);
+
+					ZSTD_freeDCtx(decompress);
+				}
+
+			};
+
+			static ThreadContexts& threadContexts() {
+
+				thread_local ThreadContexts contexts;
+
+				return contexts;
+			}
+
+			static ZSTD_CCtx* compressContext() {
+
+				ThreadContexts& contexts = threadContexts();
+
+				if (!contexts.compress) {
+					contexts.compress = ZSTD_createCCtx();
+				}
+
+				return contexts.compress;
+			}
+
+			static ZSTD_DCtx* decompressContext() {
+
+				ThreadContexts& contexts = threadContexts();
+
+				if (!contexts.decompress) {
+					contexts.decompress = ZSTD_createDCtx();
+				}
+
+				return contexts.decompress;
+			}
+
+			CompressionAlgorithm algorithm = CompressionAlgorithm::None;
+
+			size_t threshold = 1024;
+
+			int level = 3;
+
+			ZSTD_CDict* compressDictionary = nullptr;
+
+			ZSTD_DDict* decompressDictionary = nullptr;
+
+		};
+
+	}
+
+}
@@ -1,17 +1,275 @@
-#include "MsquicData.h"
-
-#include "MsquicSocketInterface.h"
-#include "MsquicManager.h"
-
-namespace hope {
-	namespace quic {
-
-		MsquicData::MsquicData(boost::json::object json, std::shared_ptr<MsquicSocketInterface> msquicSocketInterface, MsquicManager* msquicManager)
-			: json(json)
-			, msquicSocketInterface(msquicSocketInterface)
-			, msquicManager(msquicManager) {
-
-		}
-
-	}
+
+#include "MsquicData.h"
+
+#include "MsquicSocketInterface.h"
+#include "MsquicManager.h"
+#include "MsquicCompression.h"
+#include "MsquicBufferPool.h"
+#include "MsquicMetrics.h"
+
+#include "Utils.h"
+
+#include <boost/json/basic_parser_impl.hpp>
+
+namespace hope {
+	namespace quic {
+
+		MsquicData::MsquicData()
+			: arena(arenaBuffer, sizeof(arenaBuffer))
+			, json(boost::json::storage_ptr(&arena)) {
+
+		}
+
+		void MsquicData::loadBinary(const BinaryFrame& frame)
+		{
+			protocol = WireProtocol::Binary;
+
+			requestType = frame.header.requestType;
+
+			accountId.assign(frame.sourceId.data(), frame.sourceId.size());
+
+			targetId.assign(frame.targetId.data(), frame.targetId.size());
+
+			compressionFlags = frame.header.flags & BINARY_FLAG_COMPRESSED;
+
+			payload.assign(frame.payload.data(), frame.payload.size());
+		}
+
+		bool MsquicData::inflate()
+		{
+			if (!compressionFlags) {
+				return true;
+			}
+
+			std::string inflated;
+
+			if (!MsquicCompression::instance().decompress(compressionFlags, payload, inflated, MsquicCompression::originalSize(payload))) {
+				return false;
+			}
+
+			payload.swap(inflated);
+
+			compressionFlags = 0;
+
+			return true;
+		}
+
+		void MsquicData::loadDatagram(std::string_view targetId, std::string_view datagramPayload)
+		{
+			protocol = WireProtocol::Binary;
+
+			requestType = DATAGRAM_REQUEST_TYPE;
+
+			this->targetId.assign(targetId.data(), targetId.size());
+
+			payload.assign(datagramPayload.data(), datagramPayload.size());
+		}
+
+		void MsquicData::loadBulk(std::string_view targetId, std::shared_ptr<MsquicBulkRelay> relay)
+		{
+			protocol = WireProtocol::Binary;
+
+			requestType = BULK_REQUEST_TYPE;
+
+			this->targetId.assign(targetId.data(), targetId.size());
+
+			bulkRelay = std::move(relay);
+		}
+
+		bool MsquicData::loadJson(std::string_view jsonStr, boost::json::error_code& ec)
+		{
+			protocol = WireProtocol::Json;
+
+			// 先拷贝并原地清洗，路由字段和后续转发看到的都是清洗后的文本
+			payload.assign(jsonStr.data(), jsonStr.size());
+
+			scrubJsonInPlace(payload.data(), payload.size());
+
+			// 转发时由服务端填写的字段
+			static constexpr std::string_view FORWARD_FIELDS[] = { "state", "message" };
+
+			boost::json::basic_parser<JsonStructHandler<MsquicRoute>> parser(boost::json::parse_options(), static_cast<MsquicRoute&>(*this));
+
+			parser.handler().watchKeys(FORWARD_FIELDS, std::size(FORWARD_FIELDS));
+
+			size_t consumed = parser.write_some(false, payload.data(), payload.size(), ec);
+
+			if (ec) {
+				return false;
+			}
+
+			// write_some 在文档结束处停下，后面的内容不会报错
+			if (consumed != payload.size()) {
+				ec = boost::json::error::extra_data;
+				return false;
+			}
+
+			if (!parser.handler().seenField("requestType")) {
+				ec = boost::json::error::not_int64;
+				return false;
+			}
+
+			memberCount = parser.handler().memberCount;
+
+			hasForwardFields = parser.handler().watchedKeySeen;
+
+			// 顶层一定是对象且之后只有空白，最后一个非空白字符就是它的右括号
+			jsonEnd = payload.find_last_not_of(" \t\r\n");
+
+			return true;
+		}
+
+		boost::json::object& MsquicData::getJson()
+		{
+			if (!jsonParsed) {
+
+				// 与 json 同一个 storage，赋值是移动而不是拷贝
+				json = boost::json::parse(payload, json.storage());
+
+				jsonParsed = true;
+
+			}
+
+			return json.as_object();
+		}
+
+		boost::json::storage_ptr MsquicData::getStorage()
+		{
+			return json.storage();
+		}
+
+		void MsquicData::chargeMemory(hope::utils::MsquicMemoryBudget* budget, size_t bytes)
+		{
+			memoryBudget = budget;
+
+			chargedBytes = bytes;
+		}
+
+		void MsquicData::reset()
+		{
+			// 先归还预算，再放开对会话的引用
+			if (memoryBudget) {
+
+				memoryBudget->release(chargedBytes);
+
+				memoryBudget = nullptr;
+
+				chargedBytes = 0;
+			}
+
+			msquicSocketInterface.reset();
+
+			msquicManager = nullptr;
+
+			protocol = WireProtocol::Json;
+
+			requestType = -1;
+
+			accountId.clear();
+
+			targetId.clear();
+
+			memberCount = 0;
+
+			jsonEnd = 0;
+
+			hasForwardFields = false;
+
+			compressionFlags = 0;
+
+			bulkRelay.reset();
+
+			if (payload.capacity() > PAYLOAD_RETAIN_CAPACITY) {
+				std::string().swap(payload);
+			}
+			else {
+				payload.clear();
+			}
+
+			// monotonic_resource 的释放是空操作，先丢掉 DOM 再整体归还 arena
+			json.emplace_null();
+
+			arena.release();
+
+			jsonParsed = false;
+		}
+
+		MsquicDataPool::~MsquicDataPool()
+		{
+			for (size_t i = 0; i < cachedCount; ++i) {
+
+				delete freeList[i];
+
+			}
+		}
+
+		std::shared_ptr<MsquicData> MsquicDataPool::acquire(std::shared_ptr<MsquicSocketInterface> msquicSocketInterface, MsquicManager* msquicManager)
+		{
+			MsquicData* data = nullptr;
+
+			lock();
+
+			if (cachedCount > 0) {
+
+				data = freeList[--cachedCount];
+
+			}
+
+			unlock();
+
+			if (!data) {
+
+				hope::utils::MsquicMetrics::add(hope::utils::MsquicMetrics::instance().poolHeapAllocations);
+
+				data = new MsquicData();
+
+			}
+
+			data->msquicSocketInterface = std::move(msquicSocketInterface);
+
+			data->msquicManager = msquicManager;
+
+			// 删除器持有连接池，连接先于消息销毁时也能安全回收；控制块来自 MsquicBufferPool，不走堆
+			return std::shared_ptr<MsquicData>(data, [pool = shared_from_this()](MsquicData* data) {
+
+				pool->release(data);
+
+				}, hope::utils::MsquicPoolAllocator<MsquicData>());
+		}
+
+		void MsquicDataPool::release(MsquicData* data)
+		{
+			data->reset();
+
+			lock();
+
+			if (cachedCount < MAX_CACHED) {
+
+				freeList[cachedCount++] = data;
+
+				data = nullptr;
+
+			}
+
+			unlock();
+
+			delete data;
+		}
+
+		void MsquicDataPool::lock()
+		{
+			while (locked.test_and_set(std::memory_order_acquire)) {
+
+				while (locked.test(std::memory_order_relaxed)) {
+				}
+
+			}
+		}
+
+		void MsquicDataPool::unlock()
+		{
+			locked.clear(std::memory_order_release);
+		}
+
+	}
 }
\ No newline at end of file
@@ -1,29 +1,159 @@
-#pragma once
-#include <memory>
-#include <boost/json.hpp>
-
-namespace hope {
-
-	namespace quic {
-
-		class MsquicSocketInterface;
-
-		class MsquicManager;
-
-		class MsquicData {
-
-		public:
-
-			MsquicData(boost::json::object json, std::shared_ptr<MsquicSocketInterface> msquicSocketInterface, MsquicManager* msquicManager);
-
-			std::shared_ptr<MsquicSocketInterface> msquicSocketInterface;
-
-			boost::json::object json;
-
-			MsquicManager* msquicManager;
-
-		};
-	}
-	
-}
-
+#pragma once
+#include <array>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <boost/json.hpp>
+#include <boost/json/monotonic_resource.hpp>
+
+#include "MsquicProtocol.h"
+#include "MsquicMessages.h"
+
+namespace hope {
+
+	namespace quic {
+
+		class MsquicSocketInterface;
+
+		class MsquicManager;
+
+		class MsquicDataPool;
+
+		class MsquicBulkRelay;
+
+	}
+
+	namespace utils {
+
+		class MsquicMemoryBudget;
+
+	}
+
+	namespace quic {
+
+		// 路由字段继承自 MsquicRoute：JSON 消息由 loadJson 提取，二进制消息直接取自帧头
+		class MsquicData : public MsquicRoute {
+
+			friend class MsquicDataPool;
+
+		public:
+
+			// 首块内存直接放在对象内，常见消息的 DOM 不会触及上游分配器
+			static constexpr size_t ARENA_INITIAL_SIZE = 1024;
+
+			// 回收时 payload 超过该容量则释放，避免空闲连接长期占着大块内存
+			static constexpr size_t PAYLOAD_RETAIN_CAPACITY = 4096;
+
+			MsquicData();
+
+			MsquicData(const MsquicData&) = delete;
+
+			MsquicData& operator=(const MsquicData&) = delete;
+
+			// 原地清洗后只提取路由字段并完整校验文档，不构建 DOM，清洗后的文本保存在 payload
+			// 文档之后除空白外还有内容视为非法
+			bool loadJson(std::string_view jsonStr, boost::json::error_code& ec);
+
+			// 二进制帧：路由字段取自帧头，压缩过的负载保持压缩，原样转给二进制目标
+			void loadBinary(const BinaryFrame& frame);
+
+			// 转成 JSON 前解压 payload，原始长度已在收包时按 maxFrameSize 校验；解压失败返回 false
+			bool inflate();
+
+			// DATAGRAM：只带目标 ID 和负载，源 ID 由 handler 在所属逻辑线程上补上
+			void loadDatagram(std::string_view targetId, std::string_view datagramPayload);
+
+			// 批量传输：数据不经过这里，只带路由字段和中转对象
+			void loadBulk(std::string_view targetId, std::shared_ptr<MsquicBulkRelay> relay);
+
+			// 需要完整 DOM 时才解析，只对 JSON 消息有效，内存来自本消息的 arena
+			boost::json::object& getJson();
+
+			// 本消息的 arena，临时构建的 DOM 都应使用它
+			boost::json::storage_ptr getStorage();
+
+			std::shared_ptr<MsquicSocketInterface> msquicSocketInterface;
+
+			MsquicManager* msquicManager = nullptr;
+
+			WireProtocol protocol = WireProtocol::Json;
+
+			// 负载：JSON 协议为原始 JSON 文本，二进制协议为不透明字节
+			std::string payload;
+
+			// 二进制负载的压缩标志（BINARY_FLAG_ZSTD / BINARY_FLAG_LZ4），非 0 时 payload 是带长度前缀的压缩数据
+			uint8_t compressionFlags = 0;
+
+			// JSON 顶层成员个数，拼接转发字段时使用
+			size_t memberCount = 0;
+
+			// JSON 顶层对象右括号在 payload 中的位置，转发字段拼在这里
+			size_t jsonEnd = 0;
+
+			// 原文自带 state/message，转发时不能直接拼接，走 DOM 改写
+			bool hasForwardFields = false;
+
+			// 批量传输请求的中转对象
+			std::shared_ptr<MsquicBulkRelay> bulkRelay;
+
+			// 记在会话预算上的字节数，回收时归还；会话由 msquicSocketInterface 持有，归还时一定还在
+			void chargeMemory(hope::utils::MsquicMemoryBudget* budget, size_t bytes);
+
+		private:
+
+			// 回收前清空，保留字符串容量和 arena 首块
+			void reset();
+
+			unsigned char arenaBuffer[ARENA_INITIAL_SIZE];
+
+			boost::json::monotonic_resource arena;
+
+			boost::json::value json;
+
+			bool jsonParsed = false;
+
+			hope::utils::MsquicMemoryBudget* memoryBudget = nullptr;
+
+			size_t chargedBytes = 0;
+
+		};
+
+		// 每个连接一个：handler 结束后 MsquicData 连同 arena 回到这里的空闲链表
+		class MsquicDataPool : public std::enable_shared_from_this<MsquicDataPool> {
+
+		public:
+
+			// 每个连接只缓存几个，空闲连接不为空闲链表预留内存
+			static constexpr size_t MAX_CACHED = 4;
+
+			MsquicDataPool() = default;
+
+			~MsquicDataPool();
+
+			MsquicDataPool(const MsquicDataPool&) = delete;
+
+			MsquicDataPool& operator=(const MsquicDataPool&) = delete;
+
+			std::shared_ptr<MsquicData> acquire(std::shared_ptr<MsquicSocketInterface> msquicSocketInterface, MsquicManager* msquicManager);
+
+		private:
+
+			// 可能在其他 MsquicManager 的线程上调用
+			void release(MsquicData* data);
+
+			// 临界区只有一次数组读写，自旋锁足够
+			void lock();
+
+			void unlock();
+
+			std::atomic_flag locked;
+
+			std::array<MsquicData*, MAX_CACHED> freeList{};
+
+			size_t cachedCount = 0;
+
+		};
+	}
+	
+}
\ No newline at end of file
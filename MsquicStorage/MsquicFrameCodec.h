@@ -0,0 +1,231 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+#include <algorithm>
+
+#include "MsquicProtocol.h"
+
+namespace hope {
+
+	namespace quic {
+
+		// 服务端和客户端共用的分帧器
+		// 分片内的完整帧直接以 span 视图交给回调，只有跨分片的帧才拷贝进半帧缓冲区
+		// 缓冲区里最多只有一个半帧，补齐交出后整体清空，所以是从 0 开始的线性缓冲，不需要回绕
+		class MsquicFrameCodec {
+
+		public:
+
+			enum class Result {
+
+				Ok = 0,
+
+				InvalidFrame = 1,   // 帧头非法，流已无法重新同步
+
+				FrameTooLarge = 2,  // 超过 maxFrameSize
+
+			};
+
+			static constexpr size_t DEFAULT_MAX_FRAME_SIZE = 8 * 1024 * 1024;
+
+			// 空闲时半帧缓冲区超过该容量就释放
+			static constexpr size_t RETAIN_CAPACITY = 64 * 1024;
+
+			MsquicFrameCodec(WireProtocol protocol = WireProtocol::Json, size_t maxFrameSize = DEFAULT_MAX_FRAME_SIZE)
+				: protocol(protocol)
+				, maxFrameSize(maxFrameSize) {
+			}
+
+			void setProtocol(WireProtocol protocol) {
+
+				this->protocol = protocol;
+			}
+
+			void setMaxFrameSize(size_t maxFrameSize) {
+
+				this->maxFrameSize = maxFrameSize;
+			}
+
+			// 已缓存但还不构成完整帧的字节数
+			size_t bufferedBytes() const {
+
+				return count;
+			}
+
+			size_t capacity() const {
+
+				return partial.size();
+			}
+
+			// 丢弃缓存并释放内存
+			void clear() {
+
+				std::vector<uint8_t>().swap(partial);
+
+				count = 0;
+
+				pendingFrameSize = -1;
+			}
+
+			// handle: void(std::span<const uint8_t> frame)，frame 含帧头，只在回调期间有效
+			template<class Handle>
+			Result feed(std::span<const uint8_t> fragment, Handle&& handle) {
+
+				const uint8_t* cursor = fragment.data();
+
+				size_t remaining = fragment.size();
+
+				const size_t headerSize = frameHeaderSize(protocol);
+
+				// 1. 先补齐上一个分片留下的半帧
+				if (count > 0) {
+
+					if (pendingFrameSize < 0) {
+
+						size_t take = std::min(headerSize - std::min(headerSize, count), remaining);
+
+						push(cursor, take);
+
+						cursor += take;
+
+						remaining -= take;
+
+						if (count < headerSize) {
+							return Result::Ok;
+						}
+
+						uint8_t header[BINARY_HEADER_SIZE > sizeof(int64_t) ? BINARY_HEADER_SIZE : sizeof(int64_t)];
+
+						memcpy(header, partial.data(), headerSize);
+
+						Result result = checkFrameSize(frameSize(protocol, header));
+
+						if (result != Result::Ok) {
+							return result;
+						}
+
+						pendingFrameSize = frameSize(protocol, header);
+					}
+
+					size_t take = std::min(static_cast<size_t>(pendingFrameSize) - count, remaining);
+
+					push(cursor, take);
+
+					cursor += take;
+
+					remaining -= take;
+
+					if (count < static_cast<size_t>(pendingFrameSize)) {
+						return Result::Ok;
+					}
+
+					handle(std::span<const uint8_t>(partial.data(), count));
+
+					reset();
+				}
+
+				// 2. 分片内的完整帧零拷贝交出
+				while (remaining >= headerSize) {
+
+					int64_t size = frameSize(protocol, cursor);
+
+					Result result = checkFrameSize(size);
+
+					if (result != Result::Ok) {
+						return result;
+					}
+
+					if (remaining < static_cast<size_t>(size)) {
+						break;
+					}
+
+					handle(std::span<const uint8_t>(cursor, static_cast<size_t>(size)));
+
+					cursor += size;
+
+					remaining -= static_cast<size_t>(size);
+				}
+
+				// 3. 剩余的半帧进缓冲区，等下一个分片
+				if (remaining > 0) {
+
+					push(cursor, remaining);
+
+				}
+
+				return Result::Ok;
+			}
+
+		private:
+
+			Result checkFrameSize(int64_t size) {
+
+				if (size < 0) {
+					clear();
+					return Result::InvalidFrame;
+				}
+
+				if (static_cast<uint64_t>(size) > maxFrameSize) {
+					clear();
+					return Result::FrameTooLarge;
+				}
+
+				return Result::Ok;
+			}
+
+			// 按 2 的幂扩容，跨多个分片的大帧不会反复搬移
+			void push(const uint8_t* data, size_t size) {
+
+				if (size == 0) {
+					return;
+				}
+
+				if (count + size > partial.size()) {
+
+					size_t newCapacity = partial.empty() ? 256 : partial.size();
+
+					while (newCapacity < count + size) {
+						newCapacity <<= 1;
+					}
+
+					partial.resize(newCapacity);
+				}
+
+				memcpy(partial.data() + count, data, size);
+
+				count += size;
+			}
+
+			// 半帧已经交出
+			void reset() {
+
+				count = 0;
+
+				pendingFrameSize = -1;
+
+				// 大帧过后不长期占用内存
+				if (partial.size() > RETAIN_CAPACITY) {
+					std::vector<uint8_t>().swap(partial);
+				}
+			}
+
+			WireProtocol protocol;
+
+			size_t maxFrameSize;
+
+			// 跨分片的半帧，从下标 0 开始连续存放
+			std::vector<uint8_t> partial;
+
+			size_t count = 0;
+
+			// 缓存中半帧的总长度，帧头未收齐时为 -1
+			int64_t pendingFrameSize = -1;
+
+		};
+
+	}
+
+}
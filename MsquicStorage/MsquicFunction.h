@@ -0,0 +1,163 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "MsquicMetrics.h"
+
+namespace hope {
+    namespace utils {
+
+        template<class Signature, size_t Capacity = 64>
+        class MsquicFunction;
+
+        // 只能移动的可调用对象，Capacity 以内的闭包直接放在对象内部，不做堆分配
+        // 放不下时退化为堆分配并计入 MsquicMetrics::taskHeapAllocations
+        template<class R, class... Args, size_t Capacity>
+        class MsquicFunction<R(Args...), Capacity> {
+        public:
+
+            template<class F>
+            static constexpr bool fitsInline = sizeof(F) <= Capacity
+                && alignof(F) <= alignof(std::max_align_t)
+                && std::is_nothrow_move_constructible_v<F>;
+
+            MsquicFunction() noexcept = default;
+
+            MsquicFunction(std::nullptr_t) noexcept {}
+
+            template<class F, class = std::enable_if_t<!std::is_same_v<std::decay_t<F>, MsquicFunction>>>
+            MsquicFunction(F&& f) {
+
+                using Fn = std::decay_t<F>;
+
+                if constexpr (fitsInline<Fn>) {
+
+                    ::new (static_cast<void*>(storage)) Fn(std::forward<F>(f));
+
+                    ops = &inlineOps<Fn>;
+
+                }
+                else {
+
+                    ::new (static_cast<void*>(storage)) Fn*(new Fn(std::forward<F>(f)));
+
+                    ops = &heapOps<Fn>;
+
+                    MsquicMetrics::add(MsquicMetrics::instance().taskHeapAllocations);
+
+                }
+            }
+
+            MsquicFunction(MsquicFunction&& other) noexcept {
+
+                moveFrom(other);
+
+            }
+
+            MsquicFunction& operator=(MsquicFunction&& other) noexcept {
+
+                if (this != &other) {
+
+                    reset();
+
+                    moveFrom(other);
+
+                }
+
+                return *this;
+            }
+
+            MsquicFunction(const MsquicFunction&) = delete;
+
+            MsquicFunction& operator=(const MsquicFunction&) = delete;
+
+            ~MsquicFunction() {
+
+                reset();
+
+            }
+
+            R operator()(Args... args) {
+
+                return ops->invoke(storage, std::forward<Args>(args)...);
+            }
+
+            explicit operator bool() const noexcept {
+
+                return ops != nullptr;
+            }
+
+        private:
+
+            struct Ops {
+
+                R(*invoke)(void* storage, Args&&... args);
+
+                // 把 src 的闭包移到 dst，并销毁 src 中的
+                void(*move)(void* dst, void* src) noexcept;
+
+                void(*destroy)(void* storage) noexcept;
+
+            };
+
+            template<class Fn>
+            static constexpr Ops inlineOps = {
+                [](void* storage, Args&&... args) -> R {
+                    return (*static_cast<Fn*>(storage))(std::forward<Args>(args)...);
+                },
+                [](void* dst, void* src) noexcept {
+                    ::new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+                    static_cast<Fn*>(src)->~Fn();
+                },
+                [](void* storage) noexcept {
+                    static_cast<Fn*>(storage)->~Fn();
+                },
+            };
+
+            template<class Fn>
+            static constexpr Ops heapOps = {
+                [](void* storage, Args&&... args) -> R {
+                    return (**static_cast<Fn**>(storage))(std::forward<Args>(args)...);
+                },
+                [](void* dst, void* src) noexcept {
+                    ::new (dst) Fn*(*static_cast<Fn**>(src));
+                },
+                [](void* storage) noexcept {
+                    delete *static_cast<Fn**>(storage);
+                },
+            };
+
+            void moveFrom(MsquicFunction& other) noexcept {
+
+                if (other.ops) {
+
+                    other.ops->move(storage, other.storage);
+
+                    ops = other.ops;
+
+                    other.ops = nullptr;
+
+                }
+            }
+
+            void reset() noexcept {
+
+                if (ops) {
+
+                    ops->destroy(storage);
+
+                    ops = nullptr;
+
+                }
+            }
+
+            alignas(std::max_align_t) unsigned char storage[Capacity < sizeof(void*) ? sizeof(void*) : Capacity];
+
+            const Ops* ops = nullptr;
+
+        };
+
+    }
+}
@@ -1,465 +1,545 @@
-#include "MsquicLogicSystem.h"
-#include "MsquicServer.h"
-#include "MsquicManager.h"
-#include "msquicSocketInterface.h"
-#include "MsquicData.h"
-
-#include "MsquicMysqlManagerPools.h"
-
-#include <iostream>
-#include <chrono>
-
-#include <boost/uuid/uuid.hpp>            // uuid 类  
-#include <boost/uuid/uuid_generators.hpp> // 生成器  
-#include <boost/uuid/uuid_io.hpp>   
-
-#include "MsquicHashMap.h"
-#include "MsquicHashSet.h"
-
-#include "AsyncTransactionGuard.h"
-
-#include "ConfigManager.h"
-#include "Utils.h"
-
-
-namespace hope {
-
-    namespace handle
-    {
-
-		MsquicLogicSystem::MsquicLogicSystem(boost::asio::io_context& ioContext) :ioContext(ioContext)
-        {
-
-        }
-
-        void MsquicLogicSystem::RunEventLoop() {
-
-            initHandlers();
-
-        }
-
-        boost::asio::io_context& MsquicLogicSystem::getIoCompletePorts()
-        {
-            return ioContext;
-        }
-
-        MsquicLogicSystem::~MsquicLogicSystem() {
-
-        }
-
-        void MsquicLogicSystem::postTaskAsync(std::shared_ptr<hope::quic::MsquicData> data) {
-
-            data->json = makeCleanCopy(data->json);
-
-            int type = data->json["requestType"].as_int64();
-
-            if (this->msquicHandlers.find(type) != this->msquicHandlers.end()) {
-
-                std::pair<bool, std::function<boost::asio::awaitable<void>(std::shared_ptr <hope::quic::MsquicData> , std::shared_ptr<hope::mysql::MsquicMysqlManager>)>> pairs = this->msquicHandlers[type];
-
-                if (pairs.first) {
-
-                    std::shared_ptr<hope::mysql::MsquicMysqlManager> manager = hope::mysql::MsquicMysqlManagerPools::getInstance()->getTransactionMysqlManager();
-
-                    if (manager) {
-
-                        boost::asio::co_spawn(ioContext, [this, type, pairs, manager, data]() mutable -> boost::asio::awaitable<void> {
-
-                            try {
-                                co_await pairs.second(data, manager);
-                            }
-                            catch (...) {
-                                hope::mysql::MsquicMysqlManagerPools::getInstance()->returnTransactionMysqlManager(std::move(manager));
-                                throw;
-                            }
-
-                            hope::mysql::MsquicMysqlManagerPools::getInstance()->returnTransactionMysqlManager(std::move(manager));
-                            },
-                            [this, type](std::exception_ptr ptr) {
-                                if (ptr) {
-                                    try {
-                                        std::rethrow_exception(ptr);
-                                    }
-                                    catch (const std::exception& e) {
-                                        LOG_ERROR("MsquicLogicSystem boost::asio::co_spawn Task: %d Exception: %s", type, e.what());
-                                    }
-                                }
-                            });
-
-                    }
-                    else {
-                        postTaskAsync(data); // 暂不加重试，保持原样
-                    }
-
-                }
-                else {
-                    std::shared_ptr<hope::mysql::MsquicMysqlManager> manager = hope::mysql::MsquicMysqlManagerPools::getInstance()->getMysqlManager();
-
-                    boost::asio::co_spawn(ioContext, [this, type, pairs, manager, data]() -> boost::asio::awaitable<void> {
-                        co_await pairs.second(data, manager);
-                        },
-                        [this, type](std::exception_ptr ptr) {
-                            if (ptr) {
-                                try {
-                                    std::rethrow_exception(ptr);
-                                }
-                                catch (const std::exception& e) {
-                                    LOG_ERROR("MsquicLogicSystem boost::asio::co_spawn Task: %d Exception: %s", type, e.what());
-                                }
-                            }
-                        });
-                }
-
-            }
-            else {
-                LOG_ERROR("Unknown Msquic Request Type: %d", type);
-            }
-        }
-
-
-        void MsquicLogicSystem::initHandlers() {
-            auto self = shared_from_this();
-
-            std::function<boost::asio::awaitable<void>(std::shared_ptr<hope::quic::MsquicData>, std::shared_ptr<hope::mysql::MsquicMysqlManager>, std::string)> forwardHandler = [self](std::shared_ptr<hope::quic::MsquicData> data, std::shared_ptr<hope::mysql::MsquicMysqlManager>, std::string requestTypeStr)->boost::asio::awaitable<void> {
-                boost::json::object message = data->json;
-
-                auto msquicSocketInterface = data->msquicSocketInterface.get();
-                int64_t requestTypeValue = message["requestType"].as_int64();
-
-                if (!message.contains("accountId") || !message.contains("targetId")) {
-                    LOG_WARNING("Forward Message Missing accountId or targetId.");
-                    co_return;
-                }
-
-                std::string accountId = message["accountId"].as_string().c_str();
-                std::string targetId = message["targetId"].as_string().c_str();
-                std::shared_ptr<hope::quic::MsquicSocketInterface> targetSocket = nullptr;
-
-                // 1. 查找目标连接 (使用哈希锁)
-                {
-                    auto it = data->msquicManager->msquicSocketInterfaceMap.find(targetId);
-                    if (it != data->msquicManager->msquicSocketInterfaceMap.end()) {
-                        targetSocket = it->second;
-                    }
-                }
-
-                // 2. 处理目标未找到 (404)
-                if (!targetSocket) {
-                    tbb::concurrent_lru_cache<std::string, int>::handle handles = data->msquicManager->localRouteCache[targetId];
-                    auto self = data->msquicManager->shared_from_this();
-
-                    if (handles.value() == -1) {
-                        int mapChannelIndex = data->msquicManager->hasher(targetId) % data->msquicManager->hashSize;
-
-                        data->msquicManager->msquicServer->postTaskAsync(mapChannelIndex, [=](std::shared_ptr<hope::quic::MsquicManager> manager)->boost::asio::awaitable<void> {
-                            if (manager->actorSocketMappingIndex.find(targetId) != manager->actorSocketMappingIndex.end()) {
-                                int targetChannelIndex = manager->actorSocketMappingIndex[targetId];
-
-                                self->msquicServer->postTaskAsync(targetChannelIndex, [=](std::shared_ptr<hope::quic::MsquicManager> manager)->boost::asio::awaitable<void> {
-                                    if (manager->msquicSocketInterfaceMap.find(targetId) != manager->msquicSocketInterfaceMap.end()) {
-                                        if (tbb::concurrent_lru_cache<std::string, int>::handle handles = self->localRouteCache[targetId]) {
-                                            handles.value() = manager->channelIndex;
-                                        }
-                                        std::shared_ptr<hope::quic::MsquicSocketInterface> targetmsquicSocketInterface = manager->msquicSocketInterfaceMap[targetId];
-                                        boost::json::object forwardMessage = message;
-                                        forwardMessage["state"] = 200;
-                                        forwardMessage["message"] = "MsquicServer forward";
-
-                                        // 构建二进制消息
-                                        auto [buffer, size] = buildMessage(forwardMessage, targetmsquicSocketInterface.get());
-                                        targetmsquicSocketInterface->writeAsync(buffer, size);
-
-                                        LOG_INFO("Request forward: %s -> %s (Request Type: %s)", accountId.c_str(), targetId.c_str(), requestTypeStr);
-                                        co_return;
-                                    }
-                                    else {
-                                        boost::json::object response;
-                                        response["requestType"] = requestTypeValue;
-                                        response["state"] = 404;
-                                        response["message"] = "TargetId is not register";
-
-                                        // 构建二进制消息
-                                        auto [buffer, size] = buildMessage(response, msquicSocketInterface);
-                                        msquicSocketInterface->writeAsync(buffer, size);
-
-                                        LOG_WARNING("Request forward Not Found (404): %s -> %s (Request Type: %s)", accountId.c_str(), targetId.c_str(), requestTypeStr);
-                                        co_return;
-                                    }
-                                    });
-                            }
-                            else {
-                                boost::json::object response;
-                                response["requestType"] = requestTypeValue;
-                                response["state"] = 404;
-                                response["message"] = "TargetId is not register";
-
-                                // 构建二进制消息
-                                auto [buffer, size] = buildMessage(response, msquicSocketInterface);
-                                msquicSocketInterface->writeAsync(buffer, size);
-
-                                LOG_WARNING("Request forward Not Found (404): %s -> %s (Request Type: %s)", accountId.c_str(), targetId.c_str(), requestTypeStr);
-                                co_return;
-                            }
-                            });
-                    }
-                    else {
-                        data->msquicManager->msquicServer->postTaskAsync(handles.value(), [=](std::shared_ptr<hope::quic::MsquicManager> manager)->boost::asio::awaitable<void> {
-                            if (manager->msquicSocketInterfaceMap.find(targetId) != manager->msquicSocketInterfaceMap.end()) {
-                                if (tbb::concurrent_lru_cache<std::string, int>::handle handles = self->localRouteCache[targetId]) {
-                                    handles.value() = manager->channelIndex;
-                                }
-                                std::shared_ptr<hope::quic::MsquicSocketInterface> targetmsquicSocketInterface = manager->msquicSocketInterfaceMap[targetId];
-                                boost::json::object forwardMessage = message;
-                                forwardMessage["state"] = 200;
-                                forwardMessage["message"] = "MsquicServer forward";
-
-                                // 构建二进制消息
-                                auto [buffer, size] = buildMessage(forwardMessage, targetmsquicSocketInterface.get());
-                                targetmsquicSocketInterface->writeAsync(buffer, size);
-
-                                LOG_INFO("Request forward: %s -> %s (Request Type: %s)", accountId.c_str(), targetId.c_str(), requestTypeStr);
-                                co_return;
-                            }
-                            else {
-                                int mapChannelIndex = data->msquicManager->hasher(targetId) % data->msquicManager->hashSize;
-
-                                data->msquicManager->msquicServer->postTaskAsync(mapChannelIndex, [=](std::shared_ptr<hope::quic::MsquicManager> manager)->boost::asio::awaitable<void> {
-                                    if (manager->actorSocketMappingIndex.find(targetId) != manager->actorSocketMappingIndex.end()) {
-                                        int targetChannelIndex = manager->actorSocketMappingIndex[targetId];
-
-                                        self->msquicServer->postTaskAsync(targetChannelIndex, [=](std::shared_ptr<hope::quic::MsquicManager> manager)->boost::asio::awaitable<void> {
-                                            if (manager->msquicSocketInterfaceMap.find(targetId) != manager->msquicSocketInterfaceMap.end()) {
-                                                if (tbb::concurrent_lru_cache<std::string, int>::handle handles = self->localRouteCache[targetId]) {
-                                                    handles.value() = manager->channelIndex;
-                                                }
-                                                std::shared_ptr<hope::quic::MsquicSocketInterface> targetmsquicSocketInterface = manager->msquicSocketInterfaceMap[targetId];
-                                                boost::json::object forwardMessage = message;
-                                                forwardMessage["state"] = 200;
-                                                forwardMessage["message"] = "MsquicServer forward";
-
-                                                // 构建二进制消息
-                                                auto [buffer, size] = buildMessage(forwardMessage, targetmsquicSocketInterface.get());
-                                                targetmsquicSocketInterface->writeAsync(buffer, size);
-
-                                                LOG_INFO("Request forward: %s -> %s (Request Type: %s)", accountId.c_str(), targetId.c_str(), requestTypeStr);
-                                                co_return;
-                                            }
-                                            else {
-                                                boost::json::object response;
-                                                response["requestType"] = requestTypeValue;
-                                                response["state"] = 404;
-                                                response["message"] = "TargetId is not register";
-
-                                                // 构建二进制消息
-                                                auto [buffer, size] = buildMessage(response, msquicSocketInterface);
-                                                msquicSocketInterface->writeAsync(buffer, size);
-
-                                                LOG_WARNING("Request forward Not Found (404): %s -> %s (Request Type: %s)", accountId.c_str(), targetId.c_str(), requestTypeStr);
-                                                co_return;
-                                            }
-                                            });
-                                    }
-                                    else {
-                                        boost::json::object response;
-                                        response["requestType"] = requestTypeValue;
-                                        response["state"] = 404;
-                                        response["message"] = "TargetId is not register";
-
-                                        // 构建二进制消息
-                                        auto [buffer, size] = buildMessage(response, msquicSocketInterface);
-                                        msquicSocketInterface->writeAsync(buffer, size);
-
-                                        LOG_WARNING("Request forward Not Found (404): %s -> %s (Request Type: %s)", accountId.c_str(), targetId.c_str(), requestTypeStr);
-                                        co_return;
-                                    }
-                                    });
-                            }
-                            });
-                    }
-                    co_return;
-                }
-
-                // 3. 转发消息
-                boost::json::object forwardMessage = message;
-
-                forwardMessage["state"] = 200;
-
-                forwardMessage["message"] = "MsquicServer forward";
-
-                // 构建二进制消息
-                auto [buffer, size] = buildMessage(forwardMessage, targetSocket.get());
-                targetSocket->writeAsync(buffer, size);
-
-                LOG_INFO("Request forward: %s -> %s (Request Type: %s)", accountId.c_str(), targetId.c_str(), requestTypeStr);
-                };
-
-            msquicHandlers[0] = std::pair<bool, std::function<boost::asio::awaitable<void>(std::shared_ptr<hope::quic::MsquicData>, std::shared_ptr<hope::mysql::MsquicMysqlManager>)>>(false, [self](std::shared_ptr<hope::quic::MsquicData> data, std::shared_ptr<hope::mysql::MsquicMysqlManager> mysqlManager)->boost::asio::awaitable<void> {
-
-                boost::json::object& message = data->json;
-
-                hope::quic::MsquicSocket *  msquicSocket = nullptr;
-
-                hope::quic::WebRTCSignalSocket * webrtcSignalSocket = nullptr;
-
-                if (data->msquicSocketInterface->getType() == hope::quic::SocketType::MsquicSocket) {
-                
-                    msquicSocket = static_cast<hope::quic::MsquicSocket*>(data->msquicSocketInterface.get());
-
-                }
-                else if (data->msquicSocketInterface->getType() == hope::quic::SocketType::WebSocket) {
-                
-                    webrtcSignalSocket = static_cast<hope::quic::WebRTCSignalSocket*>(data->msquicSocketInterface.get());
-
-                }
-
-                boost::json::object response;
-
-                response["requestType"] = 0;
-
-                std::string accountId;
-
-                if (msquicSocket) {
-
-                    if (!message.contains("accountId")) {
-
-                        LOG_WARNING("REGISTER Message Missing accountId.");
-
-                        response["state"] = 500;
-
-                        response["message"] = "REGISTER Message Missing accountId.";
-
-                        // 修改这里：构建二进制消息
-                        auto [buffer, size] = buildMessage(response, msquicSocket);
-
-                        msquicSocket->writeAsync(buffer, size);
-
-                        co_return;
-                    }
-
-                    accountId = message["accountId"].as_string().c_str();
-
-                    msquicSocket->setAccountId(accountId);
-
-                    msquicSocket->setRegistered(true);
-
-                    data->msquicManager->msquicSocketInterfaceMap[accountId] = data->msquicSocketInterface;
-                }
-                else if (webrtcSignalSocket) {
-
-                    if (!message.contains("accountId")) {
-
-                        LOG_WARNING("REGISTER Message Missing accountId.");
-
-                        response["state"] = 500;
-
-                        response["message"] = "REGISTER Message Missing accountId.";
-
-                        // 修改这里：构建二进制消息
-                        auto [buffer, size] = buildMessage(response, webrtcSignalSocket);
-
-                        webrtcSignalSocket->writeAsync(buffer, size);
-                        
-                        co_return;
-                    }
-
-                    accountId = message["accountId"].as_string().c_str();
-
-                    webrtcSignalSocket->setAccountId(accountId);
-
-                    webrtcSignalSocket->setRegistered(true);
-
-                    data->msquicManager->msquicSocketInterfaceMap[accountId] = data->msquicSocketInterface;
-
-                }
-                else {
-                
-                    LOG_ERROR("Unknow SocketType:%d", static_cast<int>(data->msquicSocketInterface->getType()));
-
-                }
-
-                response["state"] = 200;
-
-                response["message"] = "register successful";
-
-                // 修改这里：构建二进制消息
-                auto [buffer, size] = buildMessage(response, data->msquicSocketInterface.get());
-
-                data->msquicSocketInterface->writeAsync(buffer, size);
-
-                int mapChannelIndex = data->msquicManager->hasher(accountId) % data->msquicManager->hashSize;
-
-                data->msquicManager->msquicServer->postTaskAsync(mapChannelIndex, [self = data->msquicManager->shared_from_this(), accountId, mapChannelIndex](std::shared_ptr<hope::quic::MsquicManager> manager)->boost::asio::awaitable<void> {
-                    manager->actorSocketMappingIndex[accountId] = self->channelIndex;
-                    co_return;
-                    });
-
-                LOG_INFO("User Register Successful : %s (channelIndex: %d)", accountId.c_str(), data->msquicManager->channelIndex);
-                });
-
-            // 其他 handler 保持原来的转发逻辑，因为它们调用 forwardHandler
-            msquicHandlers[1] = std::pair<bool, std::function<boost::asio::awaitable<void>(std::shared_ptr<hope::quic::MsquicData>, std::shared_ptr<hope::mysql::MsquicMysqlManager>)>>(false, [self, forwardHandler](std::shared_ptr<hope::quic::MsquicData> data, std::shared_ptr<hope::mysql::MsquicMysqlManager> mysqlManager)->boost::asio::awaitable<void> {
-                co_await forwardHandler(std::move(data), mysqlManager, "REQUEST");
-                });
-
-            msquicHandlers[2] = std::pair<bool, std::function<boost::asio::awaitable<void>(std::shared_ptr<hope::quic::MsquicData>, std::shared_ptr<hope::mysql::MsquicMysqlManager>)>>(false, [self, forwardHandler](std::shared_ptr<hope::quic::MsquicData> data, std::shared_ptr<hope::mysql::MsquicMysqlManager> mysqlManager)->boost::asio::awaitable<void> {
-                co_await forwardHandler(std::move(data), mysqlManager, "RESTART");
-                });
-
-            msquicHandlers[3] = std::pair<bool, std::function<boost::asio::awaitable<void>(std::shared_ptr<hope::quic::MsquicData>, std::shared_ptr<hope::mysql::MsquicMysqlManager>)>>(false, [self, forwardHandler](std::shared_ptr<hope::quic::MsquicData> data, std::shared_ptr<hope::mysql::MsquicMysqlManager> mysqlManager)->boost::asio::awaitable<void> {
-                co_await forwardHandler(std::move(data), mysqlManager, "STOPREMOTE");
-                });
-
-            msquicHandlers[4] = std::pair<bool, std::function<boost::asio::awaitable<void>(std::shared_ptr<hope::quic::MsquicData>, std::shared_ptr<hope::mysql::MsquicMysqlManager>)>>(false, [self](std::shared_ptr<hope::quic::MsquicData> data, std::shared_ptr<hope::mysql::MsquicMysqlManager> mysqlManager)->boost::asio::awaitable<void> {
-               
-                
-                hope::quic::MsquicSocket* msquicSocket = nullptr;
-
-                hope::quic::WebRTCSignalSocket* webrtcSignalSocket = nullptr;
-
-                if (data->msquicSocketInterface->getType() == hope::quic::SocketType::MsquicSocket) {
-
-                    msquicSocket = static_cast<hope::quic::MsquicSocket*>(data->msquicSocketInterface.get());
-
-                }
-                else if (data->msquicSocketInterface->getType() == hope::quic::SocketType::WebSocket) {
-
-                    webrtcSignalSocket = static_cast<hope::quic::WebRTCSignalSocket*>(data->msquicSocketInterface.get());
-
-                }
-
-                std::string accountId;
-
-                if (msquicSocket) {
-
-                    accountId = msquicSocket->getAccountId();
-
-                }
-                else if (webrtcSignalSocket) {
-
-                    accountId = webrtcSignalSocket->getAccountId();
-
-                }
-                else {
-
-                    LOG_ERROR("Unknow SocketType:%d", static_cast<int>(data->msquicSocketInterface->getType()));
-
-                }
-
-
-                if (!accountId.empty()) {
-
-                    data->msquicManager->removeConnection(accountId);
-
-                }
-
-                co_return;
-
-                });
-        }
-
-    }
-
-}
-
-
-
+#include "MsquicLogicSystem.h"
+#include "MsquicServer.h"
+#include "MsquicManager.h"
+#include "msquicSocketInterface.h"
+#include "MsquicData.h"
+#include "MsquicBulkRelay.h"
+
+#include "MsquicMysqlManagerPools.h"
+
+#include <iostream>
+#include <chrono>
+
+#include <boost/uuid/uuid.hpp>            // uuid 类  
+#include <boost/uuid/uuid_generators.hpp> // 生成器  
+#include <boost/uuid/uuid_io.hpp>   
+
+#include "MsquicHashMap.h"
+#include "MsquicHashSet.h"
+
+#include "AsyncTransactionGuard.h"
+
+#include "ConfigManager.h"
+#include "MsquicMetrics.h"
+#include "Utils.h"
+
+
+namespace hope {
+
+    namespace handle
+    {
+
+		MsquicLogicSystem::MsquicLogicSystem(boost::asio::io_context& ioContext) :ioContext(ioContext)
+        {
+
+        }
+
+        // 下标即 requestType，新增请求类型在这里登记；不会挂起的 handler 登记为同步版本
+        constexpr MsquicLogicSystem::HandlerTable MsquicLogicSystem::handlerTable = { {
+            { nullptr, &MsquicLogicSystem::registerHandler,   MsquicDatabaseAccess::None, hope::quic::TrafficClass::Control,    "REGISTER" },
+            { nullptr, &MsquicLogicSystem::requestHandler,    MsquicDatabaseAccess::None, hope::quic::TrafficClass::Signalling, "REQUEST" },
+            { nullptr, &MsquicLogicSystem::restartHandler,    MsquicDatabaseAccess::None, hope::quic::TrafficClass::Control,    "RESTART" },
+            { nullptr, &MsquicLogicSystem::stopRemoteHandler, MsquicDatabaseAccess::None, hope::quic::TrafficClass::Control,    "STOPREMOTE" },
+            { nullptr, &MsquicLogicSystem::disconnectHandler, MsquicDatabaseAccess::None, hope::quic::TrafficClass::Control,    "DISCONNECT" },
+            { nullptr, &MsquicLogicSystem::datagramHandler,   MsquicDatabaseAccess::None, hope::quic::TrafficClass::Signalling, "DATAGRAM" },
+            { nullptr, &MsquicLogicSystem::bulkHandler,       MsquicDatabaseAccess::None, hope::quic::TrafficClass::Bulk,       "BULK" },
+        } };
+
+        // 同步 handler 在当前线程直接执行，拿不到异步的数据库连接
+        constexpr bool MsquicLogicSystem::validHandlerTable(const HandlerTable& table) {
+            for (const MsquicHandlerEntry& entry : table) {
+                if (entry.handler && entry.syncHandler) {
+                    return false;
+                }
+                if (entry.syncHandler && entry.database != MsquicDatabaseAccess::None) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        hope::quic::TrafficClass MsquicLogicSystem::trafficClassOf(int64_t requestType) {
+
+            if (requestType < 0 || requestType >= static_cast<int64_t>(handlerTable.size())) {
+                return hope::quic::TrafficClass::Signalling;
+            }
+
+            return handlerTable[requestType].trafficClass;
+        }
+
+        void MsquicLogicSystem::RunEventLoop() {
+
+        }
+
+        boost::asio::io_context& MsquicLogicSystem::getIoCompletePorts()
+        {
+            return ioContext;
+        }
+
+        MsquicLogicSystem::~MsquicLogicSystem() {
+
+        }
+
+        void MsquicLogicSystem::postTaskAsync(std::shared_ptr<hope::quic::MsquicData> data) {
+
+            static_assert(validHandlerTable(handlerTable), "invalid handler table");
+
+            static_assert(hope::quic::DATAGRAM_REQUEST_TYPE < static_cast<int64_t>(REQUEST_TYPE_COUNT), "DATAGRAM must be registered in the handler table");
+
+            static_assert(hope::quic::BULK_REQUEST_TYPE < static_cast<int64_t>(REQUEST_TYPE_COUNT), "BULK must be registered in the handler table");
+
+            int64_t type = data->requestType;
+
+            // 稠密表直接下标定位，不做哈希查找也不拷贝 std::function
+            if (type < 0 || type >= static_cast<int64_t>(handlerTable.size()) || !handlerTable[type].registered()) {
+                LOG_ERROR("Unknown Msquic Request Type: %lld", static_cast<long long>(type));
+                return;
+            }
+
+            const MsquicHandlerEntry* entry = &handlerTable[type];
+
+            // 不会挂起的 handler 不走 co_spawn：已在逻辑线程上就直接执行，否则投递一次
+            if (!entry->suspends()) {
+
+                hope::utils::MsquicMetrics::add(hope::utils::MsquicMetrics::instance().inlineHandlers);
+
+                if (ioContext.get_executor().running_in_this_thread()) {
+                    runSyncHandler(entry, std::move(data));
+                }
+                else {
+                    boost::asio::post(ioContext, boost::asio::bind_allocator(boost::asio::recycling_allocator<void>(), [this, entry, data = std::move(data)]() mutable {
+                        runSyncHandler(entry, std::move(data));
+                        }));
+                }
+
+                return;
+            }
+
+            hope::utils::MsquicMetrics::add(hope::utils::MsquicMetrics::instance().spawnedHandlers);
+
+            // 协程帧本身由 asio 的线程本地缓存复用，完成回调也绑定 recycling_allocator
+            auto onException = boost::asio::bind_allocator(boost::asio::recycling_allocator<void>(), [entry](std::exception_ptr ptr) {
+                if (ptr) {
+                    try {
+                        std::rethrow_exception(ptr);
+                    }
+                    catch (const std::exception& e) {
+                        LOG_ERROR("MsquicLogicSystem boost::asio::co_spawn Task: %s Exception: %s", entry->name, e.what());
+                    }
+                }
+            });
+
+            if (entry->database == MsquicDatabaseAccess::Transaction) {
+
+                std::shared_ptr<hope::mysql::MsquicMysqlManager> manager = hope::mysql::MsquicMysqlManagerPools::getInstance()->getTransactionMysqlManager();
+
+                if (!manager) {
+                    postTaskAsync(std::move(data)); // 暂不加重试，保持原样
+                    return;
+                }
+
+                boost::asio::co_spawn(ioContext, [this, entry, manager = std::move(manager), data = std::move(data)]() mutable -> boost::asio::awaitable<void> {
+
+                    try {
+                        co_await (this->*entry->handler)(std::move(data), manager);
+                    }
+                    catch (...) {
+                        hope::mysql::MsquicMysqlManagerPools::getInstance()->returnTransactionMysqlManager(std::move(manager));
+                        throw;
+                    }
+
+                    hope::mysql::MsquicMysqlManagerPools::getInstance()->returnTransactionMysqlManager(std::move(manager));
+                    }, onException);
+
+                return;
+            }
+
+            // 不访问数据库的 handler 不再占用连接池
+            std::shared_ptr<hope::mysql::MsquicMysqlManager> manager;
+
+            if (entry->database == MsquicDatabaseAccess::Pooled) {
+                manager = hope::mysql::MsquicMysqlManagerPools::getInstance()->getMysqlManager();
+            }
+
+            boost::asio::co_spawn(ioContext, (this->*entry->handler)(std::move(data), std::move(manager)), onException);
+        }
+
+        void MsquicLogicSystem::runSyncHandler(const MsquicHandlerEntry* entry, std::shared_ptr<hope::quic::MsquicData> data) {
+
+            try {
+                (this->*entry->syncHandler)(std::move(data));
+            }
+            catch (const std::exception& e) {
+                LOG_ERROR("MsquicLogicSystem Task: %s Exception: %s", entry->name, e.what());
+            }
+        }
+
+        void MsquicLogicSystem::forwardHandler(std::shared_ptr<hope::quic::MsquicData> data, const char* requestTypeStr) {
+
+            hope::quic::ForwardRequest request;
+
+            const char* missingField = nullptr;
+
+            if (!hope::quic::decodeRequest(*data, request, missingField)) {
+                LOG_WARNING_DEFERRED("Forward Message Missing %s.", missingField);
+                return;
+            }
+
+            hope::quic::MsquicManager* msquicManager = data->msquicManager;
+
+            // 1. 目标连接在本线程，直接转发
+            if (forwardOnManager(*msquicManager, *msquicManager, data, requestTypeStr)) {
+                return;
+            }
+
+            // 2. 路由缓存命中则先投递到缓存的线程，否则询问映射表所在的线程
+            tbb::concurrent_lru_cache<std::string, int>::handle handles = msquicManager->localRouteCache[data->targetId];
+
+            std::shared_ptr<hope::quic::MsquicManager> origin = msquicManager->shared_from_this();
+
+            if (handles.value() == -1) {
+                forwardByMapping(std::move(origin), std::move(data), requestTypeStr);
+                return;
+            }
+
+            // 闭包只捕获两个 shared_ptr 和一个字面量指针，放得进 MsquicTask 的内联缓冲
+            msquicManager->msquicServer->postTaskAsync(handles.value(), [origin, data = std::move(data), requestTypeStr](std::shared_ptr<hope::quic::MsquicManager> manager) mutable {
+                if (!forwardOnManager(*manager, *origin, data, requestTypeStr)) {
+                    // 缓存已过期，回退到映射表
+                    forwardByMapping(std::move(origin), std::move(data), requestTypeStr);
+                }
+                });
+        }
+
+        void MsquicLogicSystem::forwardByMapping(std::shared_ptr<hope::quic::MsquicManager> origin, std::shared_ptr<hope::quic::MsquicData> data, const char* requestTypeStr) {
+
+            int mapChannelIndex = origin->hasher(data->targetId) % origin->hashSize;
+
+            hope::quic::MsquicServer* msquicServer = origin->msquicServer;
+
+            msquicServer->postTaskAsync(mapChannelIndex, [origin = std::move(origin), data = std::move(data), requestTypeStr](std::shared_ptr<hope::quic::MsquicManager> manager) mutable {
+
+                auto it = manager->actorSocketMappingIndex.find(data->targetId);
+
+                if (it == manager->actorSocketMappingIndex.end()) {
+                    replyNotFound(*data, requestTypeStr);
+                    return;
+                }
+
+                int targetChannelIndex = it->second;
+
+                hope::quic::MsquicServer* msquicServer = origin->msquicServer;
+
+                msquicServer->postTaskAsync(targetChannelIndex, [origin = std::move(origin), data = std::move(data), requestTypeStr](std::shared_ptr<hope::quic::MsquicManager> manager) {
+                    if (!forwardOnManager(*manager, *origin, data, requestTypeStr)) {
+                        replyNotFound(*data, requestTypeStr);
+                    }
+                    });
+                });
+        }
+
+        bool MsquicLogicSystem::forwardOnManager(hope::quic::MsquicManager& manager, hope::quic::MsquicManager& origin, const std::shared_ptr<hope::quic::MsquicData>& data, const char* requestTypeStr) {
+
+            std::shared_ptr<hope::quic::MsquicSocketInterface> targetSocket;
+
+            {
+                auto it = manager.msquicSocketInterfaceMap.find(data->targetId);
+
+                if (it == manager.msquicSocketInterfaceMap.end()) {
+                    return false;
+                }
+
+                targetSocket = it->second;
+            }
+
+            // 记住目标所在的线程，下次直接投递
+            if (&manager != &origin) {
+                if (tbb::concurrent_lru_cache<std::string, int>::handle handles = origin.localRouteCache[data->targetId]) {
+                    handles.value() = manager.channelIndex;
+                }
+            }
+
+            if (data->requestType == hope::quic::BULK_REQUEST_TYPE) {
+
+                if (!data->bulkRelay) {
+                    return true;
+                }
+
+                // 数据不经过发送队列，在目标连接上开单向流逐块中转；WebSocket 目标没有对应的流
+                hope::quic::MsquicBulkRelay& relay = *data->bulkRelay;
+
+                if (targetSocket->getType() != hope::quic::SocketType::MsquicSocket
+                    || !relay.attach(*static_cast<hope::quic::MsquicSocket*>(targetSocket.get()), data->accountId)) {
+
+                    relay.abort(hope::quic::BULK_ERROR_UNSUPPORTED);
+
+                    LOG_WARNING("Bulk transfer unsupported: %s -> %s", data->accountId.c_str(), data->targetId.c_str());
+
+                    return true;
+                }
+
+                LOG_INFO_DEFERRED("Bulk transfer: %s -> %s", data->accountId.c_str(), data->targetId.c_str());
+
+                return true;
+            }
+
+            if (data->requestType == hope::quic::DATAGRAM_REQUEST_TYPE) {
+
+                auto [datagram, datagramSize] = buildDatagram(targetSocket.get(), data->accountId, data->payload);
+
+                // 已交给 msquic 或已丢弃都算完成，不打日志，实时事件的量太大
+                if (targetSocket->writeDatagram(datagram, datagramSize)) {
+                    return true;
+                }
+            }
+
+            // 压缩负载只在转成 JSON 时解压，二进制目标原样收到压缩数据
+            if (targetSocket->getProtocol() != hope::quic::WireProtocol::Binary && !data->inflate()) {
+                LOG_ERROR("Binary payload decompress error, flags: %u", static_cast<unsigned>(data->compressionFlags));
+                return true;
+            }
+
+            // 按目标协议构建转发消息
+            auto [buffer, size] = buildForwardMessage(*data, targetSocket.get());
+
+            // 目标发送队列已满，告诉发送方稍后重试
+            if (!targetSocket->tryWriteAsync(buffer, size, trafficClassOf(data->requestType))) {
+                replyBusy(*data, requestTypeStr);
+                return true;
+            }
+
+            LOG_INFO_DEFERRED("Request forward: %s -> %s (Request Type: %s)", data->accountId.c_str(), data->targetId.c_str(), requestTypeStr);
+
+            return true;
+        }
+
+        void MsquicLogicSystem::replyNotFound(hope::quic::MsquicData& data, const char* requestTypeStr) {
+
+            // DATAGRAM 本身不可靠，目标不在线直接丢弃
+            if (data.requestType == hope::quic::DATAGRAM_REQUEST_TYPE) {
+                hope::utils::MsquicMetrics::add(hope::utils::MsquicMetrics::instance().datagramsDropped);
+                return;
+            }
+
+            // 批量传输先中止源流，发送方不必等流控超时，再照常回复 404
+            if (data.bulkRelay) {
+                data.bulkRelay->abort(hope::quic::BULK_ERROR_NOT_FOUND);
+            }
+
+            hope::quic::MsquicResponse response{ data.requestType, 404, "TargetId is not register" };
+
+            auto [buffer, size] = buildMessage(response, data.msquicSocketInterface.get());
+            data.msquicSocketInterface->writeAsync(buffer, size, trafficClassOf(data.requestType));
+
+            LOG_WARNING_DEFERRED("Request forward Not Found (404): %s -> %s (Request Type: %s)", data.accountId.c_str(), data.targetId.c_str(), requestTypeStr);
+        }
+
+        void MsquicLogicSystem::replyBusy(hope::quic::MsquicData& data, const char* requestTypeStr) {
+
+            if (data.requestType == hope::quic::DATAGRAM_REQUEST_TYPE) {
+                hope::utils::MsquicMetrics::add(hope::utils::MsquicMetrics::instance().datagramsDropped);
+                return;
+            }
+
+            hope::quic::MsquicResponse response{ data.requestType, 503, "TargetId is busy" };
+
+            auto [buffer, size] = buildMessage(response, data.msquicSocketInterface.get());
+            data.msquicSocketInterface->writeAsync(buffer, size, trafficClassOf(data.requestType));
+
+            LOG_WARNING_DEFERRED("Request forward Busy (503): %s -> %s (Request Type: %s)", data.accountId.c_str(), data.targetId.c_str(), requestTypeStr);
+        }
+
+        void MsquicLogicSystem::registerHandler(std::shared_ptr<hope::quic::MsquicData> data) {
+
+            hope::quic::MsquicSocket *  msquicSocket = nullptr;
+
+            hope::quic::WebRTCSignalSocket * webrtcSignalSocket = nullptr;
+
+            if (data->msquicSocketInterface->getType() == hope::quic::SocketType::MsquicSocket) {
+            
+                msquicSocket = static_cast<hope::quic::MsquicSocket*>(data->msquicSocketInterface.get());
+
+            }
+            else if (data->msquicSocketInterface->getType() == hope::quic::SocketType::WebSocket) {
+            
+                webrtcSignalSocket = static_cast<hope::quic::WebRTCSignalSocket*>(data->msquicSocketInterface.get());
+
+            }
+
+            hope::quic::MsquicResponse response{ 0, 200, "register successful" };
+
+            hope::quic::RegisterRequest request;
+
+            const char* missingField = nullptr;
+
+            bool decoded = hope::quic::decodeRequest(*data, request, missingField);
+
+            std::string accountId;
+
+            if (msquicSocket) {
+
+                if (!decoded) {
+
+                    LOG_WARNING("REGISTER Message Missing %s.", missingField);
+
+                    response.state = 500;
+
+                    response.message = "REGISTER Message Missing accountId.";
+
+                    // 修改这里：构建二进制消息
+                    auto [buffer, size] = buildMessage(response, msquicSocket);
+
+                    msquicSocket->writeAsync(buffer, size, hope::quic::TrafficClass::Control);
+
+                    return;
+                }
+
+                accountId = std::move(request.accountId);
+
+                msquicSocket->setAccountId(accountId);
+
+                msquicSocket->setRegistered(true);
+
+                data->msquicManager->msquicSocketInterfaceMap[accountId] = data->msquicSocketInterface;
+            }
+            else if (webrtcSignalSocket) {
+
+                if (!decoded) {
+
+                    LOG_WARNING("REGISTER Message Missing %s.", missingField);
+
+                    response.state = 500;
+
+                    response.message = "REGISTER Message Missing accountId.";
+
+                    // 修改这里：构建二进制消息
+                    auto [buffer, size] = buildMessage(response, webrtcSignalSocket);
+
+                    webrtcSignalSocket->writeAsync(buffer, size);
+                    
+                    return;
+                }
+
+                accountId = std::move(request.accountId);
+
+                webrtcSignalSocket->setAccountId(accountId);
+
+                webrtcSignalSocket->setRegistered(true);
+
+                data->msquicManager->msquicSocketInterfaceMap[accountId] = data->msquicSocketInterface;
+
+            }
+            else {
+            
+                LOG_ERROR("Unknow SocketType:%d", static_cast<int>(data->msquicSocketInterface->getType()));
+
+            }
+
+            // 修改这里：构建二进制消息
+            auto [buffer, size] = buildMessage(response, data->msquicSocketInterface.get());
+
+            data->msquicSocketInterface->writeAsync(buffer, size, hope::quic::TrafficClass::Control);
+
+            int mapChannelIndex = data->msquicManager->hasher(accountId) % data->msquicManager->hashSize;
+
+            data->msquicManager->msquicServer->postTaskAsync(mapChannelIndex, [channelIndex = data->msquicManager->channelIndex, data](std::shared_ptr<hope::quic::MsquicManager> manager) {
+                manager->actorSocketMappingIndex[data->accountId] = channelIndex;
+                });
+
+            LOG_INFO("User Register Successful : %s (channelIndex: %d)", accountId.c_str(), data->msquicManager->channelIndex);
+        }
+
+        void MsquicLogicSystem::requestHandler(std::shared_ptr<hope::quic::MsquicData> data) {
+
+            forwardHandler(std::move(data), "REQUEST");
+        }
+
+        void MsquicLogicSystem::restartHandler(std::shared_ptr<hope::quic::MsquicData> data) {
+
+            forwardHandler(std::move(data), "RESTART");
+        }
+
+        void MsquicLogicSystem::stopRemoteHandler(std::shared_ptr<hope::quic::MsquicData> data) {
+
+            forwardHandler(std::move(data), "STOPREMOTE");
+        }
+
+        void MsquicLogicSystem::datagramHandler(std::shared_ptr<hope::quic::MsquicData> data) {
+
+            // 只有 MsquicSocket 会收到 DATAGRAM，源 ID 在注册所在的逻辑线程上读取
+            if (data->msquicSocketInterface->getType() != hope::quic::SocketType::MsquicSocket) {
+                return;
+            }
+
+            data->accountId = static_cast<hope::quic::MsquicSocket*>(data->msquicSocketInterface.get())->getAccountId();
+
+            forwardHandler(std::move(data), "DATAGRAM");
+        }
+
+        void MsquicLogicSystem::bulkHandler(std::shared_ptr<hope::quic::MsquicData> data) {
+
+            // 只有 requestBulkRoute 会带中转对象，流上的帧在收包时已丢弃，这里再兜底一次
+            if (!data->bulkRelay || data->msquicSocketInterface->getType() != hope::quic::SocketType::MsquicSocket) {
+                return;
+            }
+
+            data->accountId = static_cast<hope::quic::MsquicSocket*>(data->msquicSocketInterface.get())->getAccountId();
+
+            // 未注册的连接没有源 ID
+            if (data->accountId.empty()) {
+                data->bulkRelay->abort(hope::quic::BULK_ERROR_ABORTED);
+                return;
+            }
+
+            forwardHandler(std::move(data), "BULK");
+        }
+
+        void MsquicLogicSystem::disconnectHandler(std::shared_ptr<hope::quic::MsquicData> data) {
+
+            hope::quic::MsquicSocket* msquicSocket = nullptr;
+
+            hope::quic::WebRTCSignalSocket* webrtcSignalSocket = nullptr;
+
+            if (data->msquicSocketInterface->getType() == hope::quic::SocketType::MsquicSocket) {
+
+                msquicSocket = static_cast<hope::quic::MsquicSocket*>(data->msquicSocketInterface.get());
+
+            }
+            else if (data->msquicSocketInterface->getType() == hope::quic::SocketType::WebSocket) {
+
+                webrtcSignalSocket = static_cast<hope::quic::WebRTCSignalSocket*>(data->msquicSocketInterface.get());
+
+            }
+
+            std::string accountId;
+
+            if (msquicSocket) {
+
+                accountId = msquicSocket->getAccountId();
+
+            }
+            else if (webrtcSignalSocket) {
+
+                accountId = webrtcSignalSocket->getAccountId();
+
+            }
+            else {
+
+                LOG_ERROR("Unknow SocketType:%d", static_cast<int>(data->msquicSocketInterface->getType()));
+
+            }
+
+
+            if (!accountId.empty()) {
+
+                data->msquicManager->removeConnection(accountId);
+
+            }
+        }
+
+    }
+
+}
+
+
+
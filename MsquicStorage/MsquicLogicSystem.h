@@ -1,62 +1,142 @@
-#pragma once
-
-#include <unordered_map>
-#include <memory>
-#include <functional>
-#include <utility>
-
-#include <boost/asio.hpp>
-#include <boost/json.hpp>
-#include <boost/asio/experimental/concurrent_channel.hpp>
-#include "concurrentqueue.h"
-
-
-namespace hope {
-
-	namespace quic {
-
-		class MsquicData;
-
-	}
-
-	namespace mysql {
-	
-		class MsquicMysqlManager;
-
-	}
-
-	namespace handle {
-
-
-		class MsquicLogicSystem : public std::enable_shared_from_this<MsquicLogicSystem>
-		{
-
-		public:
-
-			MsquicLogicSystem(boost::asio::io_context& ioContext);
-
-			~MsquicLogicSystem();
-
-			MsquicLogicSystem(const MsquicLogicSystem& logic) = delete;
-
-			void operator=(const MsquicLogicSystem& logic) = delete;
-
-			void postTaskAsync(std::shared_ptr<hope::quic::MsquicData> data);
-
-			void RunEventLoop();
-
-			boost::asio::io_context& getIoCompletePorts();
-
-		private:
-
-			void initHandlers();
-
-			boost::asio::io_context & ioContext;
-
-			std::unordered_map<int, std::pair<bool, std::function<boost::asio::awaitable<void>(std::shared_ptr<hope::quic::MsquicData>,std::shared_ptr<hope::mysql::MsquicMysqlManager>)>>> msquicHandlers;
-
-		};
-	}
-
-}
-
+#pragma once
+
+#include <array>
+#include <memory>
+#include <functional>
+#include <utility>
+
+#include <boost/asio.hpp>
+#include <boost/json.hpp>
+#include <boost/asio/experimental/concurrent_channel.hpp>
+#include "concurrentqueue.h"
+#include "MsquicProtocol.h"
+
+
+namespace hope {
+
+	namespace quic {
+
+		class MsquicData;
+
+		class MsquicManager;
+
+	}
+
+	namespace mysql {
+	
+		class MsquicMysqlManager;
+
+	}
+
+	namespace handle {
+
+		// handler 对数据库的需求，决定派发前从哪个连接池取连接
+		enum class MsquicDatabaseAccess {
+
+			None = 0,          // 不访问数据库
+
+			Pooled = 1,        // 普通连接
+
+			Transaction = 2,   // 事务连接，handler 结束后归还
+
+		};
+
+		class MsquicLogicSystem;
+
+		struct MsquicHandlerEntry {
+
+			using Handler = boost::asio::awaitable<void> (MsquicLogicSystem::*)(std::shared_ptr<hope::quic::MsquicData>, std::shared_ptr<hope::mysql::MsquicMysqlManager>);
+
+			// 不会挂起的 handler，由 postTaskAsync 直接调用
+			using SyncHandler = void (MsquicLogicSystem::*)(std::shared_ptr<hope::quic::MsquicData>);
+
+			// 两者只能登记一个
+			Handler handler = nullptr;
+
+			SyncHandler syncHandler = nullptr;
+
+			MsquicDatabaseAccess database = MsquicDatabaseAccess::None;
+
+			// 该请求及其转发、回复走哪条发送通道
+			hope::quic::TrafficClass trafficClass = hope::quic::TrafficClass::Signalling;
+
+			const char* name = "";
+
+			constexpr bool registered() const { return handler != nullptr || syncHandler != nullptr; }
+
+			constexpr bool suspends() const { return handler != nullptr; }
+
+		};
+
+		class MsquicLogicSystem : public std::enable_shared_from_this<MsquicLogicSystem>
+		{
+
+		public:
+
+			MsquicLogicSystem(boost::asio::io_context& ioContext);
+
+			~MsquicLogicSystem();
+
+			MsquicLogicSystem(const MsquicLogicSystem& logic) = delete;
+
+			void operator=(const MsquicLogicSystem& logic) = delete;
+
+			void postTaskAsync(std::shared_ptr<hope::quic::MsquicData> data);
+
+			void RunEventLoop();
+
+			boost::asio::io_context& getIoCompletePorts();
+
+		private:
+
+			static constexpr size_t REQUEST_TYPE_COUNT = 7;
+
+			using HandlerTable = std::array<MsquicHandlerEntry, REQUEST_TYPE_COUNT>;
+
+			// 以 requestType 为下标的稠密派发表，编译期确定
+			static const HandlerTable handlerTable;
+
+			static constexpr bool validHandlerTable(const HandlerTable& table);
+
+			// 未登记的类型按信令处理
+			static hope::quic::TrafficClass trafficClassOf(int64_t requestType);
+
+			void runSyncHandler(const MsquicHandlerEntry* entry, std::shared_ptr<hope::quic::MsquicData> data);
+
+			void registerHandler(std::shared_ptr<hope::quic::MsquicData> data);
+
+			void requestHandler(std::shared_ptr<hope::quic::MsquicData> data);
+
+			void restartHandler(std::shared_ptr<hope::quic::MsquicData> data);
+
+			void stopRemoteHandler(std::shared_ptr<hope::quic::MsquicData> data);
+
+			void disconnectHandler(std::shared_ptr<hope::quic::MsquicData> data);
+
+			// 不可靠中转：补上源 ID 后走转发路由，目标不支持 DATAGRAM 时退回流上转发，出错不回复
+			void datagramHandler(std::shared_ptr<hope::quic::MsquicData> data);
+
+			// 批量传输：补上源 ID 后走转发路由，在目标连接上开单向流中转，目标不在线或不支持时中止源流
+			void bulkHandler(std::shared_ptr<hope::quic::MsquicData> data);
+
+			// 转发类请求共用
+			void forwardHandler(std::shared_ptr<hope::quic::MsquicData> data, const char* requestTypeStr);
+
+			// 经目标 ID 哈希到的映射线程查出目标所在线程，再投递过去转发
+			static void forwardByMapping(std::shared_ptr<hope::quic::MsquicManager> origin, std::shared_ptr<hope::quic::MsquicData> data, const char* requestTypeStr);
+
+			// 目标连接在 manager 上则转发并更新 origin 的路由缓存，否则返回 false
+			static bool forwardOnManager(hope::quic::MsquicManager& manager, hope::quic::MsquicManager& origin, const std::shared_ptr<hope::quic::MsquicData>& data, const char* requestTypeStr);
+
+			static void replyNotFound(hope::quic::MsquicData& data, const char* requestTypeStr);
+
+			// 目标发送队列已满
+			static void replyBusy(hope::quic::MsquicData& data, const char* requestTypeStr);
+
+			boost::asio::io_context & ioContext;
+
+		};
+	}
+
+}
+
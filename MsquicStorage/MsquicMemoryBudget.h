@@ -0,0 +1,156 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+namespace hope {
+    namespace utils {
+
+        // 超出预算时的处理方式
+        enum class MemoryBudgetAction {
+
+            Reject = 0,       // 丢弃新的帧或任务，转发方回复 503
+
+            Disconnect = 1,   // 断开超出预算的会话
+
+        };
+
+        // 内存记账：接收缓冲、发送队列和排队中的任务记在所属会话上，同时累加到全局预算
+        // 只做 relaxed 原子加减，记的是逻辑字节数，不追踪实际分配
+        class MsquicMemoryBudget {
+        public:
+
+            // 会话预算，上限取 configure 设置的会话值，上级为全局预算
+            MsquicMemoryBudget()
+                : limitBytes(settings().sessionLimit)
+                , parent(&global()) {
+            }
+
+            MsquicMemoryBudget(const MsquicMemoryBudget&) = delete;
+
+            MsquicMemoryBudget& operator=(const MsquicMemoryBudget&) = delete;
+
+            // 会话销毁时还没归还的部分一并从全局扣掉
+            ~MsquicMemoryBudget() {
+
+                if (parent) {
+                    parent->release(usedBytes.load(std::memory_order_relaxed));
+                }
+            }
+
+            static MsquicMemoryBudget& global() {
+
+                static MsquicMemoryBudget budget(0, nullptr);
+
+                return budget;
+            }
+
+            // 启动时由 MsquicServer::initialize 调用一次，0 表示不限；之后创建的会话使用新的会话上限
+            static void configure(size_t sessionLimit, size_t globalLimit, MemoryBudgetAction action) {
+
+                settings().sessionLimit = sessionLimit;
+
+                settings().action = action;
+
+                global().limitBytes = globalLimit;
+            }
+
+            static MemoryBudgetAction action() {
+
+                return settings().action;
+            }
+
+            static MemoryBudgetAction actionFromName(const std::string& name) {
+
+                return name == "disconnect" ? MemoryBudgetAction::Disconnect : MemoryBudgetAction::Reject;
+            }
+
+            // 本级和上级都放得下才记账，否则不记账返回 false
+            bool tryCharge(size_t bytes) {
+
+                size_t used = usedBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+                if ((limitBytes != 0 && used > limitBytes) || (parent && !parent->tryCharge(bytes))) {
+
+                    usedBytes.fetch_sub(bytes, std::memory_order_relaxed);
+
+                    return false;
+                }
+
+                return true;
+            }
+
+            // 已经占用、无法拒绝的内存（例如半帧的接收缓冲）直接记账，再用 exceeded 判断
+            void charge(size_t bytes) {
+
+                usedBytes.fetch_add(bytes, std::memory_order_relaxed);
+
+                if (parent) {
+                    parent->charge(bytes);
+                }
+            }
+
+            void release(size_t bytes) {
+
+                usedBytes.fetch_sub(bytes, std::memory_order_relaxed);
+
+                if (parent) {
+                    parent->release(bytes);
+                }
+            }
+
+            // 其他线程上的近似判断，用于提前拒收
+            bool wouldExceed(size_t bytes) const {
+
+                if (limitBytes != 0 && usedBytes.load(std::memory_order_relaxed) + bytes > limitBytes) {
+                    return true;
+                }
+
+                return parent && parent->wouldExceed(bytes);
+            }
+
+            bool exceeded() const {
+
+                return wouldExceed(0);
+            }
+
+            size_t used() const {
+
+                return usedBytes.load(std::memory_order_relaxed);
+            }
+
+            size_t limit() const {
+
+                return limitBytes;
+            }
+
+        private:
+
+            struct Settings {
+
+                size_t sessionLimit = 0;
+
+                MemoryBudgetAction action = MemoryBudgetAction::Reject;
+
+            };
+
+            static Settings& settings() {
+
+                static Settings values;
+
+                return values;
+            }
+
+            MsquicMemoryBudget(size_t limit, MsquicMemoryBudget* parent)
+                : limitBytes(limit)
+                , parent(parent) {
+            }
+
+            std::atomic<size_t> usedBytes{ 0 };
+
+            size_t limitBytes;
+
+            MsquicMemoryBudget* parent;
+        };
+    }
+}
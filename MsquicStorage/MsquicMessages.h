@@ -0,0 +1,539 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include <boost/describe.hpp>
+#include <boost/mp11.hpp>
+#include <boost/json.hpp>
+
+namespace hope {
+
+	namespace quic {
+
+		// 所有请求共有的路由字段，收包时由 JsonStructHandler 一次解析得到
+		struct MsquicRoute {
+
+			int64_t requestType = -1;
+
+			std::string accountId;
+
+			std::string targetId;
+
+		};
+
+		BOOST_DESCRIBE_STRUCT(MsquicRoute, (), (requestType, accountId, targetId))
+
+		struct RegisterRequest {
+
+			int64_t requestType = 0;
+
+			std::string accountId;
+
+		};
+
+		BOOST_DESCRIBE_STRUCT(RegisterRequest, (), (requestType, accountId))
+
+		// 视图指向 MsquicData 中的路由字段，不拷贝
+		struct ForwardRequest {
+
+			int64_t requestType = 0;
+
+			std::string_view accountId;
+
+			std::string_view targetId;
+
+		};
+
+		BOOST_DESCRIBE_STRUCT(ForwardRequest, (), (requestType, accountId, targetId))
+
+		// 服务端应答，message 一般是字面量
+		struct MsquicResponse {
+
+			int64_t requestType = 0;
+
+			int64_t state = 0;
+
+			std::string_view message;
+
+		};
+
+		BOOST_DESCRIBE_STRUCT(MsquicResponse, (), (requestType, state, message))
+
+		template<class T>
+		using MsquicMembers = boost::describe::describe_members<T, boost::describe::mod_public>;
+
+		constexpr bool fieldNameEquals(const char* a, const char* b) {
+
+			while (*a && *a == *b) {
+				++a;
+				++b;
+			}
+
+			return *a == *b;
+		}
+
+		// SAX 处理器：按编译期字段表把顶层键直接写进 T，其余内容只做语法校验
+		// 支持的字段类型：int64_t、std::string，类型不符在这里统一报错
+		template<class T>
+		class JsonStructHandler {
+
+		public:
+
+			constexpr static std::size_t max_object_size = std::size_t(-1);
+
+			constexpr static std::size_t max_array_size = std::size_t(-1);
+
+			constexpr static std::size_t max_key_size = std::size_t(-1);
+
+			constexpr static std::size_t max_string_size = std::size_t(-1);
+
+			static_assert(boost::mp11::mp_size<MsquicMembers<T>>::value <= 64, "too many fields");
+
+			explicit JsonStructHandler(T& object) : object(object) {}
+
+			// 第 i 个字段出现过则置位
+			uint64_t seen = 0;
+
+			// 顶层对象的成员个数
+			size_t memberCount = 0;
+
+			// 顶层出现了 watchKeys 登记的键（这些键不写进 T）
+			bool watchedKeySeen = false;
+
+			// keys 由调用方保证在解析期间有效
+			void watchKeys(const std::string_view* keys, size_t count) {
+
+				watchedKeys = keys;
+
+				watchedKeyCount = count;
+			}
+
+			bool seenField(std::string_view name) const {
+
+				size_t index = 0;
+
+				bool result = false;
+
+				boost::mp11::mp_for_each<MsquicMembers<T>>([&](auto D) {
+					if (name == D.name) {
+						result = (seen & (uint64_t(1) << index)) != 0;
+					}
+					index++;
+					});
+
+				return result;
+			}
+
+			bool on_document_begin(boost::json::error_code&) { return true; }
+
+			bool on_document_end(boost::json::error_code&) { return true; }
+
+			bool on_object_begin(boost::json::error_code& ec) {
+
+				if (depth == 1 && field != NO_FIELD) {
+					return mismatch(ec);
+				}
+
+				depth++;
+
+				return true;
+			}
+
+			bool on_object_end(std::size_t n, boost::json::error_code&) {
+
+				if (--depth == 0) {
+					memberCount = n;
+				}
+
+				return true;
+			}
+
+			bool on_array_begin(boost::json::error_code& ec) {
+
+				if (depth == 0) {
+					ec = boost::json::error::not_object;
+					return false;
+				}
+
+				if (depth == 1 && field != NO_FIELD) {
+					return mismatch(ec);
+				}
+
+				depth++;
+
+				return true;
+			}
+
+			bool on_array_end(std::size_t, boost::json::error_code&) {
+
+				depth--;
+
+				return true;
+			}
+
+			bool on_key_part(boost::json::string_view s, std::size_t, boost::json::error_code&) {
+
+				if (depth == 1) {
+					key.append(s.data(), s.size());
+				}
+
+				return true;
+			}
+
+			bool on_key(boost::json::string_view s, std::size_t, boost::json::error_code&) {
+
+				if (depth != 1) {
+					return true;
+				}
+
+				key.append(s.data(), s.size());
+
+				field = NO_FIELD;
+
+				size_t index = 0;
+
+				boost::mp11::mp_for_each<MsquicMembers<T>>([&](auto D) {
+					if (key == D.name) {
+						field = index;
+					}
+					index++;
+					});
+
+				// 重复键以后出现的为准
+				if (field != NO_FIELD) {
+					seen |= uint64_t(1) << field;
+					visitField([](auto& member) {
+						if constexpr (std::is_same_v<std::decay_t<decltype(member)>, std::string>) {
+							member.clear();
+						}
+						});
+				}
+				else {
+
+					for (size_t i = 0; i < watchedKeyCount; i++) {
+						watchedKeySeen |= key == watchedKeys[i];
+					}
+				}
+
+				key.clear();
+
+				return true;
+			}
+
+			bool on_string_part(boost::json::string_view s, std::size_t, boost::json::error_code& ec) {
+
+				return appendString(s, ec);
+			}
+
+			bool on_string(boost::json::string_view s, std::size_t, boost::json::error_code& ec) {
+
+				if (!appendString(s, ec)) {
+					return false;
+				}
+
+				if (depth == 1) {
+					field = NO_FIELD;
+				}
+
+				return true;
+			}
+
+			bool on_number_part(boost::json::string_view, boost::json::error_code&) { return true; }
+
+			bool on_int64(int64_t i, boost::json::string_view, boost::json::error_code& ec) {
+
+				if (depth == 0) {
+					ec = boost::json::error::not_object;
+					return false;
+				}
+
+				if (depth == 1 && field != NO_FIELD) {
+
+					bool assigned = false;
+
+					visitField([&](auto& member) {
+						if constexpr (std::is_same_v<std::decay_t<decltype(member)>, int64_t>) {
+							member = i;
+							assigned = true;
+						}
+						});
+
+					field = NO_FIELD;
+
+					if (!assigned) {
+						ec = boost::json::error::not_string;
+						return false;
+					}
+				}
+
+				return true;
+			}
+
+			bool on_uint64(uint64_t, boost::json::string_view, boost::json::error_code& ec) { return scalar(ec); }
+
+			bool on_double(double, boost::json::string_view, boost::json::error_code& ec) { return scalar(ec); }
+
+			bool on_bool(bool, boost::json::error_code& ec) { return scalar(ec); }
+
+			bool on_null(boost::json::error_code& ec) { return scalar(ec); }
+
+			bool on_comment_part(boost::json::string_view, boost::json::error_code&) { return true; }
+
+			bool on_comment(boost::json::string_view, boost::json::error_code&) { return true; }
+
+		private:
+
+			static constexpr size_t NO_FIELD = size_t(-1);
+
+			const std::string_view* watchedKeys = nullptr;
+
+			size_t watchedKeyCount = 0;
+
+			template<class F>
+			void visitField(F&& f) {
+
+				size_t index = 0;
+
+				boost::mp11::mp_for_each<MsquicMembers<T>>([&](auto D) {
+					if (index++ == field) {
+						f(object.*D.pointer);
+					}
+					});
+			}
+
+			// 字段类型和 JSON 值类型不符
+			bool mismatch(boost::json::error_code& ec) {
+
+				bool isString = false;
+
+				visitField([&](auto& member) {
+					isString = std::is_same_v<std::decay_t<decltype(member)>, std::string>;
+					});
+
+				ec = isString ? boost::json::error::not_string : boost::json::error::not_int64;
+
+				return false;
+			}
+
+			bool appendString(boost::json::string_view s, boost::json::error_code& ec) {
+
+				if (depth == 0) {
+					ec = boost::json::error::not_object;
+					return false;
+				}
+
+				if (depth == 1 && field != NO_FIELD) {
+
+					bool assigned = false;
+
+					visitField([&](auto& member) {
+						if constexpr (std::is_same_v<std::decay_t<decltype(member)>, std::string>) {
+							member.append(s.data(), s.size());
+							assigned = true;
+						}
+						});
+
+					if (!assigned) {
+						return mismatch(ec);
+					}
+				}
+
+				return true;
+			}
+
+			bool scalar(boost::json::error_code& ec) {
+
+				if (depth == 0) {
+					ec = boost::json::error::not_object;
+					return false;
+				}
+
+				if (depth == 1 && field != NO_FIELD) {
+					return mismatch(ec);
+				}
+
+				return true;
+			}
+
+			T& object;
+
+			size_t field = NO_FIELD;
+
+			int depth = 0;
+
+			std::string key;
+
+		};
+
+		template<class D>
+		struct SameFieldName {
+
+			template<class R>
+			using fn = std::bool_constant<fieldNameEquals(D::name, R::name)>;
+
+		};
+
+		// 把已解析的路由字段按同名字段投影到具体请求，名字在编译期匹配，字符串字段为空视为缺失
+		// missing 返回第一个缺失字段的名字
+		template<class Request>
+		bool decodeRequest(const MsquicRoute& route, Request& request, const char*& missing) {
+
+			missing = nullptr;
+
+			boost::mp11::mp_for_each<MsquicMembers<Request>>([&](auto D) {
+
+				using RequestField = decltype(D);
+
+				static_assert(boost::mp11::mp_any_of_q<MsquicMembers<MsquicRoute>, SameFieldName<RequestField>>::value,
+					"request field is not a routing field");
+
+				using RouteField = boost::mp11::mp_at<MsquicMembers<MsquicRoute>,
+					boost::mp11::mp_find_if_q<MsquicMembers<MsquicRoute>, SameFieldName<RequestField>>>;
+
+				auto& member = request.*RequestField::pointer;
+
+				member = route.*RouteField::pointer;
+
+				using Member = std::decay_t<decltype(member)>;
+
+				if constexpr (std::is_same_v<Member, std::string> || std::is_same_v<Member, std::string_view>) {
+
+					if (member.empty() && !missing) {
+						missing = RequestField::name;
+					}
+
+				}
+
+				});
+
+			return missing == nullptr;
+		}
+
+		// 只统计长度的输出，和 JsonBufferWriter 配合做两遍编码
+		class JsonSizeCounter {
+
+		public:
+
+			void push_back(char) { size++; }
+
+			void append(const char* data) { size += strlen(data); }
+
+			void append(const char* data, size_t length) { size += length; }
+
+			size_t size = 0;
+
+		};
+
+		// 直接写进调用方分配好的缓冲区，长度由 JsonSizeCounter 预先算出
+		class JsonBufferWriter {
+
+		public:
+
+			explicit JsonBufferWriter(char* cursor) : cursor(cursor) {}
+
+			void push_back(char c) { *cursor++ = c; }
+
+			void append(const char* data) { append(data, strlen(data)); }
+
+			void append(const char* data, size_t length) {
+
+				memcpy(cursor, data, length);
+
+				cursor += length;
+			}
+
+			char* cursor;
+
+		};
+
+		template<class Out>
+		void appendJsonString(Out& out, std::string_view s) {
+
+			static constexpr char HEX[] = "0123456789abcdef";
+
+			out.push_back('"');
+
+			for (char c : s) {
+
+				unsigned char u = static_cast<unsigned char>(c);
+
+				if (c == '"' || c == '\\') {
+					out.push_back('\\');
+					out.push_back(c);
+				}
+				else if (u < 0x20) {
+					out.append("\\u00");
+					out.push_back(HEX[u >> 4]);
+					out.push_back(HEX[u & 0xF]);
+				}
+				else {
+					out.push_back(c);
+				}
+			}
+
+			out.push_back('"');
+		}
+
+		// 按字段表直接序列化，不经过 boost::json::object
+		// Out 可以是 std::string、JsonSizeCounter 或 JsonBufferWriter
+		template<class T, class Out>
+		void encodeJson(const T& object, Out& out) {
+
+			out.push_back('{');
+
+			bool first = true;
+
+			boost::mp11::mp_for_each<MsquicMembers<T>>([&](auto D) {
+
+				if (!first) {
+					out.push_back(',');
+				}
+
+				first = false;
+
+				out.push_back('"');
+
+				out.append(D.name);
+
+				out.append("\":", 2);
+
+				using Member = std::decay_t<decltype(object.*D.pointer)>;
+
+				if constexpr (std::is_integral_v<Member>) {
+
+					char number[24];
+
+					auto result = std::to_chars(number, number + sizeof(number), object.*D.pointer);
+
+					out.append(number, static_cast<size_t>(result.ptr - number));
+
+				}
+				else {
+
+					appendJsonString(out, std::string_view(object.*D.pointer));
+
+				}
+
+				});
+
+			out.push_back('}');
+		}
+
+		template<class T>
+		size_t encodedJsonSize(const T& object) {
+
+			JsonSizeCounter counter;
+
+			encodeJson(object, counter);
+
+			return counter.size;
+		}
+
+	}
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace hope {
+    namespace utils {
+
+        // 进程级计数器，只做 relaxed 累加，由 MsquicServer 定期打印
+        // 每个计数器独占一条缓存行，避免多个 MsquicManager 线程互相踩
+        struct MsquicMetrics {
+
+            static MsquicMetrics& instance() {
+                static MsquicMetrics metrics;
+                return metrics;
+            }
+
+            static void add(std::atomic<uint64_t>& counter, uint64_t value = 1) {
+                counter.fetch_add(value, std::memory_order_relaxed);
+            }
+
+            static uint64_t load(const std::atomic<uint64_t>& counter) {
+                return counter.load(std::memory_order_relaxed);
+            }
+
+            // MsquicServer::postTaskAsync 投递的跨线程任务数
+            alignas(64) std::atomic<uint64_t> tasksPosted{ 0 };
+
+            // 放不进 MsquicFunction 内联缓冲、退化为堆分配的任务数，稳态下应保持不变
+            alignas(64) std::atomic<uint64_t> taskHeapAllocations{ 0 };
+
+            // 对象池取空（MsquicData、SendBatch）或池化容器扩容时的堆分配次数，稳态下应保持不变
+            // 转发路径上其余的内存都来自 MsquicBufferPool（slab 数见 bufferSlabs）或 asio 的 recycling_allocator
+            alignas(64) std::atomic<uint64_t> poolHeapAllocations{ 0 };
+
+            // 同步 handler 直接执行的次数
+            alignas(64) std::atomic<uint64_t> inlineHandlers{ 0 };
+
+            // 走 co_spawn 的 handler 次数
+            alignas(64) std::atomic<uint64_t> spawnedHandlers{ 0 };
+
+            // MsquicSocket 合并发送：StreamSend 调用次数和其中的帧数，两者之比即每次发送的平均帧数
+            alignas(64) std::atomic<uint64_t> quicSends{ 0 };
+
+            alignas(64) std::atomic<uint64_t> quicMessagesSent{ 0 };
+
+            // MsquicBufferPool 向系统申请的 slab 数，以及超过最大级别直接分配的缓冲区数
+            alignas(64) std::atomic<uint64_t> bufferSlabs{ 0 };
+
+            alignas(64) std::atomic<uint64_t> largeBufferAllocations{ 0 };
+
+            // MsquicSocket 发送队列超过 maxQueuedBytes 的次数
+            alignas(64) std::atomic<uint64_t> sendQueueOverflows{ 0 };
+
+            // 中转的 DATAGRAM 数，以及格式错误、目标不在线或 msquic 拒收而丢弃的数
+            alignas(64) std::atomic<uint64_t> datagramsRelayed{ 0 };
+
+            alignas(64) std::atomic<uint64_t> datagramsDropped{ 0 };
+
+            // 批量传输开始的次数和经单向流中转的字节数
+            alignas(64) std::atomic<uint64_t> bulkTransfers{ 0 };
+
+            alignas(64) std::atomic<uint64_t> bulkBytesRelayed{ 0 };
+
+            // WebSocket 以 MSG_ZEROCOPY 发出的字节数，以及内核退化为拷贝的发送调用数
+            alignas(64) std::atomic<uint64_t> zeroCopyBytes{ 0 };
+
+            alignas(64) std::atomic<uint64_t> zeroCopyCopied{ 0 };
+
+            // 会话或全局内存预算超出的次数
+            alignas(64) std::atomic<uint64_t> memoryBudgetExceeded{ 0 };
+
+        };
+
+    }
+}
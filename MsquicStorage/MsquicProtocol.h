@@ -0,0 +1,359 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+namespace hope {
+
+	namespace quic {
+
+		// 连接通过 ALPN 协商出的线路协议
+		enum class WireProtocol {
+
+			Json = 0,     // int64_t 长度 + JSON 消息体
+
+			Binary = 1,   // 定长小端帧头 + 源/目标 ID + 不透明负载
+
+		};
+
+		// 流量类别，每个类别在一个会话里独占一条 QUIC 流，按 msquic 流优先级调度
+		// 大负载只阻塞自己那条流，控制消息不会排在它后面
+		enum class TrafficClass {
+
+			Control = 0,      // 注册、重启、停止远控、断开等短小且要求及时的消息
+
+			Signalling = 1,   // 普通转发的信令
+
+			Bulk = 2,         // 剪贴板、文件等大负载
+
+		};
+
+		constexpr size_t TRAFFIC_CLASS_COUNT = 3;
+
+		// QUIC_PARAM_STREAM_PRIORITY 取值，越大越优先，msquic 默认 0x7FFF
+		constexpr uint16_t trafficClassPriority(TrafficClass trafficClass) {
+
+			return trafficClass == TrafficClass::Control ? 0xC000
+				: trafficClass == TrafficClass::Bulk ? 0x1000
+				: 0x7FFF;
+		}
+
+		constexpr const char* JSON_ALPN = "quic";
+
+		constexpr const char* BINARY_ALPN = "quic-bin";
+
+		constexpr uint8_t BINARY_PROTOCOL_VERSION = 1;
+
+		// 二进制帧头（小端，共 12 字节）：
+		// | version:u8 | flags:u8 | requestType:u16 | state:u16 | sourceIdLength:u8 | targetIdLength:u8 | payloadLength:u32 |
+		// 帧头之后依次是 sourceId、targetId、payload
+		constexpr size_t BINARY_HEADER_SIZE = 12;
+
+		// flags：负载压缩算法，置位时负载为 originalSize:u32 + 压缩数据，源/目标 ID 不压缩
+		constexpr uint8_t BINARY_FLAG_ZSTD = 0x01;
+
+		constexpr uint8_t BINARY_FLAG_LZ4 = 0x02;
+
+		constexpr uint8_t BINARY_FLAG_COMPRESSED = BINARY_FLAG_ZSTD | BINARY_FLAG_LZ4;
+
+		struct BinaryHeader {
+
+			uint8_t version = BINARY_PROTOCOL_VERSION;
+
+			uint8_t flags = 0;
+
+			uint16_t requestType = 0;
+
+			uint16_t state = 0;
+
+			uint8_t sourceIdLength = 0;
+
+			uint8_t targetIdLength = 0;
+
+			uint32_t payloadLength = 0;
+
+		};
+
+		// 一个完整二进制帧的视图，不拥有数据
+		struct BinaryFrame {
+
+			BinaryHeader header;
+
+			std::string_view sourceId;
+
+			std::string_view targetId;
+
+			std::string_view payload;
+
+		};
+
+		inline void storeLittleEndian16(unsigned char* out, uint16_t value) {
+
+			out[0] = static_cast<unsigned char>(value);
+
+			out[1] = static_cast<unsigned char>(value >> 8);
+		}
+
+		inline void storeLittleEndian32(unsigned char* out, uint32_t value) {
+
+			for (int i = 0; i < 4; i++) {
+
+				out[i] = static_cast<unsigned char>(value >> (i * 8));
+
+			}
+		}
+
+		inline uint16_t loadLittleEndian16(const unsigned char* in) {
+
+			return static_cast<uint16_t>(in[0] | (in[1] << 8));
+		}
+
+		inline uint32_t loadLittleEndian32(const unsigned char* in) {
+
+			uint32_t value = 0;
+
+			for (int i = 3; i >= 0; i--) {
+
+				value = (value << 8) | in[i];
+
+			}
+
+			return value;
+		}
+
+		inline void encodeBinaryHeader(unsigned char* out, const BinaryHeader& header) {
+
+			out[0] = header.version;
+
+			out[1] = header.flags;
+
+			storeLittleEndian16(out + 2, header.requestType);
+
+			storeLittleEndian16(out + 4, header.state);
+
+			out[6] = header.sourceIdLength;
+
+			out[7] = header.targetIdLength;
+
+			storeLittleEndian32(out + 8, header.payloadLength);
+		}
+
+		// 调用方保证 in 至少有 BINARY_HEADER_SIZE 字节
+		inline bool decodeBinaryHeader(const unsigned char* in, BinaryHeader& header) {
+
+			header.version = in[0];
+
+			header.flags = in[1];
+
+			header.requestType = loadLittleEndian16(in + 2);
+
+			header.state = loadLittleEndian16(in + 4);
+
+			header.sourceIdLength = in[6];
+
+			header.targetIdLength = in[7];
+
+			header.payloadLength = loadLittleEndian32(in + 8);
+
+			return header.version == BINARY_PROTOCOL_VERSION;
+		}
+
+		// 帧头 + ID + 负载的总长度
+		inline size_t binaryFrameSize(const BinaryHeader& header) {
+
+			return BINARY_HEADER_SIZE + header.sourceIdLength + header.targetIdLength + header.payloadLength;
+		}
+
+		// data 必须正好是一个完整帧
+		inline bool parseBinaryFrame(const unsigned char* data, size_t size, BinaryFrame& frame) {
+
+			if (size < BINARY_HEADER_SIZE || !decodeBinaryHeader(data, frame.header)) {
+
+				return false;
+
+			}
+
+			if (binaryFrameSize(frame.header) != size) {
+
+				return false;
+
+			}
+
+			const char* cursor = reinterpret_cast<const char*>(data + BINARY_HEADER_SIZE);
+
+			frame.sourceId = std::string_view(cursor, frame.header.sourceIdLength);
+
+			cursor += frame.header.sourceIdLength;
+
+			frame.targetId = std::string_view(cursor, frame.header.targetIdLength);
+
+			cursor += frame.header.targetIdLength;
+
+			frame.payload = std::string_view(cursor, frame.header.payloadLength);
+
+			return true;
+		}
+
+		// QUIC DATAGRAM：不可靠、无序，用于鼠标移动、按键等丢了也不需要重传的实时事件
+		// | version:u8 | idLength:u8 | id | payload |
+		// 客户端发出时 id 为目标 ID，服务端转给目标时改写为源 ID；不分帧，一个 DATAGRAM 就是一条消息
+		constexpr uint8_t DATAGRAM_PROTOCOL_VERSION = 1;
+
+		constexpr size_t DATAGRAM_HEADER_SIZE = 2;
+
+		// 在 handler 表中登记的请求类型，中转时复用转发路由
+		constexpr int64_t DATAGRAM_REQUEST_TYPE = 5;
+
+		// out 至少有 DATAGRAM_HEADER_SIZE + id.size() 字节，id 不超过 255 字节，返回写入长度
+		inline size_t encodeDatagramHeader(unsigned char* out, std::string_view id) {
+
+			out[0] = DATAGRAM_PROTOCOL_VERSION;
+
+			out[1] = static_cast<unsigned char>(id.size());
+
+			memcpy(out + DATAGRAM_HEADER_SIZE, id.data(), id.size());
+
+			return DATAGRAM_HEADER_SIZE + id.size();
+		}
+
+		inline bool parseDatagram(const unsigned char* data, size_t size, std::string_view& id, std::string_view& payload) {
+
+			if (size < DATAGRAM_HEADER_SIZE || data[0] != DATAGRAM_PROTOCOL_VERSION) {
+
+				return false;
+
+			}
+
+			size_t idLength = data[1];
+
+			if (idLength == 0 || DATAGRAM_HEADER_SIZE + idLength > size) {
+
+				return false;
+
+			}
+
+			const char* cursor = reinterpret_cast<const char*>(data + DATAGRAM_HEADER_SIZE);
+
+			id = std::string_view(cursor, idLength);
+
+			payload = std::string_view(cursor + idLength, size - DATAGRAM_HEADER_SIZE - idLength);
+
+			return true;
+		}
+
+		// 批量传输：每次传输由发送方单独开一条单向流，流头与 DATAGRAM 头格式相同，之后直到 FIN 都是原始负载
+		// 发送方的流头带目标 ID，服务端在目标连接上开一条单向流，流头改写为源 ID 后逐块转发
+		constexpr int64_t BULK_REQUEST_TYPE = 6;
+
+		// 流上的帧（QUIC 流、WebSocket）能否带这个请求类型：DATAGRAM 只能由收到的 DATAGRAM 产生，
+		// 批量传输只能由单向流的流头产生
+		inline bool isStreamRequestType(int64_t requestType) {
+
+			return requestType != DATAGRAM_REQUEST_TYPE && requestType != BULK_REQUEST_TYPE;
+		}
+
+		// 中止批量传输流时带给对端的错误码
+		constexpr uint64_t BULK_ERROR_INVALID_HEADER = 400;
+
+		constexpr uint64_t BULK_ERROR_NOT_FOUND = 404;
+
+		constexpr uint64_t BULK_ERROR_UNSUPPORTED = 415;
+
+		constexpr uint64_t BULK_ERROR_ABORTED = 499;
+
+		// 流头还不完整时返回 0，否则返回流头长度；version 或 ID 长度非法返回 -1
+		inline int64_t bulkHeaderSize(const unsigned char* data, size_t size) {
+
+			if (size < DATAGRAM_HEADER_SIZE) {
+
+				return 0;
+
+			}
+
+			if (data[0] != DATAGRAM_PROTOCOL_VERSION || data[1] == 0) {
+
+				return -1;
+
+			}
+
+			size_t headerSize = DATAGRAM_HEADER_SIZE + data[1];
+
+			return size < headerSize ? 0 : static_cast<int64_t>(headerSize);
+		}
+
+		// 各协议的帧头长度
+		inline size_t frameHeaderSize(WireProtocol protocol) {
+
+			return protocol == WireProtocol::Binary ? BINARY_HEADER_SIZE : sizeof(int64_t);
+		}
+
+		// header 至少有 frameHeaderSize(protocol) 字节，返回含帧头的整帧长度，帧头非法返回 -1
+		inline int64_t frameSize(WireProtocol protocol, const unsigned char* header) {
+
+			if (protocol == WireProtocol::Binary) {
+
+				BinaryHeader binaryHeader;
+
+				if (!decodeBinaryHeader(header, binaryHeader)) {
+
+					return -1;
+
+				}
+
+				return static_cast<int64_t>(binaryFrameSize(binaryHeader));
+			}
+
+			int64_t bodyLength = 0;
+
+			memcpy(&bodyLength, header, sizeof(int64_t));
+
+			if (bodyLength < 0 || bodyLength > INT64_MAX - static_cast<int64_t>(sizeof(int64_t))) {
+
+				return -1;
+
+			}
+
+			return static_cast<int64_t>(sizeof(int64_t)) + bodyLength;
+		}
+
+		// 正文写完后回填帧头，out 指向 frameHeaderSize(protocol) 字节的帧头位置
+		// 二进制帧不带源/目标 ID，正文整体作为负载
+		inline void encodeFrameHeader(WireProtocol protocol, unsigned char* out, size_t bodyLength, int64_t requestType, int64_t state) {
+
+			if (protocol == WireProtocol::Binary) {
+
+				BinaryHeader header;
+
+				header.requestType = static_cast<uint16_t>(requestType);
+
+				header.state = static_cast<uint16_t>(state);
+
+				header.payloadLength = static_cast<uint32_t>(bodyLength);
+
+				encodeBinaryHeader(out, header);
+
+				return;
+			}
+
+			int64_t length = static_cast<int64_t>(bodyLength);
+
+			memcpy(out, &length, sizeof(int64_t));
+		}
+
+		// 根据协商出的 ALPN 决定协议，未知的 ALPN 按 JSON 处理
+		inline WireProtocol protocolFromAlpn(const char* alpn, size_t length) {
+
+			if (std::string_view(alpn, length) == BINARY_ALPN) {
+
+				return WireProtocol::Binary;
+
+			}
+
+			return WireProtocol::Json;
+		}
+
+	}
+
+}
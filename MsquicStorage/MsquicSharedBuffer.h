@@ -0,0 +1,143 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "MsquicBufferPool.h"
+
+namespace hope {
+    namespace utils {
+
+        // 发送缓冲区：池化存储 + 侵入式引用计数，写满后视为不可变
+        // 同一份序列化结果可以交给多个帧格式相同的连接（广播、重试、重放），最后一个传输发送完成时归还池
+        // 计数放在数据前面的 16 字节里，裸指针也能找回计数，所以 writeAsync(unsigned char*, size_t) 接管的就是一份引用
+        class MsquicSharedBuffer {
+        public:
+
+            MsquicSharedBuffer() noexcept = default;
+
+            // 分配一块引用计数为 1 的缓冲区，返回的裸指针由 release 释放
+            static unsigned char* allocateRaw(size_t size) {
+
+                unsigned char* block = MsquicBufferPool::allocate(sizeof(Header) + size);
+
+                new (block) Header();
+
+                return block + sizeof(Header);
+            }
+
+            // 实际可写容量
+            static size_t capacity(size_t size) {
+
+                return MsquicBufferPool::capacity(sizeof(Header) + size) - sizeof(Header);
+            }
+
+            static void retain(unsigned char* data) {
+
+                header(data)->refs.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            static void release(unsigned char* data) {
+
+                if (!data) {
+                    return;
+                }
+
+                Header* h = header(data);
+
+                if (h->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+
+                    h->~Header();
+
+                    MsquicBufferPool::release(reinterpret_cast<unsigned char*>(h));
+                }
+            }
+
+            static MsquicSharedBuffer allocate(size_t size) {
+
+                return MsquicSharedBuffer(allocateRaw(size), size);
+            }
+
+            // 接管一份已有的引用（allocateRaw / allocateBuffer 的返回值），不增加计数
+            static MsquicSharedBuffer adopt(unsigned char* data, size_t size) {
+
+                return MsquicSharedBuffer(data, size);
+            }
+
+            MsquicSharedBuffer(const MsquicSharedBuffer& other) noexcept
+                : buffer(other.buffer)
+                , length(other.length) {
+
+                if (buffer) {
+                    retain(buffer);
+                }
+            }
+
+            MsquicSharedBuffer(MsquicSharedBuffer&& other) noexcept
+                : buffer(std::exchange(other.buffer, nullptr))
+                , length(std::exchange(other.length, 0)) {
+            }
+
+            MsquicSharedBuffer& operator=(MsquicSharedBuffer other) noexcept {
+
+                std::swap(buffer, other.buffer);
+
+                std::swap(length, other.length);
+
+                return *this;
+            }
+
+            ~MsquicSharedBuffer() {
+
+                release(buffer);
+            }
+
+            const unsigned char* data() const noexcept { return buffer; }
+
+            // 只在交给任何传输之前写入
+            unsigned char* mutableData() noexcept { return buffer; }
+
+            size_t size() const noexcept { return length; }
+
+            explicit operator bool() const noexcept { return buffer != nullptr; }
+
+            // 交出自己持有的引用，调用方之后用 release 归还
+            unsigned char* detach() noexcept {
+
+                length = 0;
+
+                return std::exchange(buffer, nullptr);
+            }
+
+        private:
+
+            struct alignas(16) Header {
+
+                std::atomic<uint32_t> refs{ 1 };
+
+            };
+
+            static Header* header(unsigned char* data) {
+
+                return reinterpret_cast<Header*>(data - sizeof(Header));
+            }
+
+            MsquicSharedBuffer(unsigned char* buffer, size_t length) noexcept
+                : buffer(buffer)
+                , length(length) {
+            }
+
+            unsigned char* buffer = nullptr;
+
+            size_t length = 0;
+        };
+
+        // 配合 std::unique_ptr 持有一份引用
+        struct MsquicSharedBufferDeleter {
+            void operator()(unsigned char* data) const {
+                MsquicSharedBuffer::release(data);
+            }
+        };
+    }
+}
@@ -1,495 +1,1113 @@
-#include "MsquicSocket.h"
-#include "MsquicManager.h"
-#include "MsquicData.h"
-
-#include "MsQuicApi.h"
-
-#include "Utils.h"
-
-#include <boost/json.hpp>
-#include <boost/asio/co_spawn.hpp>
-
-namespace hope {
-
-    namespace quic {
-
-        MsquicSocket::MsquicSocket(HQUIC connection, MsquicManager* msquicManager, boost::asio::io_context& ioContext) :connection(connection), msquicManager(msquicManager), ioContext(ioContext), registrationTimer(ioContext)
-        {
-      
-        }
-
-        MsquicSocket::~MsquicSocket()
-        {
-
-            registrationTimer.cancel();
-
-            clear();
-
-        }
-
-        void MsquicSocket::shutDown() {
-        
-            this->isShutDown.store(true);
-
-        }
-
-        void MsquicSocket::clear()
-        {
-
-            receivedBuffer.clear();
-
-            if (isShutDown) {
-
-                if (stream) {
-
-                    stream = nullptr;
-                }
-
-                if (remoteStream) {
-        
-                    remoteStream = nullptr;
-                }
-
-                if (connection) {
-       
-                    connection = nullptr;
-                }
-
-            }
-
-            if (stream) {
-                MsQuic->StreamClose(stream);
-                stream = nullptr;
-            }
-
-            if (remoteStream) {
-                MsQuic->StreamClose(remoteStream);
-                remoteStream = nullptr;
-            }
-
-            if (connection) {
-                MsQuic->ConnectionShutdown(
-                    connection,
-                    QUIC_CONNECTION_SHUTDOWN_FLAG_SILENT,
-                    QUIC_STATUS_ABORTED
-                );
-                MsQuic->ConnectionClose(connection);
-                connection = nullptr;
-            }
-
-        }
-
-        void MsquicSocket::runEventLoop()
-        {
-           stream = createStream();
-
-           boost::asio::co_spawn(ioContext, [self = shared_from_this()]()->boost::asio::awaitable<void> {
-            
-                co_await self->registrationTimeout();
-
-            }, boost::asio::detached);
-        }
-
-
-        void MsquicSocket::writeAsync(unsigned char* data, size_t size)
-        {
-            QUIC_BUFFER* buffer = new QUIC_BUFFER;
-
-            buffer->Buffer = data;
-
-            buffer->Length = size;
-
-            // 添加更多错误检查
-            QUIC_STATUS status = MsQuic->StreamSend(
-                stream,
-                buffer,
-                1,
-                QUIC_SEND_FLAG_NONE,
-                buffer);
-
-            if (QUIC_FAILED(status)) {
-
-                delete[] buffer->Buffer;
-
-                delete buffer;
-
-                MsQuic->StreamClose(stream);
-
-                return;
-            }
-
-            return;
-        }
-
-        void MsquicSocket::receiveAsync(QUIC_STREAM_EVENT* event)
-        {
-            auto* rev = &event->RECEIVE;
-
-            // 1. 如果只有一个缓冲区，按原逻辑处理
-            if (rev->BufferCount == 1) {
-                const auto& buf = rev->Buffers[0];
-
-                if (buf.Length >= sizeof(int64_t)) {
-                    int64_t bodyLen = *reinterpret_cast<const int64_t*>(buf.Buffer);
-                    int64_t totalLen = sizeof(int64_t) + bodyLen;
-
-                    if (buf.Length >= totalLen) {
-                        // 零拷贝直接解析
-                        std::string_view jsonStr(
-                            reinterpret_cast<const char*>(buf.Buffer + sizeof(int64_t)),
-                            bodyLen
-                        );
-
-                        try {
-                            auto json = boost::json::parse(jsonStr).as_object();
-                            auto msquicData = std::make_shared<MsquicData>(
-                                json, shared_from_this(), msquicManager);
-                            msquicManager->getMsquicLogicSystem()->postTaskAsync(std::move(msquicData));
-                        }
-                        catch (const std::exception& e) {
-                            LOG_ERROR("JSON parse error: %s", e.what());
-                        }
-
-                        // 处理剩余数据
-                        if (buf.Length > totalLen) {
-                            receivedBuffer.assign(
-                                buf.Buffer + totalLen,
-                                buf.Buffer + buf.Length
-                            );
-                            tryParse();
-                        }
-                        return;
-                    }
-                }
-            }
-            // 2. 多个缓冲区但数据头完整在第一个缓冲区
-            else if (rev->BufferCount > 1) {
-                const auto& firstBuf = rev->Buffers[0];
-
-                if (firstBuf.Length >= sizeof(int64_t)) {
-                    int64_t bodyLen = *reinterpret_cast<const int64_t*>(firstBuf.Buffer);
-                    int64_t totalLen = sizeof(int64_t) + bodyLen;
-
-                    // 计算所有缓冲区的总长度
-                    uint64_t totalBytes = 0;
-                    for (uint32_t i = 0; i < rev->BufferCount; ++i) {
-                        totalBytes += rev->Buffers[i].Length;
-                    }
-
-                    // 如果多个缓冲区中包含完整数据包
-                    if (totalBytes >= totalLen) {
-                        // 从多个缓冲区构建JSON字符串
-                        std::string jsonStr;
-                        jsonStr.reserve(bodyLen);
-
-                        // 第一个缓冲区：跳过头部
-                        uint64_t bytesFromFirst = std::min(
-                            static_cast<uint64_t>(firstBuf.Length - sizeof(int64_t)),
-                            static_cast<uint64_t>(bodyLen)
-                        );
-                        jsonStr.append(
-                            reinterpret_cast<const char*>(firstBuf.Buffer + sizeof(int64_t)),
-                            bytesFromFirst
-                        );
-
-                        // 后续缓冲区：添加剩余JSON数据
-                        uint64_t jsonBytesCollected = bytesFromFirst;
-                        for (uint32_t i = 1; i < rev->BufferCount && jsonBytesCollected < bodyLen; ++i) {
-                            const auto& buf = rev->Buffers[i];
-                            uint64_t toCopy = std::min(
-                                static_cast<uint64_t>(buf.Length),
-                                static_cast<uint64_t>(bodyLen - jsonBytesCollected)
-                            );
-                            jsonStr.append(
-                                reinterpret_cast<const char*>(buf.Buffer),
-                                toCopy
-                            );
-                            jsonBytesCollected += toCopy;
-                        }
-
-                        try {
-                            auto json = boost::json::parse(jsonStr).as_object();
-                            auto msquicData = std::make_shared<MsquicData>(
-                                json, shared_from_this(), msquicManager);
-                            msquicManager->getMsquicLogicSystem()->postTaskAsync(std::move(msquicData));
-
-                            // 处理剩余数据
-                            uint64_t consumedBytes = totalLen;
-                            receivedBuffer.clear();
-
-                            // 跳过已消费的数据
-                            for (uint32_t i = 0; i < rev->BufferCount && consumedBytes > 0; ++i) {
-                                const auto& buf = rev->Buffers[i];
-                                if (consumedBytes >= buf.Length) {
-                                    consumedBytes -= buf.Length;
-                                }
-                                else {
-                                    // 当前缓冲区有剩余数据
-                                    uint64_t remaining = buf.Length - consumedBytes;
-                                    receivedBuffer.insert(
-                                        receivedBuffer.end(),
-                                        buf.Buffer + consumedBytes,
-                                        buf.Buffer + buf.Length
-                                    );
-                                    consumedBytes = 0;
-                                }
-                            }
-
-                            if (!receivedBuffer.empty()) {
-                                tryParse();
-                            }
-                            return;  // 零拷贝处理完毕
-                        }
-                        catch (const std::exception& e) {
-                            LOG_ERROR("JSON parse error: %s", e.what());
-                            // 解析失败，回退到缓冲区拷贝方式
-                        }
-                    }
-                }
-            }
-
-            // 3. 不能零拷贝解析，回退到原逻辑
-            for (uint32_t i = 0; i < rev->BufferCount; ++i) {
-                const auto& buf = rev->Buffers[i];
-                receivedBuffer.insert(receivedBuffer.end(), buf.Buffer, buf.Buffer + buf.Length);
-            }
-            tryParse();
-        }
-
-        void MsquicSocket::tryParse()
-        {
-            constexpr size_t headerSize = sizeof(int64_t);
-
-            while (true) {
-
-                // 1. 检查头部
-                if (receivedBuffer.size() < headerSize) return;
-
-                // 2. 预读长度（不删除数据）
-                int64_t len = *reinterpret_cast<const int64_t*>(receivedBuffer.data());
-
-                // 3. 检查完整包 (Header + Body)
-                // 注意：你的 writeJsonAsync 逻辑是 Header(8字节) + Body(len字节)
-                // 所以总长度应该是 headerSize + len
-                if (static_cast<int64_t>(receivedBuffer.size()) < headerSize + len) {
-                    return; // 数据不够，等待下次
-                }
-
-                // 4. 数据完整，开始提取
-                // 移除头部
-                receivedBuffer.erase(receivedBuffer.begin(), receivedBuffer.begin() + headerSize);
-
-                // 提取 Body
-                std::vector<uint8_t> payload(receivedBuffer.begin(), receivedBuffer.begin() + len);
-
-                // 移除 Body
-                receivedBuffer.erase(receivedBuffer.begin(), receivedBuffer.begin() + len);
-
-                /* 4. 业务回调（json 在 payload 里） */
-                boost::json::object json =
-                    boost::json::parse(std::string(payload.begin(), payload.end())).as_object();
-
-                auto msquicData = std::make_shared<MsquicData>(
-                    json, shared_from_this(), msquicManager);
-                msquicManager->getMsquicLogicSystem()->postTaskAsync(std::move(msquicData));
-            }
-        }
-
-        boost::asio::awaitable<void> MsquicSocket::registrationTimeout() {
-
-            using namespace std::chrono_literals;
-
-            // 1. 设置 10 秒超时
-            registrationTimer.expires_after(10s);
-
-            // 2. 异步等待计时器或被取消
-            boost::system::error_code ec;
-
-            co_await registrationTimer.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
-
-            // 3. 检查是否超时
-            if (ec == boost::asio::error::operation_aborted) {
-                // 计时器被取消 (说明在 10s 内完成了注册)
-                co_return;
-            }
-
-            // 4. 超时发生，且尚未注册，则关闭连接
-            if (!isRegistered.load()) {
-                this->clear();
-
-            }
-
-            co_return;
-        }
-
-
-		HQUIC MsquicSocket::createStream()
-		{
-            HQUIC stream = nullptr;
-            QUIC_STATUS status = MsQuic->StreamOpen(
-                connection,
-                QUIC_STREAM_OPEN_FLAG_NONE,
-                MsquicSocketHandle,
-                this,
-                &stream);
-
-            if (QUIC_FAILED(status)) {
-                return nullptr;
-            }
-
-            MsQuic->SetCallbackHandler(
-                stream,
-                MsquicSocketHandle,   // 你的静态流回调
-                this);
-
-            status = MsQuic->StreamStart(
-                stream,
-                QUIC_STREAM_START_FLAG_IMMEDIATE | QUIC_STREAM_START_FLAG_INDICATE_PEER_ACCEPT | QUIC_STREAM_START_FLAG_PRIORITY_WORK);
-
-            if (QUIC_FAILED(status)) {
-                MsQuic->StreamClose(stream);
-                return nullptr;
-            }
-
-            return stream;
-
-		}
-
-
-        void MsquicSocket::setAccountId(const std::string& accountId) { 
-        
-            this->accountId = accountId;
-
-        }
-
-        std::string& MsquicSocket::getAccountId() { 
-        
-            return this->accountId;
-
-        }
-
-        void MsquicSocket::setRegistered(bool registered) {
-            
-            this->isRegistered.store(registered);
-
-            if (isRegistered.load()) {
-            
-                registrationTimer.cancel();
-
-            }
-
-        }
-
-        bool MsquicSocket::getRegistered() {
-            return this->isRegistered ;
-        }
-
-        MsquicManager* MsquicSocket::getMsquicManager()
-        {
-            return msquicManager;
-        }
-
-        void MsquicSocket::setRemoteStream(HQUIC remoteStream) {
-        
-			this->remoteStream = remoteStream;
-
-        }
-
-        boost::asio::io_context& MsquicSocket::getIoCompletionPorts()
-        {
-            return this->ioContext;
-        }
-
-        SocketType MsquicSocket::getType() {
-
-            return SocketType::MsquicSocket;
-
-        }
-
-
-        // Stream callback
-        QUIC_STATUS QUIC_API MsquicSocketHandle(
-            HQUIC stream,
-            void* context,
-            QUIC_STREAM_EVENT* event) {
-
-            MsquicSocket * msquicSocket = static_cast<MsquicSocket*>(context);
-
-            if (msquicSocket == nullptr || event == nullptr) {
-                return QUIC_STATUS_INVALID_PARAMETER;
-            }
-
-            switch (event->Type) {
-            case QUIC_STREAM_EVENT_START_COMPLETE:
-            {
-                break;
-            }
-           
-
-            case QUIC_STREAM_EVENT_RECEIVE:
-            {
-
-                msquicSocket->receiveAsync(event);
-
-                break;
-            }
-         
-
-            // Add handler for QUIC_STREAM_EVENT_SEND_COMPLETE (type 2)
-            case QUIC_STREAM_EVENT_SEND_COMPLETE:
-            {
-                if (event->SEND_COMPLETE.ClientContext) {
-                    
-                    QUIC_BUFFER*  buffer = static_cast<QUIC_BUFFER*>(event->SEND_COMPLETE.ClientContext);
-
-                    if (buffer->Buffer) {
-                    
-						delete[] buffer->Buffer;
-
-                    }
-
-                    delete buffer;
-
-                }
-                break;
-            }
-    
-
-            // Add handler for QUIC_STREAM_EVENT_PEER_SEND_ABORTED (type 6)
-            case QUIC_STREAM_EVENT_PEER_SEND_ABORTED:
-            {
-                break;
-
-            }
-   
-
-            case QUIC_STREAM_EVENT_PEER_SEND_SHUTDOWN: {
-                break;
-            }
-                                           
-            case QUIC_STREAM_EVENT_SEND_SHUTDOWN_COMPLETE:
-            {
-                break;
-            }
-    
-
-            case QUIC_STREAM_EVENT_SHUTDOWN_COMPLETE: {
-                break;
-            }
-            case QUIC_STREAM_EVENT_IDEAL_SEND_BUFFER_SIZE:
-            {
-                break;
-            }
-        
-
-            default:
-            {
-                break;
-            }
-            }
-
-            return QUIC_STATUS_SUCCESS;
-        }
-
-	}
+#include "MsquicSocket.h"
+#include "MsquicManager.h"
+#include "MsquicData.h"
+#include "MsquicBulkRelay.h"
+#include "MsquicCompression.h"
+
+#include "MsQuicApi.h"
+#include "ConfigManager.h"
+#include "MsquicMetrics.h"
+#include "concurrentqueue.h"
+
+#include "Utils.h"
+
+#include <boost/json.hpp>
+#include <boost/asio/co_spawn.hpp>
+
+namespace hope {
+
+    namespace quic {
+
+        // 在途的 SendBatch 数受连接数和在途限额约束，超过上限的归还直接释放
+        static constexpr size_t SEND_BATCH_POOL_MAX = 4096;
+
+        struct MsquicSocket::SendBatch::Pool {
+
+            moodycamel::ConcurrentQueue<SendBatch*> freeList;
+
+            std::atomic<size_t> cachedCount{ 0 };
+
+        };
+
+        // 不析构：进程退出时 msquic 仍可能回调取消的 SEND_COMPLETE
+        MsquicSocket::SendBatch::Pool& MsquicSocket::SendBatch::pool()
+        {
+            static Pool* batchPool = new Pool();
+
+            return *batchPool;
+        }
+
+        MsquicSocket::SendBatch* MsquicSocket::SendBatch::acquire()
+        {
+            Pool& pool = SendBatch::pool();
+
+            SendBatch* batch = nullptr;
+
+            if (pool.freeList.try_dequeue(batch)) {
+
+                pool.cachedCount.fetch_sub(1, std::memory_order_relaxed);
+
+                return batch;
+            }
+
+            hope::utils::MsquicMetrics::add(hope::utils::MsquicMetrics::instance().poolHeapAllocations);
+
+            batch = new SendBatch();
+
+            // 一次最多 MAX_BATCH_BUFFERS 帧，之后不再扩容
+            batch->buffers.reserve(MAX_BATCH_BUFFERS);
+
+            return batch;
+        }
+
+        void MsquicSocket::SendBatch::recycle(SendBatch* batch)
+        {
+            batch->clear();
+
+            Pool& pool = SendBatch::pool();
+
+            if (pool.cachedCount.fetch_add(1, std::memory_order_relaxed) < SEND_BATCH_POOL_MAX) {
+
+                pool.freeList.enqueue(batch);
+
+                return;
+            }
+
+            pool.cachedCount.fetch_sub(1, std::memory_order_relaxed);
+
+            delete batch;
+        }
+
+        void MsquicSocket::SendQueue::push_back(const QUIC_BUFFER& buffer)
+        {
+            // 队头已取走的部分过半就前移，队列一直不空时也不会只增不减
+            if (head > 0 && head * 2 >= items.size()) {
+
+                items.erase(items.begin(), items.begin() + head);
+
+                head = 0;
+            }
+
+            if (items.size() == items.capacity()) {
+                hope::utils::MsquicMetrics::add(hope::utils::MsquicMetrics::instance().poolHeapAllocations);
+            }
+
+            items.push_back(buffer);
+        }
+
+        static SendOverflowPolicy overflowPolicyFromName(const std::string& name) {
+
+            if (name == "dropOldest") return SendOverflowPolicy::DropOldest;
+
+            if (name == "disconnect") return SendOverflowPolicy::Disconnect;
+
+            return SendOverflowPolicy::Reject;
+        }
+
+        MsquicSocket::MsquicSocket(HQUIC connection, MsquicManager* msquicManager, boost::asio::io_context& ioContext) :connection(connection), msquicManager(msquicManager), ioContext(ioContext), registrationTimer(ioContext)
+            , deferredReceive(ConfigManager::Instance().GetInt("MsquicStorage.deferredReceive") != 0)
+            , maxFrameSize(ConfigManager::Instance().GetInt("MsquicStorage.maxFrameSize", MsquicFrameCodec::DEFAULT_MAX_FRAME_SIZE))
+            , maxQueuedBytes(ConfigManager::Instance().GetInt("MsquicStorage.maxQueuedBytes", 4 * 1024 * 1024))
+            , overflowPolicy(overflowPolicyFromName(ConfigManager::Instance().GetString("MsquicStorage.sendOverflowPolicy", "reject")))
+            , maxBatchDelay(ConfigManager::Instance().GetInt("MsquicStorage.sendBatchDelayMicros", 1000))
+        {
+            // 对端声明的帧长超过上限直接断开，不会为它预留缓冲
+            for (SendLane& lane : lanes) {
+                lane.frameCodec.setMaxFrameSize(maxFrameSize);
+            }
+
+            for (RemoteStream& remote : remoteStreams) {
+                remote.frameCodec.setMaxFrameSize(maxFrameSize);
+            }
+        }
+
+        MsquicSocket::~MsquicSocket()
+        {
+
+            registrationTimer.cancel();
+
+            clear();
+
+            LOG_INFO("MsquicSocket %s send stats: sent=%llu dropped=%llu rejected=%llu peakQueued=%zu",
+                accountId.c_str(),
+                static_cast<unsigned long long>(sentFrames.load()),
+                static_cast<unsigned long long>(droppedFrames.load()),
+                static_cast<unsigned long long>(rejectedFrames.load()),
+                peakQueuedBytes);
+
+        }
+
+        void MsquicSocket::shutDown() {
+        
+            this->isShutDown.store(true);
+
+        }
+
+        void MsquicSocket::clear()
+        {
+
+            for (SendLane& lane : lanes) {
+
+                memoryBudget.release(lane.frameCodec.capacity());
+
+                lane.frameCodec.clear();
+
+                releaseQueue(lane);
+            }
+
+            for (RemoteStream& remote : remoteStreams) {
+
+                memoryBudget.release(remote.frameCodec.capacity());
+
+                remote.frameCodec.clear();
+            }
+
+            if (isShutDown) {
+
+                for (SendLane& lane : lanes) {
+                    lane.stream = nullptr;
+                }
+
+                for (RemoteStream& remote : remoteStreams) {
+                    remote.stream = nullptr;
+                }
+
+                if (connection) {
+       
+                    connection = nullptr;
+                }
+
+            }
+
+            closeStreams();
+
+            if (connection) {
+                MsQuic->ConnectionShutdown(
+                    connection,
+                    QUIC_CONNECTION_SHUTDOWN_FLAG_SILENT,
+                    QUIC_STATUS_ABORTED
+                );
+                MsQuic->ConnectionClose(connection);
+                connection = nullptr;
+            }
+
+        }
+
+        void MsquicSocket::closeStreams()
+        {
+            for (SendLane& lane : lanes) {
+                if (lane.stream) {
+                    MsQuic->StreamClose(lane.stream);
+                    lane.stream = nullptr;
+                }
+            }
+
+            for (RemoteStream& remote : remoteStreams) {
+                if (remote.stream) {
+                    MsQuic->StreamClose(remote.stream);
+                    remote.stream = nullptr;
+                }
+            }
+        }
+
+        void MsquicSocket::runEventLoop()
+        {
+            // 每个类别一条流，msquic 按优先级调度，控制消息不会排在大负载后面
+            for (size_t i = 0; i < TRAFFIC_CLASS_COUNT; ++i) {
+
+                lanes[i].stream = createStream(static_cast<TrafficClass>(i));
+
+                if (!lanes[i].stream) {
+                    LOG_ERROR("MsquicSocket open stream for traffic class %zu failed", i);
+                }
+            }
+
+           boost::asio::co_spawn(ioContext, [self = shared_from_this()]()->boost::asio::awaitable<void> {
+            
+                co_await self->registrationTimeout();
+
+            }, boost::asio::detached);
+        }
+
+        MsquicSocket::SendLane& MsquicSocket::laneOf(TrafficClass trafficClass)
+        {
+            return lanes[static_cast<size_t>(trafficClass)];
+        }
+
+        MsquicSocket::SendLane* MsquicSocket::findLane(HQUIC stream)
+        {
+            for (SendLane& lane : lanes) {
+                if (lane.stream == stream) {
+                    return &lane;
+                }
+            }
+
+            return nullptr;
+        }
+
+        MsquicFrameCodec* MsquicSocket::findFrameCodec(HQUIC stream)
+        {
+            if (SendLane* lane = findLane(stream)) {
+                return &lane->frameCodec;
+            }
+
+            for (RemoteStream& remote : remoteStreams) {
+                if (remote.stream == stream) {
+                    return &remote.frameCodec;
+                }
+            }
+
+            return nullptr;
+        }
+
+        void MsquicSocket::writeAsync(unsigned char* data, size_t size)
+        {
+            writeAsync(data, size, TrafficClass::Signalling);
+        }
+
+        void MsquicSocket::writeAsync(unsigned char* data, size_t size, TrafficClass trafficClass)
+        {
+            // 队列只在本连接的 ioContext 上访问，其他线程的写入先投递过来
+            if (!ioContext.get_executor().running_in_this_thread()) {
+
+                boost::asio::post(ioContext, [self = shared_from_this(), data, size, trafficClass]() {
+                    self->writeAsync(data, size, trafficClass);
+                    });
+
+                return;
+            }
+
+            SendLane& lane = laneOf(trafficClass);
+
+            if (isShutDown.load() || !lane.stream) {
+                hope::utils::MsquicSharedBuffer::release(data);
+                return;
+            }
+
+            if (lane.queuedBytes.load(std::memory_order_relaxed) + size > maxQueuedBytes && !handleOverflow(lane, size)) {
+                hope::utils::MsquicSharedBuffer::release(data);
+                return;
+            }
+
+            // 记到 SEND_COMPLETE 为止，同一份共享缓冲区在每个会话上各记一次
+            if (!memoryBudget.tryCharge(size)) {
+
+                onMemoryBudgetExceeded("Send queue", size);
+
+                rejectedFrames.fetch_add(1, std::memory_order_relaxed);
+
+                hope::utils::MsquicSharedBuffer::release(data);
+
+                return;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+
+            if (lane.sendQueue.empty()) {
+                lane.batchStart = now;
+            }
+
+            lane.sendQueue.push_back(QUIC_BUFFER{ static_cast<uint32_t>(size), data });
+
+            size_t queued = lane.queuedBytes.fetch_add(size, std::memory_order_relaxed) + size;
+
+            peakQueuedBytes = std::max(peakQueuedBytes, queued);
+
+            // 控制消息不等本轮结束；批次已满，或循环繁忙本轮迟迟结束不了，也直接发送
+            if (trafficClass == TrafficClass::Control || lane.sendQueue.size() >= MAX_BATCH_BUFFERS || queued >= MAX_BATCH_BYTES || now - lane.batchStart >= maxBatchDelay) {
+
+                flushSend(lane);
+
+                return;
+            }
+
+            postFlush();
+        }
+
+        bool MsquicSocket::tryWriteAsync(unsigned char* data, size_t size)
+        {
+            return tryWriteAsync(data, size, TrafficClass::Signalling);
+        }
+
+        bool MsquicSocket::tryWriteAsync(unsigned char* data, size_t size, TrafficClass trafficClass)
+        {
+            // 其他线程上的判断是近似的，队列最终仍由 writeAsync 兜底
+            bool queueFull = overflowPolicy == SendOverflowPolicy::Reject && laneOf(trafficClass).queuedBytes.load(std::memory_order_relaxed) + size > maxQueuedBytes;
+
+            bool overBudget = hope::utils::MsquicMemoryBudget::action() == hope::utils::MemoryBudgetAction::Reject && memoryBudget.wouldExceed(size);
+
+            if (queueFull || overBudget) {
+
+                rejectedFrames.fetch_add(1, std::memory_order_relaxed);
+
+                hope::utils::MsquicMetrics::add(hope::utils::MsquicMetrics::instance().sendQueueOverflows);
+
+                hope::utils::MsquicSharedBuffer::release(data);
+
+                return false;
+            }
+
+            writeAsync(data, size, trafficClass);
+
+            return true;
+        }
+
+        bool MsquicSocket::handleOverflow(SendLane& lane, size_t size)
+        {
+            hope::utils::MsquicMetrics::add(hope::utils::MsquicMetrics::instance().sendQueueOverflows);
+
+            switch (overflowPolicy) {
+
+            case SendOverflowPolicy::DropOldest:
+            {
+                // 队列里都是整帧，丢掉队头不会破坏流上的分帧
+                while (!lane.sendQueue.empty() && lane.queuedBytes.load(std::memory_order_relaxed) + size > maxQueuedBytes) {
+
+                    QUIC_BUFFER oldest = lane.sendQueue.front();
+
+                    lane.sendQueue.pop_front();
+
+                    lane.queuedBytes.fetch_sub(oldest.Length, std::memory_order_relaxed);
+
+                    memoryBudget.release(oldest.Length);
+
+                    hope::utils::MsquicSharedBuffer::release(oldest.Buffer);
+
+                    droppedFrames.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                return true;
+            }
+
+            case SendOverflowPolicy::Disconnect:
+            {
+                LOG_WARNING("Send queue overflow (%zu bytes queued), disconnect %s", lane.queuedBytes.load(), accountId.c_str());
+
+                if (connection) {
+                    MsQuic->ConnectionShutdown(connection, QUIC_CONNECTION_SHUTDOWN_FLAG_NONE, 0);
+                }
+
+                return false;
+            }
+
+            default:
+            {
+                rejectedFrames.fetch_add(1, std::memory_order_relaxed);
+
+                return false;
+            }
+            }
+        }
+
+        void MsquicSocket::postFlush()
+        {
+            if (flushPosted) {
+                return;
+            }
+
+            flushPosted = true;
+
+            // 排在本轮已就绪的任务之后，同一轮里的写入都会进这一批
+            boost::asio::post(ioContext, [self = shared_from_this()]() {
+
+                self->flushPosted = false;
+
+                for (SendLane& lane : self->lanes) {
+                    self->flushSend(lane);
+                }
+
+                });
+        }
+
+        void MsquicSocket::flushSend(SendLane& lane)
+        {
+            // 连接已关闭，直接释放积压
+            if (isShutDown.load() || !lane.stream) {
+                releaseQueue(lane);
+                return;
+            }
+
+            hope::utils::MsquicMetrics& metrics = hope::utils::MsquicMetrics::instance();
+
+            while (!lane.sendQueue.empty()) {
+
+                uint64_t outstanding = lane.outstandingBytes.load(std::memory_order_acquire);
+
+                uint64_t ideal = lane.idealSendBufferSize.load(std::memory_order_relaxed);
+
+                // 在途字节已达理想值，等 SEND_COMPLETE 再继续
+                if (outstanding >= ideal) {
+                    return;
+                }
+
+                uint64_t budget = std::min<uint64_t>(ideal - outstanding, MAX_BATCH_BYTES);
+
+                SendBatchPtr batch(SendBatch::acquire());
+
+                batch->lane = &lane;
+
+                // 至少交出一帧，单帧超过预算也不拆
+                while (!lane.sendQueue.empty() && batch->buffers.size() < MAX_BATCH_BUFFERS) {
+
+                    const QUIC_BUFFER& next = lane.sendQueue.front();
+
+                    if (!batch->buffers.empty() && batch->bytes + next.Length > budget) {
+                        break;
+                    }
+
+                    batch->buffers.push_back(next);
+
+                    batch->bytes += next.Length;
+
+                    lane.sendQueue.pop_front();
+                }
+
+                lane.queuedBytes.fetch_sub(batch->bytes, std::memory_order_relaxed);
+
+                lane.outstandingBytes.fetch_add(batch->bytes, std::memory_order_relaxed);
+
+                // 本次 flush 还会继续交付时带 DELAY_SEND，最后一批才触发真正发送
+                bool more = !lane.sendQueue.empty() && outstanding + batch->bytes < ideal;
+
+                metrics.add(metrics.quicSends);
+
+                metrics.add(metrics.quicMessagesSent, batch->buffers.size());
+
+                sentFrames.fetch_add(batch->buffers.size(), std::memory_order_relaxed);
+
+                QUIC_STATUS status = MsQuic->StreamSend(
+                    lane.stream,
+                    batch->buffers.data(),
+                    static_cast<uint32_t>(batch->buffers.size()),
+                    more ? QUIC_SEND_FLAG_DELAY_SEND : QUIC_SEND_FLAG_NONE,
+                    batch.get());
+
+                if (QUIC_FAILED(status)) {
+
+                    LOG_ERROR("StreamSend failed: 0x%x, %zu frames dropped", status, batch->buffers.size());
+
+                    lane.outstandingBytes.fetch_sub(batch->bytes, std::memory_order_relaxed);
+
+                    memoryBudget.release(batch->bytes);
+
+                    MsQuic->StreamClose(lane.stream);
+
+                    lane.stream = nullptr;
+
+                    releaseQueue(lane);
+
+                    return;
+                }
+
+                // 由 SEND_COMPLETE 释放
+                batch.release();
+            }
+        }
+
+        void MsquicSocket::resumeSend(SendLane& lane)
+        {
+            if (lane.queuedBytes.load(std::memory_order_relaxed) == 0 || isShutDown.load()) {
+                return;
+            }
+
+            // 析构过程中 StreamClose 也会回调取消的 SEND_COMPLETE，这时已拿不到 shared_ptr
+            if (std::shared_ptr<MsquicSocket> self = weak_from_this().lock()) {
+                boost::asio::post(ioContext, [self = std::move(self), lane = &lane]() {
+                    self->flushSend(*lane);
+                    });
+            }
+        }
+
+        void MsquicSocket::onSendComplete(SendBatch* batch)
+        {
+            SendLane& lane = *batch->lane;
+
+            lane.outstandingBytes.fetch_sub(batch->bytes, std::memory_order_release);
+
+            memoryBudget.release(batch->bytes);
+
+            SendBatch::recycle(batch);
+
+            resumeSend(lane);
+        }
+
+        void MsquicSocket::releaseQueue(SendLane& lane)
+        {
+            for (QUIC_BUFFER& buffer : lane.sendQueue) {
+
+                memoryBudget.release(buffer.Length);
+
+                hope::utils::MsquicSharedBuffer::release(buffer.Buffer);
+            }
+
+            lane.sendQueue.clear();
+
+            lane.queuedBytes.store(0, std::memory_order_relaxed);
+        }
+
+        bool MsquicSocket::accountReceiveBuffer(const MsquicFrameCodec& frameCodec, size_t capacityBefore)
+        {
+            size_t capacityAfter = frameCodec.capacity();
+
+            if (capacityAfter <= capacityBefore) {
+                memoryBudget.release(capacityBefore - capacityAfter);
+                return true;
+            }
+
+            memoryBudget.charge(capacityAfter - capacityBefore);
+
+            if (!memoryBudget.exceeded()) {
+                return true;
+            }
+
+            hope::utils::MsquicMetrics::add(hope::utils::MsquicMetrics::instance().memoryBudgetExceeded);
+
+            LOG_WARNING("Receive buffer over memory budget (%zu / %zu bytes), disconnect %s", memoryBudget.used(), memoryBudget.limit(), accountId.c_str());
+
+            if (connection) {
+                MsQuic->ConnectionShutdown(connection, QUIC_CONNECTION_SHUTDOWN_FLAG_NONE, 0);
+            }
+
+            return false;
+        }
+
+        void MsquicSocket::onMemoryBudgetExceeded(const char* what, size_t size)
+        {
+            hope::utils::MsquicMetrics::add(hope::utils::MsquicMetrics::instance().memoryBudgetExceeded);
+
+            if (hope::utils::MsquicMemoryBudget::action() != hope::utils::MemoryBudgetAction::Disconnect) {
+                return;
+            }
+
+            LOG_WARNING("%s over memory budget (%zu + %zu / %zu bytes), disconnect %s", what, memoryBudget.used(), size, memoryBudget.limit(), accountId.c_str());
+
+            if (connection) {
+                MsQuic->ConnectionShutdown(connection, QUIC_CONNECTION_SHUTDOWN_FLAG_NONE, 0);
+            }
+        }
+
+        bool MsquicSocket::writeDatagram(unsigned char* data, size_t size)
+        {
+            if (!datagramSendEnabled.load(std::memory_order_relaxed) || size > maxDatagramSize.load(std::memory_order_relaxed)) {
+                hope::utils::MsquicSharedBuffer::release(data);
+                return false;
+            }
+
+            hope::utils::MsquicMetrics& metrics = hope::utils::MsquicMetrics::instance();
+
+            // 不可靠发送，连接已关闭或 msquic 拒收都直接丢弃，不回退到流上
+            if (isShutDown.load() || !connection) {
+                hope::utils::MsquicSharedBuffer::release(data);
+                metrics.add(metrics.datagramsDropped);
+                return true;
+            }
+
+            // 复用 SendBatch 持有引用，不属于任何发送通道
+            SendBatchPtr batch(SendBatch::acquire());
+
+            batch->buffers.push_back(QUIC_BUFFER{ static_cast<uint32_t>(size), data });
+
+            batch->bytes = size;
+
+            QUIC_STATUS status = MsQuic->DatagramSend(connection, batch->buffers.data(), 1, QUIC_SEND_FLAG_NONE, batch.get());
+
+            if (QUIC_FAILED(status)) {
+                metrics.add(metrics.datagramsDropped);
+                return true;
+            }
+
+            metrics.add(metrics.datagramsRelayed);
+
+            // 由 DATAGRAM_SEND_STATE_CHANGED 的终态释放
+            batch.release();
+
+            return true;
+        }
+
+        void MsquicSocket::setDatagramState(bool sendEnabled, uint16_t maxSendLength)
+        {
+            maxDatagramSize.store(maxSendLength, std::memory_order_relaxed);
+
+            datagramSendEnabled.store(sendEnabled, std::memory_order_relaxed);
+        }
+
+        void MsquicSocket::receiveDatagram(const QUIC_BUFFER* buffer)
+        {
+            hope::utils::MsquicMetrics& metrics = hope::utils::MsquicMetrics::instance();
+
+            std::string_view targetId;
+
+            std::string_view payload;
+
+            // 未注册的连接没有源 ID，格式错误的直接丢弃，都不回复
+            if (!isRegistered.load() || isShutDown.load() || !parseDatagram(buffer->Buffer, buffer->Length, targetId, payload)) {
+                metrics.add(metrics.datagramsDropped);
+                return;
+            }
+
+            // 实时事件本身可丢，超出预算只丢弃不断开
+            if (!memoryBudget.tryCharge(payload.size())) {
+                metrics.add(metrics.datagramsDropped);
+                return;
+            }
+
+            std::shared_ptr<MsquicData> msquicData = msquicDataPool->acquire(shared_from_this(), msquicManager);
+
+            msquicData->loadDatagram(targetId, payload);
+
+            msquicData->chargeMemory(&memoryBudget, payload.size());
+
+            msquicManager->getMsquicLogicSystem()->postTaskAsync(std::move(msquicData));
+        }
+
+        void MsquicSocket::onDatagramSendState(void* context, QUIC_DATAGRAM_SEND_STATE state)
+        {
+            if (context && QUIC_DATAGRAM_SEND_STATE_IS_FINAL(state)) {
+                SendBatch::recycle(static_cast<SendBatch*>(context));
+            }
+        }
+
+        void MsquicSocket::acceptBulkStream(HQUIC stream)
+        {
+            hope::utils::MsquicMetrics::add(hope::utils::MsquicMetrics::instance().bulkTransfers);
+
+            std::make_shared<MsquicBulkRelay>(weak_from_this(), stream)->start();
+        }
+
+        void MsquicSocket::requestBulkRoute(std::shared_ptr<MsquicBulkRelay> relay, std::string_view targetId)
+        {
+            std::shared_ptr<MsquicData> msquicData = msquicDataPool->acquire(shared_from_this(), msquicManager);
+
+            msquicData->loadBulk(targetId, std::move(relay));
+
+            msquicManager->getMsquicLogicSystem()->postTaskAsync(std::move(msquicData));
+        }
+
+        HQUIC MsquicSocket::openBulkStream(QUIC_STREAM_CALLBACK_HANDLER handler, void* context)
+        {
+            if (isShutDown.load() || !connection) {
+                return nullptr;
+            }
+
+            HQUIC stream = nullptr;
+
+            if (QUIC_FAILED(MsQuic->StreamOpen(connection, QUIC_STREAM_OPEN_FLAG_UNIDIRECTIONAL, handler, context, &stream))) {
+                return nullptr;
+            }
+
+            uint16_t priority = trafficClassPriority(TrafficClass::Bulk);
+
+            MsQuic->SetParam(stream, QUIC_PARAM_STREAM_PRIORITY, sizeof(priority), &priority);
+
+            if (QUIC_FAILED(MsQuic->StreamStart(stream, QUIC_STREAM_START_FLAG_IMMEDIATE))) {
+                MsQuic->StreamClose(stream);
+                return nullptr;
+            }
+
+            return stream;
+        }
+
+        void MsquicSocket::handleFrame(std::span<const uint8_t> frame)
+        {
+            std::shared_ptr<MsquicData> msquicData;
+
+            if (protocol == WireProtocol::Binary) {
+
+                // 二进制帧：路由字段直接取自帧头，不需要 JSON 解析
+                BinaryFrame binaryFrame;
+
+                if (!parseBinaryFrame(frame.data(), frame.size(), binaryFrame)) {
+                    LOG_ERROR("Binary frame parse error, size: %zu", frame.size());
+                    return;
+                }
+
+                if (!isStreamRequestType(binaryFrame.header.requestType)) {
+                    LOG_WARNING("Request type %u not allowed on a stream, dropped", static_cast<unsigned>(binaryFrame.header.requestType));
+                    return;
+                }
+
+                // 压缩负载按声明的原始长度计入预算，超过帧长上限的直接丢弃
+                size_t taskBytes = binaryFrame.payload.size();
+
+                if (binaryFrame.header.flags & BINARY_FLAG_COMPRESSED) {
+
+                    taskBytes = MsquicCompression::originalSize(binaryFrame.payload);
+
+                    if (taskBytes > maxFrameSize) {
+                        LOG_ERROR("Binary payload original size %zu exceeds %zu, dropped", taskBytes, maxFrameSize);
+                        return;
+                    }
+                }
+
+                if (!memoryBudget.tryCharge(taskBytes)) {
+                    onMemoryBudgetExceeded("Pending task", taskBytes);
+                    return;
+                }
+
+                msquicData = msquicDataPool->acquire(shared_from_this(), msquicManager);
+
+                // 逻辑线程处理完、MsquicData 回收时归还；压缩负载按原始长度计，转给 JSON 目标时可能解压
+                msquicData->chargeMemory(&memoryBudget, taskBytes);
+
+                msquicData->loadBinary(binaryFrame);
+            }
+            else {
+
+                std::string_view jsonStr(
+                    reinterpret_cast<const char*>(frame.data() + sizeof(int64_t)),
+                    frame.size() - sizeof(int64_t)
+                );
+
+                // 只提取路由字段，不构建 DOM
+                msquicData = msquicDataPool->acquire(shared_from_this(), msquicManager);
+
+                boost::json::error_code ec;
+
+                if (!msquicData->loadJson(jsonStr, ec)) {
+                    LOG_ERROR("JSON parse error: %s", ec.message().c_str());
+                    return;
+                }
+
+                if (!isStreamRequestType(msquicData->requestType)) {
+                    LOG_WARNING("Request type %lld not allowed on a stream, dropped", static_cast<long long>(msquicData->requestType));
+                    return;
+                }
+
+                // 逻辑线程处理完、MsquicData 回收时归还
+                size_t taskBytes = msquicData->payload.size();
+
+                if (!memoryBudget.tryCharge(taskBytes)) {
+                    onMemoryBudgetExceeded("Pending task", taskBytes);
+                    return;
+                }
+
+                msquicData->chargeMemory(&memoryBudget, taskBytes);
+            }
+
+            msquicManager->getMsquicLogicSystem()->postTaskAsync(std::move(msquicData));
+        }
+
+        void MsquicSocket::receiveAsync(HQUIC stream, QUIC_STREAM_EVENT* event)
+        {
+            consumeBuffers(stream, event->RECEIVE.Buffers, event->RECEIVE.BufferCount);
+        }
+
+        QUIC_STATUS MsquicSocket::receiveDeferred(HQUIC stream, QUIC_STREAM_EVENT* event)
+        {
+            auto* rev = &event->RECEIVE;
+
+            // 数据在 StreamReceiveComplete 之前一直有效，描述符数组自己拷贝一份
+            std::vector<QUIC_BUFFER> buffers(rev->Buffers, rev->Buffers + rev->BufferCount);
+
+            uint64_t totalLength = rev->TotalBufferLength;
+
+            // 完成之前 msquic 不会再投递该流的数据，分帧器只在逻辑线程上访问
+            boost::asio::post(ioContext, [self = shared_from_this(), stream, buffers = std::move(buffers), totalLength]() {
+
+                self->consumeBuffers(stream, buffers.data(), static_cast<uint32_t>(buffers.size()));
+
+                // 连接已关闭时句柄已失效
+                if (self->isShutDown.load() || !self->findFrameCodec(stream)) {
+                    return;
+                }
+
+                // 逻辑线程处理不过来时不再完成，由 QUIC 流控反压对端
+                MsQuic->StreamReceiveComplete(stream, totalLength);
+
+                });
+
+            return QUIC_STATUS_PENDING;
+        }
+
+        bool MsquicSocket::consumeBuffers(HQUIC stream, const QUIC_BUFFER* buffers, uint32_t bufferCount)
+        {
+            // 每条流各自分帧，不同流上的帧互不拼接
+            MsquicFrameCodec* frameCodec = findFrameCodec(stream);
+
+            if (!frameCodec) {
+                return false;
+            }
+
+            size_t capacityBefore = frameCodec->capacity();
+
+            for (uint32_t i = 0; i < bufferCount; ++i) {
+
+                const auto& buf = buffers[i];
+
+                // 分片内的完整帧直接以视图交出，跨分片的帧由分帧器拼接
+                MsquicFrameCodec::Result result = frameCodec->feed(
+                    std::span<const uint8_t>(buf.Buffer, buf.Length),
+                    [this](std::span<const uint8_t> frame) {
+                        handleFrame(frame);
+                    });
+
+                if (result != MsquicFrameCodec::Result::Ok) {
+
+                    // 帧头非法或超长，流已无法重新同步，直接断开
+                    LOG_ERROR("Invalid frame (%d) from %s, shutdown connection", static_cast<int>(result), accountId.c_str());
+
+                    if (connection) {
+                        MsQuic->ConnectionShutdown(connection, QUIC_CONNECTION_SHUTDOWN_FLAG_NONE, 0);
+                    }
+
+                    accountReceiveBuffer(*frameCodec, capacityBefore);
+
+                    return false;
+                }
+            }
+
+            return accountReceiveBuffer(*frameCodec, capacityBefore);
+        }
+
+        boost::asio::awaitable<void> MsquicSocket::registrationTimeout() {
+
+            using namespace std::chrono_literals;
+
+            // 1. 设置 10 秒超时
+            registrationTimer.expires_after(10s);
+
+            // 2. 异步等待计时器或被取消
+            boost::system::error_code ec;
+
+            co_await registrationTimer.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+
+            // 3. 检查是否超时
+            if (ec == boost::asio::error::operation_aborted) {
+                // 计时器被取消 (说明在 10s 内完成了注册)
+                co_return;
+            }
+
+            // 4. 超时发生，且尚未注册，则关闭连接
+            if (!isRegistered.load()) {
+                this->clear();
+
+            }
+
+            co_return;
+        }
+
+
+		HQUIC MsquicSocket::createStream(TrafficClass trafficClass)
+		{
+            HQUIC stream = nullptr;
+            QUIC_STATUS status = MsQuic->StreamOpen(
+                connection,
+                QUIC_STREAM_OPEN_FLAG_NONE,
+                MsquicSocketHandle,
+                this,
+                &stream);
+
+            if (QUIC_FAILED(status)) {
+                return nullptr;
+            }
+
+            MsQuic->SetCallbackHandler(
+                stream,
+                MsquicSocketHandle,   // 你的静态流回调
+                this);
+
+            uint16_t priority = trafficClassPriority(trafficClass);
+
+            MsQuic->SetParam(stream, QUIC_PARAM_STREAM_PRIORITY, sizeof(priority), &priority);
+
+            status = MsQuic->StreamStart(
+                stream,
+                QUIC_STREAM_START_FLAG_IMMEDIATE | QUIC_STREAM_START_FLAG_INDICATE_PEER_ACCEPT | QUIC_STREAM_START_FLAG_PRIORITY_WORK);
+
+            if (QUIC_FAILED(status)) {
+                MsQuic->StreamClose(stream);
+                return nullptr;
+            }
+
+            return stream;
+
+		}
+
+
+        void MsquicSocket::setAccountId(const std::string& accountId) { 
+        
+            this->accountId = accountId;
+
+        }
+
+        std::string& MsquicSocket::getAccountId() { 
+        
+            return this->accountId;
+
+        }
+
+        void MsquicSocket::setRegistered(bool registered) {
+            
+            this->isRegistered.store(registered);
+
+            if (isRegistered.load()) {
+            
+                registrationTimer.cancel();
+
+            }
+
+        }
+
+        bool MsquicSocket::getRegistered() {
+            return this->isRegistered ;
+        }
+
+        MsquicManager* MsquicSocket::getMsquicManager()
+        {
+            return msquicManager;
+        }
+
+        bool MsquicSocket::addRemoteStream(HQUIC remoteStream) {
+
+            for (RemoteStream& remote : remoteStreams) {
+
+                if (!remote.stream) {
+
+                    remote.frameCodec.setProtocol(protocol);
+
+                    remote.stream = remoteStream;
+
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        boost::asio::io_context& MsquicSocket::getIoCompletionPorts()
+        {
+            return this->ioContext;
+        }
+
+        SocketType MsquicSocket::getType() {
+
+            return SocketType::MsquicSocket;
+
+        }
+
+        void MsquicSocket::setProtocol(WireProtocol protocol) {
+
+            this->protocol = protocol;
+
+            for (SendLane& lane : lanes) {
+                lane.frameCodec.setProtocol(protocol);
+            }
+
+            for (RemoteStream& remote : remoteStreams) {
+                remote.frameCodec.setProtocol(protocol);
+            }
+
+        }
+
+        WireProtocol MsquicSocket::getProtocol() {
+
+            return protocol;
+
+        }
+
+        size_t MsquicSocket::frameHeaderSize() {
+
+            return hope::quic::frameHeaderSize(protocol);
+
+        }
+
+        void MsquicSocket::encodeFrameHeader(unsigned char* header, size_t bodyLength, int64_t requestType, int64_t state) {
+
+            hope::quic::encodeFrameHeader(protocol, header, bodyLength, requestType, state);
+
+        }
+
+
+        // Stream callback
+        QUIC_STATUS QUIC_API MsquicSocketHandle(
+            HQUIC stream,
+            void* context,
+            QUIC_STREAM_EVENT* event) {
+
+            MsquicSocket * msquicSocket = static_cast<MsquicSocket*>(context);
+
+            if (msquicSocket == nullptr || event == nullptr) {
+                return QUIC_STATUS_INVALID_PARAMETER;
+            }
+
+            switch (event->Type) {
+            case QUIC_STREAM_EVENT_START_COMPLETE:
+            {
+                break;
+            }
+           
+
+            case QUIC_STREAM_EVENT_RECEIVE:
+            {
+
+                if (msquicSocket->deferredReceive) {
+
+                    return msquicSocket->receiveDeferred(stream, event);
+
+                }
+
+                msquicSocket->receiveAsync(stream, event);
+
+                break;
+            }
+         
+
+            // Add handler for QUIC_STREAM_EVENT_SEND_COMPLETE (type 2)
+            case QUIC_STREAM_EVENT_SEND_COMPLETE:
+            {
+                // 整批释放，取消的发送同样走这里
+                msquicSocket->onSendComplete(static_cast<MsquicSocket::SendBatch*>(event->SEND_COMPLETE.ClientContext));
+
+                break;
+            }
+    
+
+            // Add handler for QUIC_STREAM_EVENT_PEER_SEND_ABORTED (type 6)
+            case QUIC_STREAM_EVENT_PEER_SEND_ABORTED:
+            {
+                break;
+
+            }
+   
+
+            case QUIC_STREAM_EVENT_PEER_SEND_SHUTDOWN: {
+                break;
+            }
+                                           
+            case QUIC_STREAM_EVENT_SEND_SHUTDOWN_COMPLETE:
+            {
+                break;
+            }
+    
+
+            case QUIC_STREAM_EVENT_SHUTDOWN_COMPLETE: {
+                break;
+            }
+            case QUIC_STREAM_EVENT_IDEAL_SEND_BUFFER_SIZE:
+            {
+                // 按 msquic 估算的 BDP 调整该流的在途上限
+                MsquicSocket::SendLane* lane = msquicSocket->findLane(stream);
+
+                if (!lane) {
+                    break;
+                }
+
+                lane->idealSendBufferSize.store(std::max<uint64_t>(event->IDEAL_SEND_BUFFER_SIZE.ByteCount, MsquicSocket::MAX_BATCH_BYTES / 4), std::memory_order_relaxed);
+
+                msquicSocket->resumeSend(*lane);
+
+                break;
+            }
+        
+
+            default:
+            {
+                break;
+            }
+            }
+
+            return QUIC_STATUS_SUCCESS;
+        }
+
+	}
 }
\ No newline at end of file
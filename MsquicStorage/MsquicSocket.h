@@ -1,97 +1,336 @@
-#pragma once
-
-#include <memory>
-
-#include <msquic.hpp>
-#include <boost/asio.hpp>
-#include <boost/asio/awaitable.hpp>
-
-#include "MsquicSocketInterface.h"
-
-namespace hope {
-
-	namespace quic {
-
-		class MsquicManager;
-	
-		class MsquicSocket :public MsquicSocketInterface, public std::enable_shared_from_this<MsquicSocket>
-		{
-			friend QUIC_STATUS QUIC_API MsquicSocketHandle(HQUIC stream, void* context, QUIC_STREAM_EVENT* event);
-		public:
-
-			MsquicSocket(HQUIC connection, MsquicManager * msquicManager, boost::asio::io_context& ioContext);
-
-			~MsquicSocket();
-
-			void runEventLoop();
-
-			void writeAsync(unsigned char * data,size_t size);
-
-			void setAccountId(const std::string& accountId);
-
-			std::string& getAccountId();
-
-			void setRegistered(bool registered);
-
-			bool getRegistered();
-
-			MsquicManager* getMsquicManager();
-
-			void setRemoteStream(HQUIC remoteStream);
-
-			boost::asio::io_context& getIoCompletionPorts();
-
-			void shutDown();
-
-			void clear();
-
-			SocketType getType();
-
-		private:
-
-			HQUIC createStream();
-
-			void receiveAsync(QUIC_STREAM_EVENT* revice);
-
-			void tryParse();
-
-			boost::asio::awaitable<void> registrationTimeout();
-
-		private:
-
-			MsquicManager* msquicManager;
-
-			HQUIC connection;
-
-			HQUIC stream;
-
-			HQUIC remoteStream;
-
-			boost::asio::io_context& ioContext;
-
-			std::vector<uint8_t>    receivedBuffer;        // 未消费字节
-
-			bool                    headerReady = false;
-
-			short                   msgType = 0;
-
-			int64_t                 payloadLen = 0;
-
-			std::string accountId;
-
-			boost::asio::steady_timer registrationTimer; // 计时器成员
-
-			std::atomic<bool> isRegistered{ false }; // 新增：注册状态标志
-
-			std::atomic<bool> isShutDown{ false };
-
-		};
-
-		QUIC_STATUS QUIC_API MsquicSocketHandle(HQUIC stream,void* context,QUIC_STREAM_EVENT* event);
-
-	}
-
-}
-
-
-
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <array>
+#include <chrono>
+
+#include <msquic.hpp>
+#include <boost/asio.hpp>
+#include <boost/asio/awaitable.hpp>
+
+#include "MsquicSocketInterface.h"
+#include "MsquicData.h"
+#include "MsquicFrameCodec.h"
+
+namespace hope {
+
+	namespace quic {
+
+		class MsquicManager;
+
+		class MsquicBulkRelay;
+
+		// 发送队列超过 MsquicStorage.maxQueuedBytes 时的处理方式
+		enum class SendOverflowPolicy {
+
+			DropOldest = 0,   // 丢弃队头还没交给 msquic 的整帧
+
+			Reject = 1,       // 拒收新帧，转发方回复 503
+
+			Disconnect = 2,   // 断开慢连接
+
+		};
+	
+		class MsquicSocket :public MsquicSocketInterface, public std::enable_shared_from_this<MsquicSocket>
+		{
+			friend QUIC_STATUS QUIC_API MsquicSocketHandle(HQUIC stream, void* context, QUIC_STREAM_EVENT* event);
+		public:
+
+			MsquicSocket(HQUIC connection, MsquicManager * msquicManager, boost::asio::io_context& ioContext);
+
+			~MsquicSocket();
+
+			void runEventLoop();
+
+			// 不指定类别的写入走信令通道
+			void writeAsync(unsigned char * data,size_t size);
+
+			void writeAsync(unsigned char* data, size_t size, TrafficClass trafficClass);
+
+			// Reject 策略下队列已满时拒收并释放 data
+			bool tryWriteAsync(unsigned char* data, size_t size);
+
+			bool tryWriteAsync(unsigned char* data, size_t size, TrafficClass trafficClass);
+
+			// 直接交给 msquic 不可靠发送，不进发送队列；对端没开启或超过路径允许的长度时返回 false
+			bool writeDatagram(unsigned char* data, size_t size);
+
+			// DATAGRAM_STATE_CHANGED：握手后对端是否接收以及当前路径允许的最大长度
+			void setDatagramState(bool sendEnabled, uint16_t maxSendLength);
+
+			// msquic 工作线程上调用，buffer 只在回调期间有效
+			void receiveDatagram(const QUIC_BUFFER* buffer);
+
+			// DATAGRAM_SEND_STATE_CHANGED：到达终态（确认、丢失或取消）时归还缓冲区
+			static void onDatagramSendState(void* context, QUIC_DATAGRAM_SEND_STATE state);
+
+			// 对端开的单向流是一次批量传输，交给中转对象
+			void acceptBulkStream(HQUIC stream);
+
+			// 流头收齐后按目标 ID 走转发路由，在目标所在线程上 attach
+			void requestBulkRoute(std::shared_ptr<MsquicBulkRelay> relay, std::string_view targetId);
+
+			// 在本连接上开一条批量优先级的单向流，失败返回 nullptr
+			HQUIC openBulkStream(QUIC_STREAM_CALLBACK_HANDLER handler, void* context);
+
+			void setAccountId(const std::string& accountId);
+
+			std::string& getAccountId();
+
+			void setRegistered(bool registered);
+
+			bool getRegistered();
+
+			MsquicManager* getMsquicManager();
+
+			// 对端发起的流，每个类别最多一条，超出时返回 false
+			bool addRemoteStream(HQUIC remoteStream);
+
+			boost::asio::io_context& getIoCompletionPorts();
+
+			void shutDown();
+
+			void clear();
+
+			SocketType getType();
+
+			void setProtocol(WireProtocol protocol);
+
+			WireProtocol getProtocol();
+
+			size_t frameHeaderSize();
+
+			void encodeFrameHeader(unsigned char* header, size_t bodyLength, int64_t requestType, int64_t state);
+
+		private:
+
+			HQUIC createStream(TrafficClass trafficClass);
+
+			void receiveAsync(HQUIC stream, QUIC_STREAM_EVENT* revice);
+
+			// 延迟完成模式：借用 msquic 的缓冲区，投递到逻辑线程解析后再 StreamReceiveComplete
+			QUIC_STATUS receiveDeferred(HQUIC stream, QUIC_STREAM_EVENT* revice);
+
+			bool consumeBuffers(HQUIC stream, const QUIC_BUFFER* buffers, uint32_t bufferCount);
+
+			void handleFrame(std::span<const uint8_t> frame);
+
+			boost::asio::awaitable<void> registrationTimeout();
+
+			// 发送队列：vector + 队头下标，取空后整体复位，容量保留
+			// std::deque 每跨过一个块就分配/释放一次，稳态下也在分配
+			struct SendQueue {
+
+				std::vector<QUIC_BUFFER> items;
+
+				size_t head = 0;
+
+				bool empty() const { return head == items.size(); }
+
+				size_t size() const { return items.size() - head; }
+
+				QUIC_BUFFER& front() { return items[head]; }
+
+				std::vector<QUIC_BUFFER>::iterator begin() { return items.begin() + head; }
+
+				std::vector<QUIC_BUFFER>::iterator end() { return items.end(); }
+
+				void push_back(const QUIC_BUFFER& buffer);
+
+				void pop_front() {
+
+					if (++head == items.size()) {
+						clear();
+					}
+				}
+
+				void clear() {
+
+					items.clear();
+
+					head = 0;
+				}
+
+			};
+
+			// 一个流量类别的发送通道：服务端发起的流 + 独立的发送队列和在途限额，一条通道积压不影响其他通道
+			struct SendLane {
+
+				HQUIC stream = nullptr;
+
+				// 对端在这条流上回写的数据
+				MsquicFrameCodec frameCodec;
+
+				// 合并发送：同一轮事件循环内写出的帧进队列，在本轮末尾一次 StreamSend，只在 ioContext 线程访问
+				SendQueue sendQueue;
+
+				// 队列中的字节数，tryWriteAsync 可能在其他线程读取
+				std::atomic<size_t> queuedBytes{ 0 };
+
+				// 已交给 msquic 还没 SEND_COMPLETE 的字节数，超过理想值就停止交付，积压留在队列里
+				std::atomic<uint64_t> outstandingBytes{ 0 };
+
+				std::atomic<uint64_t> idealSendBufferSize{ INITIAL_IDEAL_SEND_BUFFER };
+
+				std::chrono::steady_clock::time_point batchStart;
+
+			};
+
+			// 对端发起的流只用于接收，各自分帧
+			struct RemoteStream {
+
+				HQUIC stream = nullptr;
+
+				MsquicFrameCodec frameCodec;
+
+			};
+
+			// 一次多缓冲区 StreamSend 的全部帧，每帧持有一份引用，作为 ClientContext 在 SEND_COMPLETE 时整体归还
+			// 对象连同 buffers 的容量在进程级池里复用，SEND_COMPLETE 可能在任意 msquic 工作线程上归还
+			struct SendBatch {
+
+				SendLane* lane = nullptr;
+
+				std::vector<QUIC_BUFFER> buffers;
+
+				uint64_t bytes = 0;
+
+				~SendBatch() {
+					clear();
+				}
+
+				// 归还帧引用，保留 buffers 容量
+				void clear() {
+
+					for (QUIC_BUFFER& buffer : buffers) {
+						hope::utils::MsquicSharedBuffer::release(buffer.Buffer);
+					}
+
+					buffers.clear();
+
+					bytes = 0;
+
+					lane = nullptr;
+				}
+
+				static SendBatch* acquire();
+
+				static void recycle(SendBatch* batch);
+
+				struct Pool;
+
+				static Pool& pool();
+
+				struct Recycle {
+					void operator()(SendBatch* batch) const { recycle(batch); }
+				};
+
+			};
+
+			using SendBatchPtr = std::unique_ptr<SendBatch, SendBatch::Recycle>;
+
+			SendLane& laneOf(TrafficClass trafficClass);
+
+			// 按流句柄找到所属通道，不是本会话发起的流返回 nullptr
+			SendLane* findLane(HQUIC stream);
+
+			// 接收数据的流对应的分帧器
+			MsquicFrameCodec* findFrameCodec(HQUIC stream);
+
+			// 在途字节数允许的范围内把队列交给 msquic，只在 ioContext 线程调用
+			void flushSend(SendLane& lane);
+
+			// 本轮末尾按优先级从高到低 flush 所有通道
+			void postFlush();
+
+			// msquic 回调线程上调用：在途字节变少或理想值变大后，有积压就投递一次 flush
+			void resumeSend(SendLane& lane);
+
+			void onSendComplete(SendBatch* batch);
+
+			// 通道队列放不下 size 字节时按策略处理，返回 false 表示丢弃新帧
+			bool handleOverflow(SendLane& lane, size_t size);
+
+			void releaseQueue(SendLane& lane);
+
+			// 接收缓冲按分帧器容量的变化记账，超出预算只能断开：半帧丢了流就无法重新同步
+			bool accountReceiveBuffer(const MsquicFrameCodec& frameCodec, size_t capacityBefore);
+
+			// 发送队列或待处理任务超出会话/全局预算，按 MsquicStorage.memoryBudgetAction 处理，调用方丢弃新数据
+			void onMemoryBudgetExceeded(const char* what, size_t size);
+
+			void closeStreams();
+
+			// 单批次上限，超过后立即发送
+			static constexpr size_t MAX_BATCH_BUFFERS = 64;
+
+			static constexpr size_t MAX_BATCH_BYTES = 256 * 1024;
+
+			// 收到 IDEAL_SEND_BUFFER_SIZE 之前使用的在途上限
+			static constexpr uint64_t INITIAL_IDEAL_SEND_BUFFER = 128 * 1024;
+
+		private:
+
+			MsquicManager* msquicManager;
+
+			HQUIC connection;
+
+			// 下标为 TrafficClass
+			std::array<SendLane, TRAFFIC_CLASS_COUNT> lanes;
+
+			std::array<RemoteStream, TRAFFIC_CLASS_COUNT> remoteStreams;
+
+			boost::asio::io_context& ioContext;
+
+			WireProtocol protocol = WireProtocol::Json;
+
+			std::shared_ptr<MsquicDataPool> msquicDataPool = std::make_shared<MsquicDataPool>();
+
+			// MsquicStorage.deferredReceive，开启后解析不占用 msquic 工作线程
+			bool deferredReceive;
+
+			// MsquicStorage.maxFrameSize，同时限制压缩负载解压后的长度
+			size_t maxFrameSize;
+
+			std::string accountId;
+
+			boost::asio::steady_timer registrationTimer; // 计时器成员
+
+			std::atomic<bool> isRegistered{ false }; // 新增：注册状态标志
+
+			std::atomic<bool> isShutDown{ false };
+
+			std::atomic<bool> datagramSendEnabled{ false };
+
+			std::atomic<uint16_t> maxDatagramSize{ 0 };
+
+			// MsquicStorage.maxQueuedBytes / sendOverflowPolicy，每条通道各自计算
+			size_t maxQueuedBytes;
+
+			SendOverflowPolicy overflowPolicy;
+
+			bool flushPosted = false;
+
+			// MsquicStorage.sendBatchDelayMicros，循环繁忙时半满批次最多等待这么久
+			std::chrono::microseconds maxBatchDelay;
+
+			// 本会话的发送统计，析构时打印
+			std::atomic<uint64_t> sentFrames{ 0 };
+
+			std::atomic<uint64_t> droppedFrames{ 0 };
+
+			std::atomic<uint64_t> rejectedFrames{ 0 };
+
+			size_t peakQueuedBytes = 0;
+
+		};
+
+		QUIC_STATUS QUIC_API MsquicSocketHandle(HQUIC stream,void* context,QUIC_STREAM_EVENT* event);
+
+	}
+
+}
+
+
+
@@ -1,597 +1,700 @@
-#include "MsquicSocketClient.h"
-#include "MsQuicApi.h"
-#include "Utils.h"
-
-namespace hope {
-    namespace quic {
-
-        MsquicSocketClient::MsquicSocketClient(boost::asio::io_context& ioContext)
-            : ioContext(ioContext)
-            , connection(nullptr)
-            , stream(nullptr)
-            , registration(nullptr)
-            , configuration(nullptr)
-            , serverPort(0)
-            , payloadLen(0)
-            , connected(false) {
-        }
-
-        MsquicSocketClient::~MsquicSocketClient() {
-            clear();
-        }
-
-        bool MsquicSocketClient::initialize(const std::string& alpn) {
-
-            if (MsQuic == nullptr) {
-
-                return false;
-
-            }
-
-            this->alpn = alpn;
-
-            return true;
-        }
-
-        bool MsquicSocketClient::connect(std::string serverAddress, uint64_t serverPort) {
-            // 如果已有连接，先完全清理
-            if (connection != nullptr) {
-                LOG_INFO("reclear msquic connection");
-
-                disconnect();
-
-            }
-
-            if (!registration) {
-
-                registration = new MsQuicRegistration("MsquicSocketClient");
-
-                if (!registration->IsValid()) {
-
-                    return false;
-
-                }
-
-                // 创建注册
-                registration = new MsQuicRegistration("MsquicSocketClient");
-                if (!registration->IsValid()) {
-                    return false;
-                }
-
-                // 配置设置
-                MsQuicSettings settings;
-
-                settings.SetIdleTimeoutMs(10000);
-
-                settings.SetKeepAlive(5000);
-
-                settings.SetPeerBidiStreamCount(2);
-
-                // 创建ALPN
-                MsQuicAlpn alpnBuffer(alpn.c_str());
-
-                // 创建配置
-                QUIC_CREDENTIAL_CONFIG credConfig = { 0 };
-                credConfig.Type = QUIC_CREDENTIAL_TYPE_NONE;
-                credConfig.Flags = QUIC_CREDENTIAL_FLAG_CLIENT | QUIC_CREDENTIAL_FLAG_NO_CERTIFICATE_VALIDATION;
-
-                configuration = new MsQuicConfiguration(
-                    *registration,
-                    alpnBuffer,
-                    settings,
-                    MsQuicCredentialConfig(credConfig)
-                );
-
-                if (!configuration->IsValid()) {
-
-                    LOG_ERROR("MsQuicConfiguration Init Error");
-
-                    return false;
-                }
-
-            }
-
-            this->serverAddress = serverAddress;
-            this->serverPort = serverPort;
-
-            // 创建连接
-            QUIC_STATUS status = MsQuic->ConnectionOpen(
-                *registration,
-                MsquicClientConnectionHandle,
-                this,
-                &connection);
-
-            if (QUIC_FAILED(status)) {
-                LOG_ERROR("ConnectionOpen failed: 0x%08X", status);
-                return false;
-            }
-
-            // 启动连接
-            status = MsQuic->ConnectionStart(
-                connection,
-                *configuration,
-                QUIC_ADDRESS_FAMILY_INET,
-                serverAddress.c_str(),
-                serverPort);
-
-            if (QUIC_FAILED(status)) {
-                LOG_ERROR("ConnectionStart failed:0x%08X", status);
-                MsQuic->ConnectionClose(connection);
-                connection = nullptr;
-                return false;
-            }
-
-            // 创建流
-            stream = createStream();
-            if (stream == nullptr) {
-                LOG_ERROR("create MsquicStream failed");
-                MsQuic->ConnectionClose(connection);
-                connection = nullptr;
-                return false;
-            }
-
-            connected.store(true);
-            return true;
-        }
-
-        HQUIC MsquicSocketClient::createStream() {
-            HQUIC stream = nullptr;
-            QUIC_STATUS status = MsQuic->StreamOpen(
-                connection,
-                QUIC_STREAM_OPEN_FLAG_NONE,
-                MsquicClientStreamHandle,
-                this,
-                &stream);
-
-            if (QUIC_FAILED(status)) {
-                return nullptr;
-            }
-
-            status = MsQuic->StreamStart(
-                stream,
-                QUIC_STREAM_START_FLAG_IMMEDIATE);
-
-            if (QUIC_FAILED(status)) {
-                MsQuic->StreamClose(stream);
-                return nullptr;
-            }
-
-            return stream;
-        }
-
-        bool MsquicSocketClient::writeAsync(unsigned char* data, size_t size) {
-            if (!connected || stream == nullptr) {
-                return false;
-            }
-
-            QUIC_BUFFER* buffer = new QUIC_BUFFER;
-            buffer->Buffer = data;
-            buffer->Length = static_cast<uint32_t>(size);
-
-            QUIC_STATUS status = MsQuic->StreamSend(
-                stream,
-                buffer,
-                1,
-                QUIC_SEND_FLAG_NONE,
-                buffer);
-
-            if (QUIC_FAILED(status)) {
-                delete buffer;
-                return false;
-            }
-
-            return true;
-        }
-
-        bool MsquicSocketClient::writeJsonAsync(const boost::json::object& json) {
-            // 构建消息格式：length + body
-            std::string body = boost::json::serialize(json);
-            int64_t bodyLength = static_cast<int64_t>(body.size());
-            size_t totalSize = sizeof(int64_t) + bodyLength;
-
-            unsigned char* buffer = new unsigned char[totalSize];
-
-            // 写入length
-            *reinterpret_cast<int64_t*>(buffer) = bodyLength;
-
-            // 写入body
-            memcpy(buffer + sizeof(int64_t), body.data(), bodyLength);
-
-            return writeAsync(buffer, totalSize);
-        }
-
-
-        void MsquicSocketClient::disconnect() {
-            // 防止重复调用
-            if (!connected.load() && connection == nullptr) {
-                return;
-            }
-
-            // 立即标记逻辑断开，阻止新的写入
-            connected.store(false);
-
-            if (registration) {
-
-                registration->Shutdown(QUIC_CONNECTION_SHUTDOWN_FLAG_NONE, 0);
-
-                registration = nullptr;
-
-            }
-
-            if (configuration) {
-
-                delete configuration;
-
-                configuration = nullptr;
-
-            }
-
-            if (stream) {
-                // 使用中止标志立即关闭
-                MsQuic->StreamShutdown(stream,
-                    QUIC_STREAM_SHUTDOWN_FLAG_ABORT_SEND |
-                    QUIC_STREAM_SHUTDOWN_FLAG_ABORT_RECEIVE,
-                    QUIC_STATUS_SUCCESS);
-
-                MsQuic->StreamClose(stream);
-
-                stream = nullptr;
-            }
-
-            if (remoteStream) {
-
-                MsQuic->StreamShutdown(remoteStream,
-                    QUIC_STREAM_SHUTDOWN_FLAG_ABORT_SEND |
-                    QUIC_STREAM_SHUTDOWN_FLAG_ABORT_RECEIVE,
-                    QUIC_STATUS_SUCCESS);
-
-                MsQuic->StreamClose(remoteStream);
-
-                remoteStream = nullptr;
-            }
-
-            if (connection) {
-
-                MsQuic->ConnectionShutdown(
-                    connection,
-                    QUIC_CONNECTION_SHUTDOWN_FLAG_SILENT,
-                    QUIC_STATUS_SUCCESS
-                );
-
-                MsQuic->ConnectionClose(connection);
-
-                connection = nullptr;
-            }
-
-        }
-
-        void MsquicSocketClient::setOnDataReceivedHandle(std::function<void(boost::json::object&)> handle) {
-            onDataReceivedHandle = std::move(handle);
-        }
-
-        void MsquicSocketClient::setOnConnectionHandle(std::function<void(bool)> handle) {
-            onConnectionHandle = std::move(handle);
-        }
-
-        bool MsquicSocketClient::isConnected() const {
-            return connected.load();
-        }
-
-        void MsquicSocketClient::handleReceive(QUIC_STREAM_EVENT* event)
-        {
-            auto* rev = &event->RECEIVE;
-
-            // 1. 如果只有一个缓冲区，按原逻辑处理
-            if (rev->BufferCount == 1) {
-                const auto& buf = rev->Buffers[0];
-
-                if (buf.Length >= sizeof(int64_t)) {
-                    int64_t bodyLen = *reinterpret_cast<const int64_t*>(buf.Buffer);
-                    int64_t totalLen = sizeof(int64_t) + bodyLen;
-
-                    if (buf.Length >= totalLen) {
-                        // 零拷贝直接解析
-                        std::string_view jsonStr(
-                            reinterpret_cast<const char*>(buf.Buffer + sizeof(int64_t)),
-                            bodyLen
-                        );
-
-                        try {
-                            auto json = boost::json::parse(jsonStr).as_object();
-
-                            if (onDataReceivedHandle) {
-
-                                onDataReceivedHandle(json);
-
-                            }
-
-                        }
-                        catch (const std::exception& e) {
-                            LOG_ERROR("JSON parse error: %s", e.what());
-                        }
-
-                        // 处理剩余数据
-                        if (buf.Length > totalLen) {
-                            receivedBuffer.assign(
-                                buf.Buffer + totalLen,
-                                buf.Buffer + buf.Length
-                            );
-                            tryParse();
-                        }
-                        return;
-                    }
-                }
-            }
-            // 2. 多个缓冲区但数据头完整在第一个缓冲区
-            else if (rev->BufferCount > 1) {
-                const auto& firstBuf = rev->Buffers[0];
-
-                if (firstBuf.Length >= sizeof(int64_t)) {
-                    int64_t bodyLen = *reinterpret_cast<const int64_t*>(firstBuf.Buffer);
-                    int64_t totalLen = sizeof(int64_t) + bodyLen;
-
-                    // 计算所有缓冲区的总长度
-                    uint64_t totalBytes = 0;
-                    for (uint32_t i = 0; i < rev->BufferCount; ++i) {
-                        totalBytes += rev->Buffers[i].Length;
-                    }
-
-                    // 如果多个缓冲区中包含完整数据包
-                    if (totalBytes >= totalLen) {
-                        // 从多个缓冲区构建JSON字符串
-                        std::string jsonStr;
-                        jsonStr.reserve(bodyLen);
-
-                        // 第一个缓冲区：跳过头部
-                        uint64_t bytesFromFirst = std::min(
-                            static_cast<uint64_t>(firstBuf.Length - sizeof(int64_t)),
-                            static_cast<uint64_t>(bodyLen)
-                        );
-                        jsonStr.append(
-                            reinterpret_cast<const char*>(firstBuf.Buffer + sizeof(int64_t)),
-                            bytesFromFirst
-                        );
-
-                        // 后续缓冲区：添加剩余JSON数据
-                        uint64_t jsonBytesCollected = bytesFromFirst;
-                        for (uint32_t i = 1; i < rev->BufferCount && jsonBytesCollected < bodyLen; ++i) {
-                            const auto& buf = rev->Buffers[i];
-                            uint64_t toCopy = std::min(
-                                static_cast<uint64_t>(buf.Length),
-                                static_cast<uint64_t>(bodyLen - jsonBytesCollected)
-                            );
-                            jsonStr.append(
-                                reinterpret_cast<const char*>(buf.Buffer),
-                                toCopy
-                            );
-                            jsonBytesCollected += toCopy;
-                        }
-
-                        try {
-                            auto json = boost::json::parse(jsonStr).as_object();
-
-                            if (onDataReceivedHandle) {
-
-                                onDataReceivedHandle(json);
-
-                            }
-
-                            // 处理剩余数据
-                            uint64_t consumedBytes = totalLen;
-                            receivedBuffer.clear();
-
-                            // 跳过已消费的数据
-                            for (uint32_t i = 0; i < rev->BufferCount && consumedBytes > 0; ++i) {
-                                const auto& buf = rev->Buffers[i];
-                                if (consumedBytes >= buf.Length) {
-                                    consumedBytes -= buf.Length;
-                                }
-                                else {
-                                    // 当前缓冲区有剩余数据
-                                    uint64_t remaining = buf.Length - consumedBytes;
-                                    receivedBuffer.insert(
-                                        receivedBuffer.end(),
-                                        buf.Buffer + consumedBytes,
-                                        buf.Buffer + buf.Length
-                                    );
-                                    consumedBytes = 0;
-                                }
-                            }
-
-                            if (!receivedBuffer.empty()) {
-                                tryParse();
-                            }
-                            return;  // 零拷贝处理完毕
-                        }
-                        catch (const std::exception& e) {
-                            LOG_ERROR("JSON parse error: %s", e.what());
-                            // 解析失败，回退到缓冲区拷贝方式
-                        }
-                    }
-                }
-            }
-
-            // 3. 不能零拷贝解析，回退到原逻辑
-            for (uint32_t i = 0; i < rev->BufferCount; ++i) {
-                const auto& buf = rev->Buffers[i];
-                receivedBuffer.insert(receivedBuffer.end(), buf.Buffer, buf.Buffer + buf.Length);
-            }
-            tryParse();
-        }
-
-        void MsquicSocketClient::tryParse()
-        {
-            constexpr size_t headerSize = sizeof(int64_t);
-
-            while (true) {
-
-                // 1. 检查头部
-                if (receivedBuffer.size() < headerSize) return;
-
-                // 2. 预读长度（不删除数据）
-                int64_t len = *reinterpret_cast<const int64_t*>(receivedBuffer.data());
-
-                // 3. 检查完整包 (Header + Body)
-                // 注意：你的 writeJsonAsync 逻辑是 Header(8字节) + Body(len字节)
-                // 所以总长度应该是 headerSize + len
-                if (static_cast<int64_t>(receivedBuffer.size()) < headerSize + len) {
-                    return; // 数据不够，等待下次
-                }
-
-                // 4. 数据完整，开始提取
-                // 移除头部
-                receivedBuffer.erase(receivedBuffer.begin(), receivedBuffer.begin() + headerSize);
-
-                // 提取 Body
-                std::vector<uint8_t> payload(receivedBuffer.begin(), receivedBuffer.begin() + len);
-
-                // 移除 Body
-                receivedBuffer.erase(receivedBuffer.begin(), receivedBuffer.begin() + len);
-
-                /* 4. 业务回调（json 在 payload 里） */
-                boost::json::object json =
-                    boost::json::parse(std::string(payload.begin(), payload.end())).as_object();
-
-                if (onDataReceivedHandle) {
-
-                    onDataReceivedHandle(json);
-
-                }
-
-            }
-        }
-
-        void MsquicSocketClient::clear() {
-
-            if (!connected.load()) return;
-
-            onConnectionHandle = nullptr;
-
-            onDataReceivedHandle = nullptr;
-
-            // 先标记断开，防止新操作
-            connected.store(false);
-
-            receivedBuffer.clear();
-
-            if (registration) {
-                registration->Shutdown(QUIC_CONNECTION_SHUTDOWN_FLAG_NONE, 0);
-                //delete registration;
-                registration = nullptr;
-            }
-
-            // 清理流
-            if (stream) {
-                // 使用中止标志立即关闭
-                MsQuic->StreamShutdown(stream,
-                    QUIC_STREAM_SHUTDOWN_FLAG_ABORT_SEND |
-                    QUIC_STREAM_SHUTDOWN_FLAG_ABORT_RECEIVE,
-                    QUIC_STATUS_ABORTED);
-                MsQuic->StreamClose(stream);
-                stream = nullptr;
-            }
-
-            if (remoteStream) {
-                MsQuic->StreamShutdown(remoteStream,
-                    QUIC_STREAM_SHUTDOWN_FLAG_ABORT_SEND |
-                    QUIC_STREAM_SHUTDOWN_FLAG_ABORT_RECEIVE,
-                    QUIC_STATUS_ABORTED);
-                MsQuic->StreamClose(remoteStream);
-                remoteStream = nullptr;
-            }
-
-            // 清理连接（等待一小段时间让异步操作完成）
-            if (connection) {
-                // 先尝试优雅关闭
-                MsQuic->ConnectionShutdown(
-                    connection,
-                    QUIC_CONNECTION_SHUTDOWN_FLAG_SILENT,
-                    QUIC_STATUS_ABORTED
-                );
-
-                MsQuic->ConnectionClose(connection);
-
-                connection = nullptr;
-            }
-
-            // 清理配置和注册
-            if (configuration) {
-                delete configuration;
-                configuration = nullptr;
-            }
-
-        }
-
-        // 静态连接回调函数
-        QUIC_STATUS QUIC_API MsquicClientConnectionHandle(HQUIC connection, void* context, QUIC_CONNECTION_EVENT* event) {
-            auto* client = static_cast<MsquicSocketClient*>(context);
-            if (!client) {
-                return QUIC_STATUS_INVALID_PARAMETER;
-            }
-
-            switch (event->Type) {
-            case QUIC_CONNECTION_EVENT_CONNECTED:
-                if (client->onConnectionHandle) {
-                    client->onConnectionHandle(true);
-                }
-                break;
-
-            case QUIC_CONNECTION_EVENT_SHUTDOWN_COMPLETE:
-                LOG_INFO("QUIC_CONNECTION_EVENT_SHUTDOWN_COMPLETE");
-
-                client->connected.store(false);
-                if (client->onConnectionHandle) {
-                    client->onConnectionHandle(false);
-                }
-                break;
-            case QUIC_CONNECTION_EVENT_PEER_STREAM_STARTED:
-            {
-                client->remoteStream = event->PEER_STREAM_STARTED.Stream;
-
-                MsQuic->SetCallbackHandler(
-                    event->PEER_STREAM_STARTED.Stream,
-                    hope::quic::MsquicClientStreamHandle,   // 你的静态流回调
-                    client);
-
-                break;
-            }
-
-            default:
-                break;
-            }
-
-            return QUIC_STATUS_SUCCESS;
-        }
-
-        // 静态流回调函数
-        QUIC_STATUS QUIC_API MsquicClientStreamHandle(HQUIC stream, void* context, QUIC_STREAM_EVENT* event) {
-            auto* client = static_cast<MsquicSocketClient*>(context);
-            if (!client) {
-                return QUIC_STATUS_INVALID_PARAMETER;
-            }
-
-            switch (event->Type) {
-            case QUIC_STREAM_EVENT_RECEIVE:
-                client->handleReceive(event);
-                break;
-
-            case QUIC_STREAM_EVENT_SEND_COMPLETE:
-                if (event->SEND_COMPLETE.ClientContext) {
-                    QUIC_BUFFER* buffer = static_cast<QUIC_BUFFER*>(event->SEND_COMPLETE.ClientContext);
-                    delete[] buffer->Buffer;
-                    delete buffer;
-                }
-                break;
-
-            case QUIC_STREAM_EVENT_SHUTDOWN_COMPLETE:
-                break;
-
-            default:
-                break;
-            }
-
-            return QUIC_STATUS_SUCCESS;
-        }
-
-    } // namespace quic
-} // namespace hope
+#include "MsquicSocketClient.h"
+#include "MsQuicApi.h"
+#include "Utils.h"
+
+namespace hope {
+    namespace quic {
+
+        MsquicSocketClient::MsquicSocketClient(boost::asio::io_context& ioContext)
+            : ioContext(ioContext)
+            , connection(nullptr)
+            , stream(nullptr)
+            , registration(nullptr)
+            , configuration(nullptr)
+            , serverPort(0)
+            , connected(false) {
+        }
+
+        MsquicSocketClient::~MsquicSocketClient() {
+            clear();
+        }
+
+        bool MsquicSocketClient::initialize(const std::string& alpn) {
+
+            if (MsQuic == nullptr) {
+
+                return false;
+
+            }
+
+            this->alpn = alpn;
+
+            return true;
+        }
+
+        bool MsquicSocketClient::connect(std::string serverAddress, uint64_t serverPort) {
+            // 如果已有连接，先完全清理
+            if (connection != nullptr) {
+                LOG_INFO("reclear msquic connection");
+
+                disconnect();
+
+            }
+
+            if (!registration) {
+
+                registration = new MsQuicRegistration("MsquicSocketClient");
+
+                if (!registration->IsValid()) {
+
+                    return false;
+
+                }
+
+                // 创建注册
+                registration = new MsQuicRegistration("MsquicSocketClient");
+                if (!registration->IsValid()) {
+                    return false;
+                }
+
+                // 配置设置
+                MsQuicSettings settings;
+
+                settings.SetIdleTimeoutMs(10000);
+
+                settings.SetKeepAlive(5000);
+
+                // 服务端按流量类别各开一条流
+                settings.SetPeerBidiStreamCount(TRAFFIC_CLASS_COUNT);
+
+                // 接收服务端中转的实时事件
+                settings.SetDatagramReceiveEnabled(true);
+
+                // 服务端中转的批量传输，每次一条单向流
+                settings.SetPeerUnidiStreamCount(4);
+
+                // 创建ALPN
+                MsQuicAlpn alpnBuffer(alpn.c_str());
+
+                // 创建配置
+                QUIC_CREDENTIAL_CONFIG credConfig = { 0 };
+                credConfig.Type = QUIC_CREDENTIAL_TYPE_NONE;
+                credConfig.Flags = QUIC_CREDENTIAL_FLAG_CLIENT | QUIC_CREDENTIAL_FLAG_NO_CERTIFICATE_VALIDATION;
+
+                configuration = new MsQuicConfiguration(
+                    *registration,
+                    alpnBuffer,
+                    settings,
+                    MsQuicCredentialConfig(credConfig)
+                );
+
+                if (!configuration->IsValid()) {
+
+                    LOG_ERROR("MsQuicConfiguration Init Error");
+
+                    return false;
+                }
+
+            }
+
+            this->serverAddress = serverAddress;
+            this->serverPort = serverPort;
+
+            // 创建连接
+            QUIC_STATUS status = MsQuic->ConnectionOpen(
+                *registration,
+                MsquicClientConnectionHandle,
+                this,
+                &connection);
+
+            if (QUIC_FAILED(status)) {
+                LOG_ERROR("ConnectionOpen failed: 0x%08X", status);
+                return false;
+            }
+
+            // 启动连接
+            status = MsQuic->ConnectionStart(
+                connection,
+                *configuration,
+                QUIC_ADDRESS_FAMILY_INET,
+                serverAddress.c_str(),
+                serverPort);
+
+            if (QUIC_FAILED(status)) {
+                LOG_ERROR("ConnectionStart failed:0x%08X", status);
+                MsQuic->ConnectionClose(connection);
+                connection = nullptr;
+                return false;
+            }
+
+            // 创建流
+            stream = createStream();
+            if (stream == nullptr) {
+                LOG_ERROR("create MsquicStream failed");
+                MsQuic->ConnectionClose(connection);
+                connection = nullptr;
+                return false;
+            }
+
+            connected.store(true);
+            return true;
+        }
+
+        HQUIC MsquicSocketClient::createStream() {
+            HQUIC stream = nullptr;
+            QUIC_STATUS status = MsQuic->StreamOpen(
+                connection,
+                QUIC_STREAM_OPEN_FLAG_NONE,
+                MsquicClientStreamHandle,
+                this,
+                &stream);
+
+            if (QUIC_FAILED(status)) {
+                return nullptr;
+            }
+
+            status = MsQuic->StreamStart(
+                stream,
+                QUIC_STREAM_START_FLAG_IMMEDIATE);
+
+            if (QUIC_FAILED(status)) {
+                MsQuic->StreamClose(stream);
+                return nullptr;
+            }
+
+            return stream;
+        }
+
+        bool MsquicSocketClient::writeAsync(unsigned char* data, size_t size) {
+            if (!connected || stream == nullptr) {
+                return false;
+            }
+
+            QUIC_BUFFER* buffer = new QUIC_BUFFER;
+            buffer->Buffer = data;
+            buffer->Length = static_cast<uint32_t>(size);
+
+            QUIC_STATUS status = MsQuic->StreamSend(
+                stream,
+                buffer,
+                1,
+                QUIC_SEND_FLAG_NONE,
+                buffer);
+
+            if (QUIC_FAILED(status)) {
+                delete buffer;
+                return false;
+            }
+
+            return true;
+        }
+
+        bool MsquicSocketClient::writeJsonAsync(const boost::json::object& json) {
+            // 构建消息格式：length + body
+            std::string body = boost::json::serialize(json);
+            int64_t bodyLength = static_cast<int64_t>(body.size());
+            size_t totalSize = sizeof(int64_t) + bodyLength;
+
+            unsigned char* buffer = new unsigned char[totalSize];
+
+            // 写入length
+            *reinterpret_cast<int64_t*>(buffer) = bodyLength;
+
+            // 写入body
+            memcpy(buffer + sizeof(int64_t), body.data(), bodyLength);
+
+            return writeAsync(buffer, totalSize);
+        }
+
+
+        bool MsquicSocketClient::writeDatagram(std::string_view targetId, std::string_view payload) {
+
+            size_t size = DATAGRAM_HEADER_SIZE + targetId.size() + payload.size();
+
+            if (!connected || connection == nullptr || targetId.empty() || targetId.size() > UINT8_MAX
+                || !datagramSendEnabled.load() || size > maxDatagramSize.load()) {
+                return false;
+            }
+
+            // 描述符和数据放在同一块内存里，DATAGRAM_SEND_STATE_CHANGED 终态时一起释放
+            unsigned char* block = new unsigned char[sizeof(QUIC_BUFFER) + size];
+
+            QUIC_BUFFER* buffer = reinterpret_cast<QUIC_BUFFER*>(block);
+
+            buffer->Buffer = block + sizeof(QUIC_BUFFER);
+
+            buffer->Length = static_cast<uint32_t>(size);
+
+            size_t headerSize = encodeDatagramHeader(buffer->Buffer, targetId);
+
+            memcpy(buffer->Buffer + headerSize, payload.data(), payload.size());
+
+            QUIC_STATUS status = MsQuic->DatagramSend(connection, buffer, 1, QUIC_SEND_FLAG_NONE, block);
+
+            if (QUIC_FAILED(status)) {
+                delete[] block;
+                return false;
+            }
+
+            return true;
+        }
+
+        bool MsquicSocketClient::sendBulk(std::string_view targetId, std::span<const uint8_t> payload) {
+
+            if (!connected || connection == nullptr || targetId.empty() || targetId.size() > UINT8_MAX) {
+                return false;
+            }
+
+            // 流回调与信令流共用，SHUTDOWN_COMPLETE 时关闭未登记的流
+            HQUIC bulkStream = nullptr;
+
+            if (QUIC_FAILED(MsQuic->StreamOpen(connection, QUIC_STREAM_OPEN_FLAG_UNIDIRECTIONAL, MsquicClientStreamHandle, this, &bulkStream))) {
+                return false;
+            }
+
+            if (QUIC_FAILED(MsQuic->StreamStart(bulkStream, QUIC_STREAM_START_FLAG_IMMEDIATE))) {
+                MsQuic->StreamClose(bulkStream);
+                return false;
+            }
+
+            size_t size = DATAGRAM_HEADER_SIZE + targetId.size() + payload.size();
+
+            unsigned char* data = new unsigned char[size];
+
+            size_t headerSize = encodeDatagramHeader(data, targetId);
+
+            memcpy(data + headerSize, payload.data(), payload.size());
+
+            QUIC_BUFFER* buffer = new QUIC_BUFFER;
+            buffer->Buffer = data;
+            buffer->Length = static_cast<uint32_t>(size);
+
+            // 流头和负载一次发出并带 FIN，服务端收到 FIN 后结束中转
+            QUIC_STATUS status = MsQuic->StreamSend(bulkStream, buffer, 1, QUIC_SEND_FLAG_FIN, buffer);
+
+            if (QUIC_FAILED(status)) {
+                delete[] data;
+                delete buffer;
+                MsQuic->StreamShutdown(bulkStream, QUIC_STREAM_SHUTDOWN_FLAG_ABORT, 0);
+                return false;
+            }
+
+            return true;
+        }
+
+        void MsquicSocketClient::disconnect() {
+            // 防止重复调用
+            if (!connected.load() && connection == nullptr) {
+                return;
+            }
+
+            // 立即标记逻辑断开，阻止新的写入
+            connected.store(false);
+
+            if (registration) {
+
+                registration->Shutdown(QUIC_CONNECTION_SHUTDOWN_FLAG_NONE, 0);
+
+                registration = nullptr;
+
+            }
+
+            if (configuration) {
+
+                delete configuration;
+
+                configuration = nullptr;
+
+            }
+
+            if (stream) {
+                // 使用中止标志立即关闭
+                MsQuic->StreamShutdown(stream,
+                    QUIC_STREAM_SHUTDOWN_FLAG_ABORT_SEND |
+                    QUIC_STREAM_SHUTDOWN_FLAG_ABORT_RECEIVE,
+                    QUIC_STATUS_SUCCESS);
+
+                MsQuic->StreamClose(stream);
+
+                stream = nullptr;
+            }
+
+            closeRemoteStreams(QUIC_STATUS_SUCCESS);
+
+            if (connection) {
+
+                MsQuic->ConnectionShutdown(
+                    connection,
+                    QUIC_CONNECTION_SHUTDOWN_FLAG_SILENT,
+                    QUIC_STATUS_SUCCESS
+                );
+
+                MsQuic->ConnectionClose(connection);
+
+                connection = nullptr;
+            }
+
+        }
+
+        void MsquicSocketClient::setOnDataReceivedHandle(std::function<void(boost::json::object&)> handle) {
+            onDataReceivedHandle = std::move(handle);
+        }
+
+        void MsquicSocketClient::setOnDatagramReceivedHandle(std::function<void(std::string_view, std::string_view)> handle) {
+            onDatagramReceivedHandle = std::move(handle);
+        }
+
+        void MsquicSocketClient::setOnBulkReceivedHandle(std::function<void(std::string_view, std::span<const uint8_t>, bool)> handle) {
+            onBulkReceivedHandle = std::move(handle);
+        }
+
+        void MsquicSocketClient::setOnConnectionHandle(std::function<void(bool)> handle) {
+            onConnectionHandle = std::move(handle);
+        }
+
+        bool MsquicSocketClient::isConnected() const {
+            return connected.load();
+        }
+
+        MsquicFrameCodec* MsquicSocketClient::findFrameCodec(HQUIC stream)
+        {
+            for (RemoteStream& remote : remoteStreams) {
+                if (remote.stream == stream) {
+                    return &remote.frameCodec;
+                }
+            }
+
+            return nullptr;
+        }
+
+        void MsquicSocketClient::closeRemoteStreams(QUIC_UINT62 errorCode)
+        {
+            for (RemoteStream& remote : remoteStreams) {
+
+                remote.frameCodec.clear();
+
+                if (remote.stream) {
+
+                    MsQuic->StreamShutdown(remote.stream,
+                        QUIC_STREAM_SHUTDOWN_FLAG_ABORT_SEND |
+                        QUIC_STREAM_SHUTDOWN_FLAG_ABORT_RECEIVE,
+                        errorCode);
+
+                    MsQuic->StreamClose(remote.stream);
+
+                    remote.stream = nullptr;
+                }
+            }
+        }
+
+        void MsquicSocketClient::handleReceive(HQUIC stream, QUIC_STREAM_EVENT* event)
+        {
+            auto* rev = &event->RECEIVE;
+
+            // 自己发起的流上服务端不回写，只处理登记过的流
+            MsquicFrameCodec* frameCodec = findFrameCodec(stream);
+
+            if (!frameCodec) {
+                return;
+            }
+
+            for (uint32_t i = 0; i < rev->BufferCount; ++i) {
+
+                const auto& buf = rev->Buffers[i];
+
+                MsquicFrameCodec::Result result = frameCodec->feed(
+                    std::span<const uint8_t>(buf.Buffer, buf.Length),
+                    [this](std::span<const uint8_t> frame) {
+                        handleFrame(frame);
+                    });
+
+                if (result != MsquicFrameCodec::Result::Ok) {
+
+                    // 分帧器已丢弃缓存，后续数据无法重新同步
+                    LOG_ERROR("Invalid frame (%d) from server", static_cast<int>(result));
+
+                    return;
+                }
+            }
+        }
+
+        void MsquicSocketClient::handleFrame(std::span<const uint8_t> frame)
+        {
+            std::string_view jsonStr(
+                reinterpret_cast<const char*>(frame.data() + sizeof(int64_t)),
+                frame.size() - sizeof(int64_t)
+            );
+
+            boost::json::error_code ec;
+
+            boost::json::value value = boost::json::parse(jsonStr, ec);
+
+            if (ec || !value.is_object()) {
+                LOG_ERROR("JSON parse error: %s", ec ? ec.message().c_str() : "not an object");
+                return;
+            }
+
+            if (onDataReceivedHandle) {
+
+                onDataReceivedHandle(value.as_object());
+
+            }
+        }
+
+        void MsquicSocketClient::handleBulkReceive(BulkReceive& bulk, QUIC_STREAM_EVENT* event)
+        {
+            auto* rev = &event->RECEIVE;
+
+            for (uint32_t i = 0; i < rev->BufferCount; ++i) {
+
+                std::span<const uint8_t> chunk(rev->Buffers[i].Buffer, rev->Buffers[i].Length);
+
+                // 先攒流头，流头之后的字节原样交给回调
+                while (bulk.headerSize == 0 && !chunk.empty()) {
+
+                    bulk.header[bulk.headerLength++] = chunk.front();
+
+                    chunk = chunk.subspan(1);
+
+                    bulk.headerSize = bulkHeaderSize(bulk.header.data(), bulk.headerLength);
+                }
+
+                if (bulk.headerSize < 0) {
+                    return;
+                }
+
+                if (!chunk.empty() && onBulkReceivedHandle) {
+
+                    std::string_view sourceId(reinterpret_cast<const char*>(bulk.header.data() + DATAGRAM_HEADER_SIZE), bulk.header[1]);
+
+                    onBulkReceivedHandle(sourceId, chunk, false);
+                }
+            }
+        }
+
+        void MsquicSocketClient::clear() {
+
+            if (!connected.load()) return;
+
+            onConnectionHandle = nullptr;
+
+            onDataReceivedHandle = nullptr;
+
+            onDatagramReceivedHandle = nullptr;
+
+            onBulkReceivedHandle = nullptr;
+
+            // 先标记断开，防止新操作
+            connected.store(false);
+
+            if (registration) {
+                registration->Shutdown(QUIC_CONNECTION_SHUTDOWN_FLAG_NONE, 0);
+                //delete registration;
+                registration = nullptr;
+            }
+
+            // 清理流
+            if (stream) {
+                // 使用中止标志立即关闭
+                MsQuic->StreamShutdown(stream,
+                    QUIC_STREAM_SHUTDOWN_FLAG_ABORT_SEND |
+                    QUIC_STREAM_SHUTDOWN_FLAG_ABORT_RECEIVE,
+                    QUIC_STATUS_ABORTED);
+                MsQuic->StreamClose(stream);
+                stream = nullptr;
+            }
+
+            closeRemoteStreams(QUIC_STATUS_ABORTED);
+
+            // 清理连接（等待一小段时间让异步操作完成）
+            if (connection) {
+                // 先尝试优雅关闭
+                MsQuic->ConnectionShutdown(
+                    connection,
+                    QUIC_CONNECTION_SHUTDOWN_FLAG_SILENT,
+                    QUIC_STATUS_ABORTED
+                );
+
+                MsQuic->ConnectionClose(connection);
+
+                connection = nullptr;
+            }
+
+            // 清理配置和注册
+            if (configuration) {
+                delete configuration;
+                configuration = nullptr;
+            }
+
+        }
+
+        // 静态连接回调函数
+        QUIC_STATUS QUIC_API MsquicClientConnectionHandle(HQUIC connection, void* context, QUIC_CONNECTION_EVENT* event) {
+            auto* client = static_cast<MsquicSocketClient*>(context);
+            if (!client) {
+                return QUIC_STATUS_INVALID_PARAMETER;
+            }
+
+            switch (event->Type) {
+            case QUIC_CONNECTION_EVENT_CONNECTED:
+                if (client->onConnectionHandle) {
+                    client->onConnectionHandle(true);
+                }
+                break;
+
+            case QUIC_CONNECTION_EVENT_SHUTDOWN_COMPLETE:
+                LOG_INFO("QUIC_CONNECTION_EVENT_SHUTDOWN_COMPLETE");
+
+                client->connected.store(false);
+                if (client->onConnectionHandle) {
+                    client->onConnectionHandle(false);
+                }
+                break;
+            case QUIC_CONNECTION_EVENT_DATAGRAM_STATE_CHANGED:
+                client->maxDatagramSize.store(event->DATAGRAM_STATE_CHANGED.MaxSendLength);
+                client->datagramSendEnabled.store(event->DATAGRAM_STATE_CHANGED.SendEnabled);
+                break;
+
+            case QUIC_CONNECTION_EVENT_DATAGRAM_RECEIVED:
+            {
+                std::string_view sourceId;
+
+                std::string_view payload;
+
+                const QUIC_BUFFER* buffer = event->DATAGRAM_RECEIVED.Buffer;
+
+                if (client->onDatagramReceivedHandle && parseDatagram(buffer->Buffer, buffer->Length, sourceId, payload)) {
+                    client->onDatagramReceivedHandle(sourceId, payload);
+                }
+
+                break;
+            }
+
+            case QUIC_CONNECTION_EVENT_DATAGRAM_SEND_STATE_CHANGED:
+                if (event->DATAGRAM_SEND_STATE_CHANGED.ClientContext && QUIC_DATAGRAM_SEND_STATE_IS_FINAL(event->DATAGRAM_SEND_STATE_CHANGED.State)) {
+                    delete[] static_cast<unsigned char*>(event->DATAGRAM_SEND_STATE_CHANGED.ClientContext);
+                }
+                break;
+
+            case QUIC_CONNECTION_EVENT_PEER_STREAM_STARTED:
+            {
+                HQUIC remoteStream = event->PEER_STREAM_STARTED.Stream;
+
+                // 单向流是服务端中转的批量传输，各自带状态，流结束时释放
+                if (event->PEER_STREAM_STARTED.Flags & QUIC_STREAM_OPEN_FLAG_UNIDIRECTIONAL) {
+
+                    auto* bulk = new MsquicSocketClient::BulkReceive;
+
+                    bulk->client = client;
+
+                    MsQuic->SetCallbackHandler(remoteStream, hope::quic::MsquicClientBulkStreamHandle, bulk);
+
+                    break;
+                }
+
+                auto slot = std::find_if(client->remoteStreams.begin(), client->remoteStreams.end(),
+                    [](const MsquicSocketClient::RemoteStream& remote) { return remote.stream == nullptr; });
+
+                // 超出类别数的流不接收
+                if (slot == client->remoteStreams.end()) {
+                    MsQuic->StreamClose(remoteStream);
+                    break;
+                }
+
+                slot->stream = remoteStream;
+
+                MsQuic->SetCallbackHandler(
+                    event->PEER_STREAM_STARTED.Stream,
+                    hope::quic::MsquicClientStreamHandle,   // 你的静态流回调
+                    client);
+
+                break;
+            }
+
+            default:
+                break;
+            }
+
+            return QUIC_STATUS_SUCCESS;
+        }
+
+        // 静态流回调函数
+        QUIC_STATUS QUIC_API MsquicClientStreamHandle(HQUIC stream, void* context, QUIC_STREAM_EVENT* event) {
+            auto* client = static_cast<MsquicSocketClient*>(context);
+            if (!client) {
+                return QUIC_STATUS_INVALID_PARAMETER;
+            }
+
+            switch (event->Type) {
+            case QUIC_STREAM_EVENT_RECEIVE:
+                client->handleReceive(stream, event);
+                break;
+
+            case QUIC_STREAM_EVENT_SEND_COMPLETE:
+                if (event->SEND_COMPLETE.ClientContext) {
+                    QUIC_BUFFER* buffer = static_cast<QUIC_BUFFER*>(event->SEND_COMPLETE.ClientContext);
+                    delete[] buffer->Buffer;
+                    delete buffer;
+                }
+                break;
+
+            case QUIC_STREAM_EVENT_SHUTDOWN_COMPLETE:
+                // 信令流和服务端的流在断开时关闭，这里只关闭发完的批量传输流
+                if (stream != client->stream && !client->findFrameCodec(stream)) {
+                    MsQuic->StreamClose(stream);
+                }
+                break;
+
+            default:
+                break;
+            }
+
+            return QUIC_STATUS_SUCCESS;
+        }
+
+        // 批量传输接收流回调函数
+        QUIC_STATUS QUIC_API MsquicClientBulkStreamHandle(HQUIC stream, void* context, QUIC_STREAM_EVENT* event) {
+            auto* bulk = static_cast<MsquicSocketClient::BulkReceive*>(context);
+            if (!bulk) {
+                return QUIC_STATUS_INVALID_PARAMETER;
+            }
+
+            MsquicSocketClient* client = bulk->client;
+
+            switch (event->Type) {
+            case QUIC_STREAM_EVENT_RECEIVE:
+                client->handleBulkReceive(*bulk, event);
+
+                if (bulk->headerSize < 0) {
+                    LOG_ERROR("Invalid bulk transfer header from server");
+                    MsQuic->StreamShutdown(stream, QUIC_STREAM_SHUTDOWN_FLAG_ABORT_RECEIVE, BULK_ERROR_INVALID_HEADER);
+                }
+                break;
+
+            case QUIC_STREAM_EVENT_PEER_SEND_SHUTDOWN:
+                if (bulk->headerSize > 0 && client->onBulkReceivedHandle) {
+
+                    std::string_view sourceId(reinterpret_cast<const char*>(bulk->header.data() + DATAGRAM_HEADER_SIZE), bulk->header[1]);
+
+                    client->onBulkReceivedHandle(sourceId, {}, true);
+                }
+                break;
+
+            case QUIC_STREAM_EVENT_PEER_SEND_ABORTED:
+                LOG_WARNING("Bulk transfer aborted by server: %llu", static_cast<unsigned long long>(event->PEER_SEND_ABORTED.ErrorCode));
+                break;
+
+            case QUIC_STREAM_EVENT_SHUTDOWN_COMPLETE:
+                delete bulk;
+                MsQuic->StreamClose(stream);
+                break;
+
+            default:
+                break;
+            }
+
+            return QUIC_STATUS_SUCCESS;
+        }
+
+    } // namespace quic
+} // namespace hope
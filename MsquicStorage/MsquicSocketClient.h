@@ -1,101 +1,152 @@
-#pragma once
-
-#include <msquic.hpp>
-#include <string>
-#include <functional>
-#include <vector>
-#include <memory>
-#include <boost/asio.hpp>
-#include <boost/json.hpp>
-
-namespace hope {
-    namespace quic {
-
-        class MsquicSocketClient : public std::enable_shared_from_this<MsquicSocketClient> {
-
-            friend QUIC_STATUS QUIC_API MsquicClientConnectionHandle(HQUIC connection, void* context, QUIC_CONNECTION_EVENT* event);
-            friend QUIC_STATUS QUIC_API MsquicClientStreamHandle(HQUIC stream, void* context, QUIC_STREAM_EVENT* event);
-
-        public:
-            // 构造函数
-            MsquicSocketClient(boost::asio::io_context& ioContext);
-
-            // 析构函数
-            ~MsquicSocketClient();
-
-            // 初始化客户端
-            bool initialize( const std::string& alpn = "quic");
-
-            // 连接到服务器
-            bool connect(std::string serverAddress,uint64_t serverPort);
-
-            // 发送数据
-            bool writeAsync(unsigned char* data, size_t size);
-
-            // 发送JSON数据
-            bool writeJsonAsync(const boost::json::object& json);
-
-            // 断开连接
-            void disconnect();
-
-            // 设置消息处理函数
-            void setOnDataReceivedHandle(std::function<void(boost::json::object&)> handle);
-
-            // 设置连接状态处理函数
-            void setOnConnectionHandle(std::function<void(bool)> handle);
-
-            // 是否已连接
-            bool isConnected() const;
-
-        private:
-            // 创建流
-            HQUIC createStream();
-
-            // 处理接收数据
-            void handleReceive(QUIC_STREAM_EVENT* event);
-
-            // 尝试解析消息
-            void tryParse();
-
-            // 清理资源
-            void clear();
-
-        private:
-
-            boost::asio::io_context& ioContext;
-
-            HQUIC connection;
-
-            HQUIC stream;
-
-            HQUIC remoteStream;
-
-            MsQuicRegistration* registration;
-
-            MsQuicConfiguration* configuration;
-
-            std::string serverAddress;
-
-            uint16_t serverPort;
-
-            std::string alpn;
-
-            std::vector<uint8_t> receivedBuffer;
-
-            int64_t payloadLen;
-
-            std::string accountId;
-
-            std::atomic<bool> connected;
-
-            std::function<void(boost::json::object&)> onDataReceivedHandle;
-
-            std::function<void(bool)> onConnectionHandle;
-        };
-
-        // 声明静态回调函数
-        QUIC_STATUS QUIC_API MsquicClientConnectionHandle(HQUIC connection, void* context, QUIC_CONNECTION_EVENT* event);
-        QUIC_STATUS QUIC_API MsquicClientStreamHandle(HQUIC stream, void* context, QUIC_STREAM_EVENT* event);
-
-    } // namespace quic
-} // namespace hope
+#pragma once
+
+#include <msquic.hpp>
+#include <string>
+#include <functional>
+#include <vector>
+#include <memory>
+#include <array>
+#include <span>
+#include <boost/asio.hpp>
+#include <boost/json.hpp>
+
+#include "MsquicFrameCodec.h"
+
+namespace hope {
+    namespace quic {
+
+        class MsquicSocketClient : public std::enable_shared_from_this<MsquicSocketClient> {
+
+            friend QUIC_STATUS QUIC_API MsquicClientConnectionHandle(HQUIC connection, void* context, QUIC_CONNECTION_EVENT* event);
+            friend QUIC_STATUS QUIC_API MsquicClientStreamHandle(HQUIC stream, void* context, QUIC_STREAM_EVENT* event);
+            friend QUIC_STATUS QUIC_API MsquicClientBulkStreamHandle(HQUIC stream, void* context, QUIC_STREAM_EVENT* event);
+
+        public:
+            // 构造函数
+            MsquicSocketClient(boost::asio::io_context& ioContext);
+
+            // 析构函数
+            ~MsquicSocketClient();
+
+            // 初始化客户端
+            bool initialize( const std::string& alpn = "quic");
+
+            // 连接到服务器
+            bool connect(std::string serverAddress,uint64_t serverPort);
+
+            // 发送数据
+            bool writeAsync(unsigned char* data, size_t size);
+
+            // 发送JSON数据
+            bool writeJsonAsync(const boost::json::object& json);
+
+            // 不可靠发送一个实时事件给 targetId，服务端没开启 DATAGRAM 或超长时返回 false
+            bool writeDatagram(std::string_view targetId, std::string_view payload);
+
+            // 单独开一条单向流把大负载发给 targetId，发完即关闭，不占用信令流
+            bool sendBulk(std::string_view targetId, std::span<const uint8_t> payload);
+
+            // 断开连接
+            void disconnect();
+
+            // 设置消息处理函数
+            void setOnDataReceivedHandle(std::function<void(boost::json::object&)> handle);
+
+            // 设置 DATAGRAM 处理函数，参数为源 ID 和负载，只在回调期间有效
+            void setOnDatagramReceivedHandle(std::function<void(std::string_view, std::string_view)> handle);
+
+            // 设置批量传输处理函数，参数为源 ID、本次收到的数据块和是否已收完，数据块只在回调期间有效
+            void setOnBulkReceivedHandle(std::function<void(std::string_view, std::span<const uint8_t>, bool)> handle);
+
+            // 设置连接状态处理函数
+            void setOnConnectionHandle(std::function<void(bool)> handle);
+
+            // 是否已连接
+            bool isConnected() const;
+
+        private:
+            // 创建流
+            HQUIC createStream();
+
+            // 处理接收数据
+            void handleReceive(HQUIC stream, QUIC_STREAM_EVENT* event);
+
+            // 服务端按流量类别开的流各自分帧，未登记的流返回 nullptr
+            MsquicFrameCodec* findFrameCodec(HQUIC stream);
+
+            void closeRemoteStreams(QUIC_UINT62 errorCode);
+
+            // 处理一个完整帧
+            void handleFrame(std::span<const uint8_t> frame);
+
+            // 服务端中转来的批量传输，每条单向流一份，作为流回调的 context
+            struct BulkReceive {
+
+                MsquicSocketClient* client = nullptr;
+
+                std::array<unsigned char, DATAGRAM_HEADER_SIZE + UINT8_MAX> header{};
+
+                size_t headerLength = 0;
+
+                int64_t headerSize = 0;
+
+            };
+
+            void handleBulkReceive(BulkReceive& bulk, QUIC_STREAM_EVENT* event);
+
+            // 清理资源
+            void clear();
+
+        private:
+
+            boost::asio::io_context& ioContext;
+
+            HQUIC connection;
+
+            HQUIC stream;
+
+            // 服务端发起的流，每个流量类别一条
+            struct RemoteStream {
+
+                HQUIC stream = nullptr;
+
+                MsquicFrameCodec frameCodec;
+
+            };
+
+            std::array<RemoteStream, TRAFFIC_CLASS_COUNT> remoteStreams;
+
+            MsQuicRegistration* registration;
+
+            MsQuicConfiguration* configuration;
+
+            std::string serverAddress;
+
+            uint16_t serverPort;
+
+            std::string alpn;
+
+            std::string accountId;
+
+            std::atomic<bool> connected;
+
+            std::function<void(boost::json::object&)> onDataReceivedHandle;
+
+            std::function<void(bool)> onConnectionHandle;
+
+            std::function<void(std::string_view, std::string_view)> onDatagramReceivedHandle;
+
+            std::function<void(std::string_view, std::span<const uint8_t>, bool)> onBulkReceivedHandle;
+
+            std::atomic<bool> datagramSendEnabled{ false };
+
+            std::atomic<uint16_t> maxDatagramSize{ 0 };
+        };
+
+        // 声明静态回调函数
+        QUIC_STATUS QUIC_API MsquicClientConnectionHandle(HQUIC connection, void* context, QUIC_CONNECTION_EVENT* event);
+        QUIC_STATUS QUIC_API MsquicClientStreamHandle(HQUIC stream, void* context, QUIC_STREAM_EVENT* event);
+        QUIC_STATUS QUIC_API MsquicClientBulkStreamHandle(HQUIC stream, void* context, QUIC_STREAM_EVENT* event);
+
+    } // namespace quic
+} // namespace hope
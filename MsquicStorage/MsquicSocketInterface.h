@@ -1,36 +1,76 @@
-#pragma once
-
-namespace hope {
-
-	namespace quic {
-
-		enum class SocketType {
-
-			MsquicSocket = 0,
-
-			WebSocket = 1,
-
-		};
-	
-		class MsquicSocketInterface
-		{
-		public:
-
-			MsquicSocketInterface() = default;
-
-			virtual ~MsquicSocketInterface() = default;
-
-			virtual void runEventLoop() = 0;
-
-			virtual void writeAsync(unsigned char* data, size_t size) = 0;
-
-			virtual void clear() = 0;
-
-			virtual SocketType getType() = 0;
-
-		};
-
-
-	}
-
-}
+#pragma once
+
+#include "MsquicProtocol.h"
+#include "MsquicSharedBuffer.h"
+#include "MsquicMemoryBudget.h"
+
+namespace hope {
+
+	namespace quic {
+
+		enum class SocketType {
+
+			MsquicSocket = 0,
+
+			WebSocket = 1,
+
+		};
+	
+		class MsquicSocketInterface
+		{
+		public:
+
+			MsquicSocketInterface() = default;
+
+			virtual ~MsquicSocketInterface() = default;
+
+			virtual void runEventLoop() = 0;
+
+			virtual void writeAsync(unsigned char* data, size_t size) = 0;
+
+			// 发送队列满且策略为拒收时返回 false，data 已释放，调用方据此回复忙
+			virtual bool tryWriteAsync(unsigned char* data, size_t size) { writeAsync(data, size); return true; }
+
+			// 按流量类别选择发送通道，只有一条通道的传输忽略类别
+			virtual void writeAsync(unsigned char* data, size_t size, TrafficClass trafficClass) { writeAsync(data, size); }
+
+			virtual bool tryWriteAsync(unsigned char* data, size_t size, TrafficClass trafficClass) { return tryWriteAsync(data, size); }
+
+			virtual void clear() = 0;
+
+			virtual SocketType getType() = 0;
+
+			virtual WireProtocol getProtocol() = 0;
+
+			// 帧编码由各传输自己提供：先预留 frameHeaderSize 字节，正文直接写进缓冲区后再回填帧头
+			virtual size_t frameHeaderSize() = 0;
+
+			virtual void encodeFrameHeader(unsigned char* header, size_t bodyLength, int64_t requestType, int64_t state) = 0;
+
+			// 不可靠发送一个 DATAGRAM，data 的引用总被接管；不支持或超过路径允许的长度时返回 false，调用方改走流
+			virtual bool writeDatagram(unsigned char* data, size_t size) { hope::utils::MsquicSharedBuffer::release(data); return false; }
+
+			// 发送缓冲区带引用计数，writeAsync 接管的是其中一份引用，用 MsquicSharedBuffer::release 归还
+			virtual unsigned char* allocateBuffer(size_t size) { return hope::utils::MsquicSharedBuffer::allocateRaw(size); }
+
+			// 共享的不可变消息：多个帧格式相同的连接共用一次序列化，各自持有一份引用直到发送完成
+			void writeShared(hope::utils::MsquicSharedBuffer buffer) {
+
+				size_t size = buffer.size();
+
+				writeAsync(buffer.detach(), size);
+			}
+
+			// 本会话的内存预算：接收缓冲、发送队列和投递到逻辑线程还没处理完的任务
+			hope::utils::MsquicMemoryBudget& getMemoryBudget() { return memoryBudget; }
+
+		protected:
+
+			hope::utils::MsquicMemoryBudget memoryBudget;
+
+		};
+
+
+	}
+
+}
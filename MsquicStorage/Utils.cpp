@@ -1,332 +1,1102 @@
-#ifdef _WIN32
-#define _CRT_SECURE_NO_WARNINGS
-#endif
-
-#include "Utils.h"
-#include <chrono>
-
-#ifdef _WIN32
-#ifndef WIN32_LEAN_AND_MEAN
-#define WIN32_LEAN_AND_MEAN
-#endif
-#include <windows.h>
-#endif
-
-#ifdef _WIN32
-#include <direct.h>
-#else
-#include <sys/stat.h>
-#include <unistd.h>
-#endif
-
-// 颜色定义
-static const char* COLOR_RESET = "\033[0m";
-static const char* COLOR_RED = "\033[91m";
-static const char* COLOR_GREEN = "\033[92m";
-static const char* COLOR_YELLOW = "\033[93m";
-static const char* COLOR_BLUE = "\033[94m";
-
-// 全局变量
-static const char* logFileNames[4] = {
-    "debug.log",
-    "info.log",
-    "warning.log",
-    "error.log"
-};
-static std::string logDir = "logs";
-static int logToFileEnabled = 1;
-static std::mutex logMutex;
-static int loggerInitialized = 0;
-
-// 哪些级别需要输出到控制台（1=输出到控制台，0=只输出到文件）
-static int consoleOutputLevels[4] = { 1, 1, 1, 1 }; // DEBUG, INFO, WARNING, ERROR 默认都输出到控制台
-
-// 初始化日志系统
-void initLogger() {
-    std::lock_guard<std::mutex> lock(logMutex);
-
-    if (loggerInitialized) {
-        return;
-    }
-
-    // 创建日志目录
-#ifdef _WIN32
-    _mkdir(logDir.c_str());
-#else
-    mkdir(logDir.c_str(), 0755);
-#endif
-
-    loggerInitialized = 1;
-}
-
-void closeLogger() {
-    std::lock_guard<std::mutex> lock(logMutex);
-    // 现在没有需要关闭的全局文件句柄
-    loggerInitialized = 0;
-}
-
-void enableFileLogging(int enable) {
-    std::lock_guard<std::mutex> lock(logMutex);
-    logToFileEnabled = enable;
-}
-
-void setLogDirectory(const char* dir) {
-    std::lock_guard<std::mutex> lock(logMutex);
-    logDir = dir;
-}
-
-// 设置哪些级别只输出到文件（不在控制台显示）
-void setConsoleOutputLevels(int debug, int info, int warning, int error) {
-    std::lock_guard<std::mutex> lock(logMutex);
-    consoleOutputLevels[LOG_LEVEL_DEBUG] = debug;
-    consoleOutputLevels[LOG_LEVEL_INFO] = info;
-    consoleOutputLevels[LOG_LEVEL_WARNING] = warning;
-    consoleOutputLevels[LOG_LEVEL_ERROR] = error;
-}
-
-void getTimestamp(char* buffer, size_t size) {
-    time_t rawtime;
-    struct tm timeinfo;
-
-    time(&rawtime);
-
-#ifdef _WIN32
-    if (localtime_s(&timeinfo, &rawtime) != 0) {
-        strncpy_s(buffer, size, "0000-00-00 00:00:00", _TRUNCATE);
-        return;
-    }
-#else
-    if (localtime_r(&rawtime, &timeinfo) == nullptr) {
-        strncpy(buffer, "0000-00-00 00:00:00", size - 1);
-        buffer[size - 1] = '\0';
-        return;
-    }
-#endif
-
-    strftime(buffer, size, "%Y-%m-%d %H:%M:%S", &timeinfo);
-}
-
-void getLevelInfo(LogLevel level, const char** levelStr, const char** color) {
-    switch (level) {
-    case LOG_LEVEL_INFO:
-        *levelStr = "INFO";
-        *color = COLOR_GREEN;
-        break;
-    case LOG_LEVEL_WARNING:
-        *levelStr = "WARNING";
-        *color = COLOR_YELLOW;
-        break;
-    case LOG_LEVEL_ERROR:
-        *levelStr = "ERROR";
-        *color = COLOR_RED;
-        break;
-    case LOG_LEVEL_DEBUG:
-        *levelStr = "DEBUG";
-        *color = COLOR_BLUE;
-        break;
-    default:
-        *levelStr = "UNKNOWN";
-        *color = COLOR_RESET;
-        break;
-    }
-}
-
-// 辅助函数：打开文件并写入日志
-static void writeLogToFile(LogLevel level, const char* timestamp,
-    const char* levelStr, const char* format, va_list args) {
-    if (!logToFileEnabled || level < 0 || level > 3) {
-        return;
-    }
-
-    std::string filePath = logDir + "/" + logFileNames[level];
-
-    // 确保目录存在
-    if (!loggerInitialized) {
-#ifdef _WIN32
-        // 使用 CreateDirectoryA 创建目录
-        if (!CreateDirectoryA(logDir.c_str(), NULL)) {
-            DWORD err = GetLastError();
-            if (err != ERROR_ALREADY_EXISTS) {
-                // 目录创建失败，但不是因为已经存在
-                printf("ERROR: Failed to create log directory: %s, error: %lu\n",
-                    logDir.c_str(), err);
-                fflush(stdout);
-            }
-        }
-#else
-        mkdir(logDir.c_str(), 0755);
-#endif
-        loggerInitialized = 1;
-    }
-
-    FILE* logFile = nullptr;
-
-#ifdef _WIN32
-    // 直接使用 fopen_s，不要用宽字符转换
-    errno_t err = fopen_s(&logFile, filePath.c_str(), "a");
-    if (err != 0) {
-        printf("ERROR: Failed to open log file: %s, error: %d\n",
-            filePath.c_str(), err);
-        fflush(stdout);
-        return;
-    }
-#else
-    logFile = fopen(filePath.c_str(), "a");
-    if (!logFile) {
-        printf("ERROR: Failed to open log file: %s\n", filePath.c_str());
-        fflush(stdout);
-        return;
-    }
-#endif
-
-    if (logFile) {
-        // 不使用缓冲，立即写入
-        setvbuf(logFile, nullptr, _IONBF, 0);
-
-        // 先写入时间戳和等级
-        int written1 = fprintf(logFile, "[%s][%s] ", timestamp, levelStr);
-        if (written1 < 0) {
-            printf("ERROR: fprintf failed for timestamp, written: %d\n", written1);
-            fflush(stdout);
-        }
-
-        // 写入消息
-        int written2 = vfprintf(logFile, format, args);
-        if (written2 < 0) {
-            printf("ERROR: vfprintf failed for message, written: %d\n", written2);
-            fflush(stdout);
-        }
-
-        // 写入换行
-        int written3 = fprintf(logFile, "\n");
-        if (written3 < 0) {
-            printf("ERROR: fprintf failed for newline, written: %d\n", written3);
-            fflush(stdout);
-        }
-
-        fclose(logFile);  // 立即关闭文件
-
-        // 调试信息
-        // printf("DEBUG: Successfully wrote log to %s\n", filePath.c_str());
-        // fflush(stdout);
-    }
-}
-
-// 带颜色的日志输出 - 线程安全版本
-void logMessage(LogLevel level, const char* format, ...) {
-    char timestamp[32];
-    const char* levelStr;
-    const char* color;
-    va_list args, argsCopy;
-
-    // 获取时间戳
-    getTimestamp(timestamp, sizeof(timestamp));
-
-    // 获取等级信息
-    getLevelInfo(level, &levelStr, &color);
-
-    // 复制参数列表
-    va_start(args, format);
-    va_copy(argsCopy, args);
-
-    // 构建消息
-    char messageBuffer[4096];
-    int len = vsnprintf(messageBuffer, sizeof(messageBuffer), format, args);
-    if (len < 0 || len >= (int)sizeof(messageBuffer)) {
-#ifdef _WIN32
-        strcpy_s(messageBuffer, sizeof(messageBuffer), "[Message too long or formatting error]");
-#else
-        strncpy(messageBuffer, "[Message too long or formatting error]", sizeof(messageBuffer) - 1);
-        messageBuffer[sizeof(messageBuffer) - 1] = '\0';
-#endif
-    }
-
-    // 使用互斥锁确保整个输出过程是原子的
-    std::lock_guard<std::mutex> lock(logMutex);
-
-    // 输出到控制台（如果该级别允许）
-    if (consoleOutputLevels[level]) {
-        printf("%s[%s][%s] %s%s\n", color, levelStr, timestamp, messageBuffer, COLOR_RESET);
-        fflush(stdout);
-    }
-
-    // 输出到文件
-    writeLogToFile(level, timestamp, levelStr, format, argsCopy);
-
-    va_end(args);
-    va_end(argsCopy);
-}
-
-// 不带颜色的日志输出 - 线程安全版本
-void logMessagePlain(LogLevel level, const char* format, ...) {
-    char timestamp[32];
-    const char* levelStr;
-    const char* color;
-    va_list args, argsCopy;
-
-    // 获取时间戳
-    getTimestamp(timestamp, sizeof(timestamp));
-
-    // 获取等级信息
-    getLevelInfo(level, &levelStr, &color);
-
-    // 复制参数列表
-    va_start(args, format);
-    va_copy(argsCopy, args);
-
-    // 构建消息
-    char messageBuffer[4096];
-    int len = vsnprintf(messageBuffer, sizeof(messageBuffer), format, args);
-    if (len < 0 || len >= (int)sizeof(messageBuffer)) {
-#ifdef _WIN32
-        strcpy_s(messageBuffer, sizeof(messageBuffer), "[Message too long or formatting error]");
-#else
-        strncpy(messageBuffer, "[Message too long or formatting error]", sizeof(messageBuffer) - 1);
-        messageBuffer[sizeof(messageBuffer) - 1] = '\0';
-#endif
-    }
-
-    // 使用互斥锁确保整个输出过程是原子的
-    std::lock_guard<std::mutex> lock(logMutex);
-
-    // 输出到控制台（如果该级别允许）
-    if (consoleOutputLevels[level]) {
-        printf("[%s][%s] %s\n", levelStr, timestamp, messageBuffer);
-        fflush(stdout);
-    }
-
-    // 输出到文件
-    writeLogToFile(level, timestamp, levelStr, format, argsCopy);
-
-    va_end(args);
-    va_end(argsCopy);
-}
-
-// 只输出到文件
-void logToFileOnly(LogLevel level, const char* format, ...) {
-    if (!logToFileEnabled) {
-        return;
-    }
-
-    char timestamp[32];
-    const char* levelStr;
-    const char* color;
-    va_list args;
-
-    // 获取时间戳
-    getTimestamp(timestamp, sizeof(timestamp));
-
-    // 获取等级信息
-    getLevelInfo(level, &levelStr, &color);
-
-    // 获取参数列表
-    va_start(args, format);
-
-    // 使用互斥锁
-    std::lock_guard<std::mutex> lock(logMutex);
-
-    // 只输出到文件
-    writeLogToFile(level, timestamp, levelStr, format, args);
-
-    va_end(args);
-}
\ No newline at end of file
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "Utils.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <unistd.h>
+#endif
+
+// 颜色定义
+static const char* COLOR_RESET = "\033[0m";
+static const char* COLOR_RED = "\033[91m";
+static const char* COLOR_GREEN = "\033[92m";
+static const char* COLOR_YELLOW = "\033[93m";
+static const char* COLOR_BLUE = "\033[94m";
+
+// 全局变量
+static const char* logFileNames[4] = {
+    "debug",
+    "info",
+    "warning",
+    "error"
+};
+static std::string logDir = "logs";
+static std::atomic<int> logToFileEnabled{ 1 };
+static std::mutex logMutex;
+static int loggerInitialized = 0;
+
+// 哪些级别需要输出到控制台（1=输出到控制台，0=只输出到文件）
+static std::atomic<int> consoleOutputLevels[4] = { 1, 1, 1, 1 }; // DEBUG, INFO, WARNING, ERROR 默认都输出到控制台
+
+// 异步日志：每个线程一个单生产者环形缓冲区，后台线程批量取出后写控制台和常开的日志文件
+// 生产者只做一次格式化和一次拷贝，缓冲区满时丢弃并计数，从不等待
+namespace {
+
+    // 记录标志
+    constexpr uint8_t LOG_RECORD_PADDING = 0x01;   // 环尾放不下整条记录时的填充
+
+    constexpr uint8_t LOG_RECORD_PLAIN = 0x02;     // 控制台不带颜色
+
+    constexpr uint8_t LOG_RECORD_FILE_ONLY = 0x04; // 不输出到控制台
+
+    constexpr uint8_t LOG_RECORD_DEFERRED = 0x08;  // 负载为格式 ID + 二进制参数，写入线程格式化
+
+    // 记录按 16 字节对齐，环尾剩余空间总能放下一个填充头
+    struct alignas(16) LogRecordHeader {
+
+        uint32_t size;
+
+        uint8_t level;
+
+        uint8_t flags;
+
+        uint16_t textLength;
+
+        int64_t time;   // steady_clock 纳秒，写入线程换算成本地时间
+
+    };
+
+    static_assert(sizeof(LogRecordHeader) == 16, "log record header must stay 16 bytes");
+
+    constexpr size_t LOG_MESSAGE_MAX = 4096;
+
+    struct LogRing {
+
+        explicit LogRing(size_t capacity) : buffer(capacity) {}
+
+        std::vector<char> buffer;
+
+        // 单调递增的读写位置，下标取低位
+        alignas(64) std::atomic<size_t> head{ 0 };
+
+        alignas(64) std::atomic<size_t> tail{ 0 };
+
+        std::atomic<uint64_t> dropped{ 0 };
+
+        // 线程退出后由写入线程取完剩余记录再移除
+        std::atomic<bool> abandoned{ false };
+
+    };
+
+    // 线程退出时标记自己的缓冲区，剩余记录照常写出
+    struct LogRingHolder {
+
+        std::shared_ptr<LogRing> ring;
+
+        ~LogRingHolder() {
+            if (ring) {
+                ring->abandoned.store(true, std::memory_order_release);
+            }
+        }
+
+    };
+
+    struct LogFile {
+
+        FILE* file = nullptr;
+
+        size_t size = 0;
+
+        time_t opened = 0;
+
+    };
+
+    std::mutex registryMutex;
+
+    std::vector<std::shared_ptr<LogRing>> registry;
+
+    std::atomic<uint64_t> registryVersion{ 0 };
+
+    // 每线程缓冲区大小，只影响之后才开始打日志的线程
+    std::atomic<size_t> ringCapacity{ 256 * 1024 };
+
+    std::atomic<size_t> rotateFileSize{ 100 * 1024 * 1024 };
+
+    std::atomic<int> rotateSeconds{ 24 * 3600 };
+
+    std::atomic<bool> writerRunning{ false };
+
+    std::thread writerThread;
+
+    std::mutex writerMutex;
+
+    std::condition_variable writerWakeup;
+
+    // 以下只在写入线程（或写入线程未运行时持有 logMutex 的线程）上访问
+    LogFile logFiles[4];
+
+    std::string consoleBatch;
+
+    time_t cachedSecond = -1;
+
+    char cachedTimestamp[32] = { 0 };
+
+    // 延迟格式化的格式串，登记时拆成字面量和转换说明
+    struct LogFormatSegment {
+
+        std::string literal;      // 转换说明之前的原文
+
+        std::string spec;         // 去掉长度修饰符后按参数类型重建的转换说明，为空表示只有字面量
+
+        char conversion = 0;
+
+    };
+
+    struct LogFormat {
+
+        std::vector<LogFormatSegment> segments;
+
+    };
+
+    constexpr uint32_t LOG_FORMAT_MAX = 16384;
+
+    std::mutex formatMutex;
+
+    // 只追加不删除，写入线程按 ID 直接取，不加锁
+    std::atomic<const LogFormat*> logFormats[LOG_FORMAT_MAX];
+
+    uint32_t logFormatCount = 0;
+
+    // 生产者只读单调时钟，写入线程用一对时钟样本换算成墙上时间，每分钟校准一次
+    struct LogClockBase {
+
+        int64_t system;
+
+        int64_t steady;
+
+    };
+
+    int64_t steadyNow() {
+
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    LogClockBase sampleClockBase() {
+
+        return LogClockBase{ std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count(), steadyNow() };
+    }
+
+    LogClockBase clockBase = sampleClockBase();
+
+    LogRing* threadRing() {
+
+        thread_local LogRingHolder holder;
+
+        if (!holder.ring) {
+
+            // 每个线程只在第一次打日志时加一次锁
+            // 容量必须是 2 的幂，写入位置靠掩码取模；下限至少放得下几条最长的记录
+            size_t minimum = 4 * (LOG_MESSAGE_MAX + sizeof(LogRecordHeader));
+
+            size_t requested = std::max(ringCapacity.load(std::memory_order_relaxed), minimum);
+
+            size_t capacity = 1;
+
+            while (capacity < requested) {
+                capacity <<= 1;
+            }
+
+            holder.ring = std::make_shared<LogRing>(capacity);
+
+            std::lock_guard<std::mutex> lock(registryMutex);
+
+            registry.push_back(holder.ring);
+
+            registryVersion.fetch_add(1, std::memory_order_release);
+        }
+
+        return holder.ring.get();
+    }
+
+    // 同一秒内复用格式化好的时间戳
+    const char* formatTimestamp(int64_t time) {
+
+        time_t seconds = static_cast<time_t>((clockBase.system + time - clockBase.steady) / 1000000000);
+
+        if (seconds == cachedSecond) {
+            return cachedTimestamp;
+        }
+
+        struct tm timeinfo;
+
+#ifdef _WIN32
+        if (localtime_s(&timeinfo, &seconds) != 0) {
+            return "0000-00-00 00:00:00";
+        }
+#else
+        if (localtime_r(&seconds, &timeinfo) == nullptr) {
+            return "0000-00-00 00:00:00";
+        }
+#endif
+
+        strftime(cachedTimestamp, sizeof(cachedTimestamp), "%Y-%m-%d %H:%M:%S", &timeinfo);
+
+        cachedSecond = seconds;
+
+        return cachedTimestamp;
+    }
+
+    std::string logFilePath(int level) {
+
+        return logDir + "/" + logFileNames[level] + ".log";
+    }
+
+    void ensureLogDirectory() {
+
+        if (loggerInitialized) {
+            return;
+        }
+
+#ifdef _WIN32
+        _mkdir(logDir.c_str());
+#else
+        mkdir(logDir.c_str(), 0755);
+#endif
+
+        loggerInitialized = 1;
+    }
+
+    void closeLogFile(LogFile& logFile) {
+
+        if (logFile.file) {
+            fclose(logFile.file);
+        }
+
+        logFile = LogFile();
+    }
+
+    // 文件一直开着，全缓冲，每批结束时 fflush 一次
+    FILE* openLogFile(int level) {
+
+        LogFile& logFile = logFiles[level];
+
+        if (logFile.file) {
+            return logFile.file;
+        }
+
+        ensureLogDirectory();
+
+        std::string filePath = logFilePath(level);
+
+        logFile.file = fopen(filePath.c_str(), "ab");
+
+        if (!logFile.file) {
+            printf("ERROR: Failed to open log file: %s\n", filePath.c_str());
+            fflush(stdout);
+            return nullptr;
+        }
+
+        setvbuf(logFile.file, nullptr, _IOFBF, 64 * 1024);
+
+        fseek(logFile.file, 0, SEEK_END);
+
+        logFile.size = static_cast<size_t>(ftell(logFile.file));
+
+        logFile.opened = time(nullptr);
+
+        return logFile.file;
+    }
+
+    // 超过大小或打开时长后改名为 <level>.<时间>.log，下一条记录再打开新文件
+    void rotateIfNeeded(int level, time_t now) {
+
+        LogFile& logFile = logFiles[level];
+
+        if (!logFile.file) {
+            return;
+        }
+
+        size_t maxSize = rotateFileSize.load(std::memory_order_relaxed);
+
+        int maxAge = rotateSeconds.load(std::memory_order_relaxed);
+
+        bool tooLarge = maxSize != 0 && logFile.size >= maxSize;
+
+        bool tooOld = maxAge > 0 && now - logFile.opened >= maxAge;
+
+        if (logFile.size == 0 || (!tooLarge && !tooOld)) {
+            return;
+        }
+
+        closeLogFile(logFile);
+
+        struct tm timeinfo;
+
+#ifdef _WIN32
+        localtime_s(&timeinfo, &now);
+#else
+        localtime_r(&now, &timeinfo);
+#endif
+
+        char suffix[32];
+
+        strftime(suffix, sizeof(suffix), "%Y%m%d-%H%M%S", &timeinfo);
+
+        std::string rotated = logDir + "/" + logFileNames[level] + "." + suffix + ".log";
+
+        // 同一秒内多次轮转时加序号，不覆盖已有文件
+        struct stat existing;
+
+        for (int sequence = 1; stat(rotated.c_str(), &existing) == 0; ++sequence) {
+            rotated = logDir + "/" + logFileNames[level] + "." + suffix + "-" + std::to_string(sequence) + ".log";
+        }
+
+        rename(logFilePath(level).c_str(), rotated.c_str());
+    }
+
+    // 拆分格式串，%n 和 * 宽度等不支持的转换按原文输出
+    LogFormat* parseLogFormat(const char* format) {
+
+        LogFormat* parsed = new LogFormat();
+
+        LogFormatSegment segment;
+
+        const char* cursor = format;
+
+        while (*cursor) {
+
+            if (*cursor != '%') {
+                segment.literal.push_back(*cursor++);
+                continue;
+            }
+
+            if (cursor[1] == '%') {
+                segment.literal.push_back('%');
+                cursor += 2;
+                continue;
+            }
+
+            const char* start = cursor++;
+
+            std::string spec = "%";
+
+            while (*cursor && strchr("-+ #0", *cursor)) {
+                spec.push_back(*cursor++);
+            }
+
+            while (isdigit(static_cast<unsigned char>(*cursor))) {
+                spec.push_back(*cursor++);
+            }
+
+            if (*cursor == '.') {
+
+                spec.push_back(*cursor++);
+
+                while (isdigit(static_cast<unsigned char>(*cursor))) {
+                    spec.push_back(*cursor++);
+                }
+            }
+
+            // 长度修饰符由参数类型决定，包括 MSVC 的 I64
+            while (*cursor && strchr("hljztLqI", *cursor)) {
+
+                if (*cursor++ == 'I') {
+                    while (isdigit(static_cast<unsigned char>(*cursor))) {
+                        ++cursor;
+                    }
+                }
+            }
+
+            if (!*cursor || !strchr("diouxXcfFeEgGaAsp", *cursor)) {
+                segment.literal.append(start, cursor - start);
+                continue;
+            }
+
+            segment.conversion = *cursor++;
+
+            if (strchr("diouxX", segment.conversion)) {
+                spec += "ll";
+            }
+
+            segment.spec = spec + segment.conversion;
+
+            parsed->segments.push_back(std::move(segment));
+
+            segment = LogFormatSegment();
+        }
+
+        if (!segment.literal.empty()) {
+            parsed->segments.push_back(std::move(segment));
+        }
+
+        return parsed;
+    }
+
+    struct LogArg {
+
+        uint8_t type = 0;
+
+        uint64_t bits = 0;
+
+        const char* text = nullptr;
+
+    };
+
+    // 按 LogArgBuffer 的编码读出下一个参数，读完或数据不完整时 type 为 0
+    LogArg nextLogArg(const unsigned char*& cursor, const unsigned char* end) {
+
+        LogArg arg;
+
+        if (cursor >= end) {
+            return arg;
+        }
+
+        uint8_t type = *cursor++;
+
+        if (type == LOG_ARG_STRING) {
+
+            uint16_t length;
+
+            if (end - cursor < static_cast<ptrdiff_t>(sizeof(length))) {
+                cursor = end;
+                return arg;
+            }
+
+            memcpy(&length, cursor, sizeof(length));
+
+            cursor += sizeof(length);
+
+            if (end - cursor < length + 1) {
+                cursor = end;
+                return arg;
+            }
+
+            arg.text = reinterpret_cast<const char*>(cursor);
+
+            cursor += length + 1;
+        }
+        else {
+
+            if (end - cursor < static_cast<ptrdiff_t>(sizeof(uint64_t))) {
+                cursor = end;
+                return arg;
+            }
+
+            memcpy(&arg.bits, cursor, sizeof(uint64_t));
+
+            cursor += sizeof(uint64_t);
+        }
+
+        arg.type = type;
+
+        return arg;
+    }
+
+    // 按转换说明期望的类型输出一个参数，类型不符时尽量按参数本身的类型输出
+    int formatLogArg(char* out, size_t size, const LogFormatSegment& segment, const LogArg& arg) {
+
+        int64_t integer;
+
+        double real;
+
+        memcpy(&integer, &arg.bits, sizeof(integer));
+
+        memcpy(&real, &arg.bits, sizeof(real));
+
+        if (arg.type == 0) {
+            return snprintf(out, size, "?");
+        }
+
+        const char* spec = segment.spec.c_str();
+
+        switch (segment.conversion) {
+        case 's':
+            if (arg.type == LOG_ARG_STRING) {
+                return snprintf(out, size, spec, arg.text);
+            }
+            break;
+        case 'c':
+            if (arg.type == LOG_ARG_INT || arg.type == LOG_ARG_UINT) {
+                return snprintf(out, size, spec, static_cast<int>(integer));
+            }
+            break;
+        case 'p':
+            if (arg.type != LOG_ARG_STRING && arg.type != LOG_ARG_DOUBLE) {
+                return snprintf(out, size, spec, reinterpret_cast<void*>(static_cast<uintptr_t>(arg.bits)));
+            }
+            break;
+        case 'd':
+        case 'i':
+            if (arg.type == LOG_ARG_DOUBLE) {
+                return snprintf(out, size, spec, static_cast<long long>(real));
+            }
+            if (arg.type != LOG_ARG_STRING) {
+                return snprintf(out, size, spec, static_cast<long long>(integer));
+            }
+            break;
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+            if (arg.type == LOG_ARG_DOUBLE) {
+                return snprintf(out, size, spec, static_cast<unsigned long long>(real));
+            }
+            if (arg.type != LOG_ARG_STRING) {
+                return snprintf(out, size, spec, static_cast<unsigned long long>(arg.bits));
+            }
+            break;
+        default:
+            if (arg.type == LOG_ARG_DOUBLE) {
+                return snprintf(out, size, spec, real);
+            }
+            if (arg.type == LOG_ARG_INT) {
+                return snprintf(out, size, spec, static_cast<double>(integer));
+            }
+            if (arg.type == LOG_ARG_UINT) {
+                return snprintf(out, size, spec, static_cast<double>(arg.bits));
+            }
+            break;
+        }
+
+        switch (arg.type) {
+        case LOG_ARG_STRING:
+            return snprintf(out, size, "%s", arg.text);
+        case LOG_ARG_DOUBLE:
+            return snprintf(out, size, "%g", real);
+        case LOG_ARG_UINT:
+        case LOG_ARG_POINTER:
+            return snprintf(out, size, "%llu", static_cast<unsigned long long>(arg.bits));
+        default:
+            return snprintf(out, size, "%lld", static_cast<long long>(integer));
+        }
+    }
+
+    // 把延迟记录格式化到 out，返回长度，超长截断
+    size_t formatDeferred(const char* payload, size_t size, char* out, size_t capacity) {
+
+        uint32_t formatId = LOG_FORMAT_MAX;
+
+        if (size >= sizeof(formatId)) {
+            memcpy(&formatId, payload, sizeof(formatId));
+        }
+
+        const LogFormat* format = formatId < LOG_FORMAT_MAX ? logFormats[formatId].load(std::memory_order_acquire) : nullptr;
+
+        if (!format) {
+            return static_cast<size_t>(snprintf(out, capacity, "[unregistered log format %u]", formatId));
+        }
+
+        const unsigned char* cursor = reinterpret_cast<const unsigned char*>(payload) + sizeof(formatId);
+
+        const unsigned char* end = reinterpret_cast<const unsigned char*>(payload) + size;
+
+        size_t length = 0;
+
+        out[0] = '\0';
+
+        for (const LogFormatSegment& segment : format->segments) {
+
+            size_t literal = std::min(segment.literal.size(), capacity - 1 - length);
+
+            memcpy(out + length, segment.literal.data(), literal);
+
+            length += literal;
+
+            out[length] = '\0';
+
+            if (!segment.conversion || length + 1 >= capacity) {
+                continue;
+            }
+
+            int written = formatLogArg(out + length, capacity - length, segment, nextLogArg(cursor, end));
+
+            if (written > 0) {
+                length += std::min(static_cast<size_t>(written), capacity - 1 - length);
+            }
+        }
+
+        return length;
+    }
+
+    void writeRecord(const LogRecordHeader& header, const char* text) {
+
+        char formatted[LOG_MESSAGE_MAX];
+
+        size_t textLength = header.textLength;
+
+        if (header.flags & LOG_RECORD_DEFERRED) {
+
+            textLength = formatDeferred(text, header.textLength, formatted, sizeof(formatted));
+
+            text = formatted;
+        }
+
+        int level = header.level;
+
+        const char* levelStr;
+
+        const char* color;
+
+        getLevelInfo(static_cast<LogLevel>(level), &levelStr, &color);
+
+        const char* timestamp = formatTimestamp(header.time);
+
+        char prefix[96];
+
+        // 输出到控制台（如果该级别允许），整批一次 fwrite
+        if (!(header.flags & LOG_RECORD_FILE_ONLY) && consoleOutputLevels[level].load(std::memory_order_relaxed)) {
+
+            bool plain = header.flags & LOG_RECORD_PLAIN;
+
+            int prefixLength = snprintf(prefix, sizeof(prefix), "%s[%s][%s] ", plain ? "" : color, levelStr, timestamp);
+
+            consoleBatch.append(prefix, prefixLength);
+
+            consoleBatch.append(text, textLength);
+
+            if (!plain) {
+                consoleBatch.append(COLOR_RESET);
+            }
+
+            consoleBatch.push_back('\n');
+        }
+
+        // 输出到文件
+        if (!logToFileEnabled.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        FILE* file = openLogFile(level);
+
+        if (!file) {
+            return;
+        }
+
+        int prefixLength = snprintf(prefix, sizeof(prefix), "[%s][%s] ", timestamp, levelStr);
+
+        fwrite(prefix, 1, prefixLength, file);
+
+        fwrite(text, 1, textLength, file);
+
+        fputc('\n', file);
+
+        logFiles[level].size += prefixLength + textLength + 1;
+    }
+
+    void flushOutputs() {
+
+        if (!consoleBatch.empty()) {
+
+            fwrite(consoleBatch.data(), 1, consoleBatch.size(), stdout);
+
+            fflush(stdout);
+
+            consoleBatch.clear();
+        }
+
+        // 长时间运行后系统时间可能被 NTP 调整，重新取一对时钟样本
+        if (steadyNow() - clockBase.steady > 60 * 1000000000LL) {
+            clockBase = sampleClockBase();
+        }
+
+        time_t now = time(nullptr);
+
+        for (int level = 0; level < 4; ++level) {
+
+            if (logFiles[level].file) {
+                fflush(logFiles[level].file);
+            }
+
+            rotateIfNeeded(level, now);
+        }
+    }
+
+    // 取出一个缓冲区的全部记录，返回条数
+    size_t drainRing(LogRing& ring) {
+
+        size_t head = ring.head.load(std::memory_order_relaxed);
+
+        size_t tail = ring.tail.load(std::memory_order_acquire);
+
+        size_t mask = ring.buffer.size() - 1;
+
+        size_t count = 0;
+
+        while (head != tail) {
+
+            const LogRecordHeader* header = reinterpret_cast<const LogRecordHeader*>(ring.buffer.data() + (head & mask));
+
+            if (!(header->flags & LOG_RECORD_PADDING)) {
+
+                writeRecord(*header, reinterpret_cast<const char*>(header + 1));
+
+                ++count;
+            }
+
+            head += header->size;
+        }
+
+        ring.head.store(head, std::memory_order_release);
+
+        uint64_t dropped = ring.dropped.exchange(0, std::memory_order_relaxed);
+
+        if (dropped != 0) {
+
+            char text[96];
+
+            int length = snprintf(text, sizeof(text), "%llu log messages dropped, log buffer full", static_cast<unsigned long long>(dropped));
+
+            LogRecordHeader header{ 0, LOG_LEVEL_WARNING, 0, static_cast<uint16_t>(length), steadyNow() };
+
+            writeRecord(header, text);
+        }
+
+        return count;
+    }
+
+    void writerLoop() {
+
+        std::vector<std::shared_ptr<LogRing>> rings;
+
+        uint64_t version = 0;
+
+        for (;;) {
+
+            bool stopping = !writerRunning.load(std::memory_order_acquire);
+
+            // 注册表只在有新线程加入时才复制一次
+            if (registryVersion.load(std::memory_order_acquire) != version) {
+
+                std::lock_guard<std::mutex> lock(registryMutex);
+
+                rings = registry;
+
+                version = registryVersion.load(std::memory_order_relaxed);
+            }
+
+            size_t written = 0;
+
+            bool removed = false;
+
+            for (std::shared_ptr<LogRing>& ring : rings) {
+
+                bool abandoned = ring->abandoned.load(std::memory_order_acquire);
+
+                written += drainRing(*ring);
+
+                // 线程已退出且已取完，移出注册表
+                if (abandoned) {
+
+                    std::lock_guard<std::mutex> lock(registryMutex);
+
+                    registry.erase(std::remove(registry.begin(), registry.end(), ring), registry.end());
+
+                    registryVersion.fetch_add(1, std::memory_order_release);
+
+                    removed = true;
+                }
+            }
+
+            if (removed) {
+                version = 0;
+            }
+
+            flushOutputs();
+
+            if (stopping) {
+                return;
+            }
+
+            // 空闲时最多 10ms 取一次，生产者不做任何通知
+            if (written == 0) {
+
+                std::unique_lock<std::mutex> lock(writerMutex);
+
+                writerWakeup.wait_for(lock, std::chrono::milliseconds(10), [] { return !writerRunning.load(std::memory_order_acquire); });
+            }
+        }
+    }
+
+    // 写入线程未运行（initLogger 之前或 closeLogger 之后）时同步写出
+    void writeSync(const LogRecordHeader& header, const char* text) {
+
+        std::lock_guard<std::mutex> lock(logMutex);
+
+        writeRecord(header, text);
+
+        flushOutputs();
+    }
+
+    void enqueueLog(LogLevel level, uint8_t flags, const char* text, size_t length) {
+
+        if (level < LOG_LEVEL_DEBUG || level > LOG_LEVEL_ERROR) {
+            return;
+        }
+
+        LogRecordHeader header{};
+
+        header.level = static_cast<uint8_t>(level);
+
+        header.flags = flags;
+
+        header.textLength = static_cast<uint16_t>(length);
+
+        header.time = steadyNow();
+
+        if (!writerRunning.load(std::memory_order_acquire)) {
+            writeSync(header, text);
+            return;
+        }
+
+        LogRing& ring = *threadRing();
+
+        size_t need = (sizeof(LogRecordHeader) + length + 15) & ~size_t(15);
+
+        size_t capacity = ring.buffer.size();
+
+        size_t tail = ring.tail.load(std::memory_order_relaxed);
+
+        size_t head = ring.head.load(std::memory_order_acquire);
+
+        size_t offset = tail & (capacity - 1);
+
+        size_t toEnd = capacity - offset;
+
+        size_t padding = toEnd < need ? toEnd : 0;
+
+        if (capacity - (tail - head) < need + padding) {
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        if (padding) {
+
+            LogRecordHeader pad{};
+
+            pad.size = static_cast<uint32_t>(padding);
+
+            pad.flags = LOG_RECORD_PADDING;
+
+            memcpy(ring.buffer.data() + offset, &pad, sizeof(pad));
+
+            tail += padding;
+
+            offset = 0;
+        }
+
+        header.size = static_cast<uint32_t>(need);
+
+        memcpy(ring.buffer.data() + offset, &header, sizeof(header));
+
+        memcpy(ring.buffer.data() + offset + sizeof(header), text, length);
+
+        ring.tail.store(tail + need, std::memory_order_release);
+    }
+
+    // 格式化到栈上缓冲区，超长时给出提示
+    size_t formatMessage(char* messageBuffer, size_t size, const char* format, va_list args) {
+
+        int len = vsnprintf(messageBuffer, size, format, args);
+
+        if (len < 0 || len >= (int)size) {
+#ifdef _WIN32
+            strcpy_s(messageBuffer, size, "[Message too long or formatting error]");
+#else
+            strncpy(messageBuffer, "[Message too long or formatting error]", size - 1);
+            messageBuffer[size - 1] = '\0';
+#endif
+            return strlen(messageBuffer);
+        }
+
+        return static_cast<size_t>(len);
+    }
+
+    // 进程退出时还没调用 closeLogger，在静态对象析构前停下写入线程
+    struct LoggerShutdown {
+
+        ~LoggerShutdown() {
+            closeLogger();
+        }
+
+    } loggerShutdown;
+}
+
+// 初始化日志系统，启动写入线程
+void initLogger() {
+    std::lock_guard<std::mutex> lock(logMutex);
+
+    ensureLogDirectory();
+
+    if (writerRunning.exchange(true)) {
+        return;
+    }
+
+    writerThread = std::thread(writerLoop);
+}
+
+// 停止写入线程，写出剩余记录并关闭文件
+void closeLogger() {
+    std::lock_guard<std::mutex> lock(logMutex);
+
+    if (writerRunning.exchange(false)) {
+
+        writerWakeup.notify_all();
+
+        writerThread.join();
+    }
+
+    for (LogFile& logFile : logFiles) {
+        closeLogFile(logFile);
+    }
+}
+
+void enableFileLogging(int enable) {
+    logToFileEnabled.store(enable);
+}
+
+// 日志目录只由写入线程读取，需在 initLogger 之前设置
+void setLogDirectory(const char* dir) {
+    std::lock_guard<std::mutex> lock(logMutex);
+    logDir = dir;
+    loggerInitialized = 0;
+}
+
+void setLogRotation(size_t maxFileSize, int maxFileSeconds) {
+    rotateFileSize.store(maxFileSize);
+    rotateSeconds.store(maxFileSeconds);
+}
+
+void setLogBufferSize(size_t bytes) {
+    ringCapacity.store(bytes);
+}
+
+// 每个调用点登记一次，返回的格式 ID 在进程内一直有效
+uint32_t registerLogFormat(const char* format) {
+    LogFormat* parsed = parseLogFormat(format);
+
+    std::lock_guard<std::mutex> lock(formatMutex);
+
+    if (logFormatCount >= LOG_FORMAT_MAX) {
+        delete parsed;
+        return LOG_FORMAT_MAX;
+    }
+
+    uint32_t formatId = logFormatCount++;
+
+    logFormats[formatId].store(parsed, std::memory_order_release);
+
+    return formatId;
+}
+
+// 不做任何格式化，只把参数原样放进本线程的缓冲区
+void logDeferredRecord(LogLevel level, const unsigned char* record, size_t size) {
+    enqueueLog(level, LOG_RECORD_DEFERRED, reinterpret_cast<const char*>(record), size);
+}
+
+// 设置哪些级别只输出到文件（不在控制台显示）
+void setConsoleOutputLevels(int debug, int info, int warning, int error) {
+    consoleOutputLevels[LOG_LEVEL_DEBUG].store(debug);
+    consoleOutputLevels[LOG_LEVEL_INFO].store(info);
+    consoleOutputLevels[LOG_LEVEL_WARNING].store(warning);
+    consoleOutputLevels[LOG_LEVEL_ERROR].store(error);
+}
+
+void getTimestamp(char* buffer, size_t size) {
+    time_t rawtime;
+    struct tm timeinfo;
+
+    time(&rawtime);
+
+#ifdef _WIN32
+    if (localtime_s(&timeinfo, &rawtime) != 0) {
+        strncpy_s(buffer, size, "0000-00-00 00:00:00", _TRUNCATE);
+        return;
+    }
+#else
+    if (localtime_r(&rawtime, &timeinfo) == nullptr) {
+        strncpy(buffer, "0000-00-00 00:00:00", size - 1);
+        buffer[size - 1] = '\0';
+        return;
+    }
+#endif
+
+    strftime(buffer, size, "%Y-%m-%d %H:%M:%S", &timeinfo);
+}
+
+void getLevelInfo(LogLevel level, const char** levelStr, const char** color) {
+    switch (level) {
+    case LOG_LEVEL_INFO:
+        *levelStr = "INFO";
+        *color = COLOR_GREEN;
+        break;
+    case LOG_LEVEL_WARNING:
+        *levelStr = "WARNING";
+        *color = COLOR_YELLOW;
+        break;
+    case LOG_LEVEL_ERROR:
+        *levelStr = "ERROR";
+        *color = COLOR_RED;
+        break;
+    case LOG_LEVEL_DEBUG:
+        *levelStr = "DEBUG";
+        *color = COLOR_BLUE;
+        break;
+    default:
+        *levelStr = "UNKNOWN";
+        *color = COLOR_RESET;
+        break;
+    }
+}
+
+// 带颜色的日志输出，不加锁，写入线程负责输出
+void logMessage(LogLevel level, const char* format, ...) {
+    char messageBuffer[LOG_MESSAGE_MAX];
+    va_list args;
+
+    va_start(args, format);
+    size_t length = formatMessage(messageBuffer, sizeof(messageBuffer), format, args);
+    va_end(args);
+
+    enqueueLog(level, 0, messageBuffer, length);
+}
+
+// 不带颜色的日志输出
+void logMessagePlain(LogLevel level, const char* format, ...) {
+    char messageBuffer[LOG_MESSAGE_MAX];
+    va_list args;
+
+    va_start(args, format);
+    size_t length = formatMessage(messageBuffer, sizeof(messageBuffer), format, args);
+    va_end(args);
+
+    enqueueLog(level, LOG_RECORD_PLAIN, messageBuffer, length);
+}
+
+// 只输出到文件
+void logToFileOnly(LogLevel level, const char* format, ...) {
+    if (!logToFileEnabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    char messageBuffer[LOG_MESSAGE_MAX];
+    va_list args;
+
+    va_start(args, format);
+    size_t length = formatMessage(messageBuffer, sizeof(messageBuffer), format, args);
+    va_end(args);
+
+    enqueueLog(level, LOG_RECORD_FILE_ONLY, messageBuffer, length);
+}
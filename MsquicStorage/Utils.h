@@ -1,146 +1,508 @@
-#pragma once
-#ifndef UTILS_H
-#define UTILS_H
-
-#include <stdio.h>
-#include <time.h>
-#include <stdarg.h>
-#include <string.h>
-#include <chrono>
-#include <boost/json.hpp>
-
-#ifdef _WIN32
-#include <direct.h>
-#define mkdir(dir) _mkdir(dir)
-#else
-#include <sys/stat.h>
-#include <unistd.h>
-#endif
-
-#include "MsquicSocketInterface.h"
-#include "MsquicSocket.h"
-#include "WebRTCSignalSocket.h"
-
-constexpr std::chrono::seconds PING_INTERVAL = std::chrono::seconds(30);
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-    // 日志级别
-    typedef enum {
-        LOG_LEVEL_DEBUG,
-        LOG_LEVEL_INFO,
-        LOG_LEVEL_WARNING,
-        LOG_LEVEL_ERROR
-    } LogLevel;
-
-    // 初始化函数
-    void initLogger();
-    void closeLogger();
-    void enableFileLogging(int enable);
-    void setLogDirectory(const char* dir);
-
-    // 核心日志函数
-    void logMessage(LogLevel level, const char* format, ...);
-    void logMessagePlain(LogLevel level, const char* format, ...);
-    void logToFileOnly(LogLevel level, const char* format, ...);
-
-    // 辅助函数
-    void getTimestamp(char* buffer, size_t size);
-    void getLevelInfo(LogLevel level, const char** levelStr, const char** color);
-
-    void setConsoleOutputLevels(int debug, int info, int warning, int error);
-
-    // 便捷宏定义
-#define LOG_INFO(fmt, ...)    logMessage(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
-#define LOG_WARNING(fmt, ...) logMessage(LOG_LEVEL_WARNING, fmt, ##__VA_ARGS__)
-#define LOG_ERROR(fmt, ...)   logMessage(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
-#define LOG_DEBUG(fmt, ...)   logMessage(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
-
-#define LOG_INFO_PLAIN(fmt, ...)    logMessagePlain(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
-#define LOG_WARNING_PLAIN(fmt, ...) logMessagePlain(LOG_LEVEL_WARNING, fmt, ##__VA_ARGS__)
-#define LOG_ERROR_PLAIN(fmt, ...)   logMessagePlain(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
-#define LOG_DEBUG_PLAIN(fmt, ...)   logMessagePlain(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
-
-#ifdef __cplusplus
-}
-#endif
-
-// 粗爆转义 JSON 字符串值（只处理 string 类型）
-static void brutalEscapeJson(boost::json::object& obj) {
-    for (auto& [k, v] : obj) {
-        if (v.is_string()) {
-            std::string s = v.as_string().c_str();
-            // 只干两件事：去 \0 和 '
-            std::replace(s.begin(), s.end(), '\0', ' ');
-            std::replace(s.begin(), s.end(), '\'', ' ');
-            obj[k] = std::move(s);
-        }
-        else if (v.is_object()) {
-            brutalEscapeJson(v.as_object());   // 递归
-        }
-        else if (v.is_array()) {
-            for (auto& elem : v.as_array()) {
-                if (elem.is_object()) brutalEscapeJson(elem.as_object());
-                if (elem.is_string()) {
-                    std::string s = elem.as_string().c_str();
-                    std::replace(s.begin(), s.end(), '\0', ' ');
-                    std::replace(s.begin(), s.end(), '\'', ' ');
-                    elem = std::move(s);
-                }
-            }
-        }
-    }
-}
-
-// 深度拷贝一份 JSON 并转义
-static boost::json::object makeCleanCopy(const boost::json::object& src) {
-    boost::json::object dst = src;   // 深度拷贝
-    brutalEscapeJson(dst);
-    return dst;
-}
-
-namespace {
-    // 辅助函数：构建消息头 + 消息体（只有length作为消息头）
-    std::pair<unsigned char*, size_t> buildData(const std::string& body, hope::quic::MsquicSocketInterface* msquicSocketInterface) {
-
-        if (dynamic_cast<hope::quic::WebRTCSignalSocket*>(msquicSocketInterface)) {
-
-            size_t totalSize = body.size();
-
-            unsigned char* buffer = new unsigned char[totalSize];
-            // 写入 body
-            memcpy(buffer, body.data(), totalSize);
-
-            return { std::move(buffer), body.size() };
-        }
-        else {
-
-            int64_t bodyLength = static_cast<int64_t>(body.size());
-            size_t totalSize = sizeof(int64_t) + bodyLength;
-
-            unsigned char* buffer = new unsigned char[totalSize];
-
-            // 写入 length (int64_t)
-            *reinterpret_cast<int64_t*>(buffer) = bodyLength;
-
-            // 写入 body
-            memcpy(buffer + sizeof(int64_t), body.data(), bodyLength);
-
-            return { std::move(buffer), totalSize };
-
-        }
-
-    }
-
-    // 重载版本，直接使用 json
-    std::pair<unsigned char*, size_t> buildMessage(const boost::json::object& jsonObj, hope::quic::MsquicSocketInterface* msquicSocketInterface) {
-
-        std::string body = boost::json::serialize(jsonObj);
-
-        return buildData(body, msquicSocketInterface);
-    }
-}
-
+#pragma once
+#ifndef UTILS_H
+#define UTILS_H
+
+#include <stdio.h>
+#include <time.h>
+#include <stdarg.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <boost/json.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifdef _WIN32
+#include <direct.h>
+#define mkdir(dir) _mkdir(dir)
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "MsquicSocketInterface.h"
+#include "MsquicSocket.h"
+#include "WebRTCSignalSocket.h"
+#include "MsquicData.h"
+#include "MsquicCompression.h"
+
+constexpr std::chrono::seconds PING_INTERVAL = std::chrono::seconds(30);
+
+// 最低位 1 的位置，mask 不能为 0
+inline int countTrailingZeros(unsigned int mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    // 日志级别
+    typedef enum {
+        LOG_LEVEL_DEBUG,
+        LOG_LEVEL_INFO,
+        LOG_LEVEL_WARNING,
+        LOG_LEVEL_ERROR
+    } LogLevel;
+
+    // 初始化函数
+    void initLogger();
+    void closeLogger();
+    void enableFileLogging(int enable);
+    void setLogDirectory(const char* dir);
+
+    // 单个日志文件超过 maxFileSize 字节或打开超过 maxFileSeconds 秒后轮转，0 表示不限
+    void setLogRotation(size_t maxFileSize, int maxFileSeconds);
+
+    // 每个线程的日志缓冲区大小，满了丢弃并计数
+    void setLogBufferSize(size_t bytes);
+
+    // 核心日志函数
+    void logMessage(LogLevel level, const char* format, ...);
+    void logMessagePlain(LogLevel level, const char* format, ...);
+    void logToFileOnly(LogLevel level, const char* format, ...);
+
+    // 辅助函数
+    void getTimestamp(char* buffer, size_t size);
+    void getLevelInfo(LogLevel level, const char** levelStr, const char** color);
+
+    void setConsoleOutputLevels(int debug, int info, int warning, int error);
+
+    // 便捷宏定义
+#define LOG_INFO(fmt, ...)    logMessage(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_WARNING(fmt, ...) logMessage(LOG_LEVEL_WARNING, fmt, ##__VA_ARGS__)
+#define LOG_ERROR(fmt, ...)   logMessage(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG(fmt, ...)   logMessage(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+
+#define LOG_INFO_PLAIN(fmt, ...)    logMessagePlain(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_WARNING_PLAIN(fmt, ...) logMessagePlain(LOG_LEVEL_WARNING, fmt, ##__VA_ARGS__)
+#define LOG_ERROR_PLAIN(fmt, ...)   logMessagePlain(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG_PLAIN(fmt, ...)   logMessagePlain(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
+
+// 延迟格式化日志：调用点第一次执行时登记格式串，之后每次只写格式 ID、单调时钟和二进制参数，由写入线程格式化
+// 支持 printf 的整数、浮点、字符串和指针转换，字符串参数在调用时拷贝；不支持 * 宽度
+enum LogArgType : uint8_t {
+    LOG_ARG_INT = 1,
+    LOG_ARG_UINT = 2,
+    LOG_ARG_DOUBLE = 3,
+    LOG_ARG_STRING = 4,   // u16 长度 + 内容 + '\0'
+    LOG_ARG_POINTER = 5,
+};
+
+uint32_t registerLogFormat(const char* format);
+
+// record 以格式 ID 开头，之后是参数
+void logDeferredRecord(LogLevel level, const unsigned char* record, size_t size);
+
+// 栈上的参数缓冲区，放不下的参数截断或丢弃，写入线程按缺参处理
+class LogArgBuffer {
+public:
+    static constexpr size_t CAPACITY = 1024;
+
+    explicit LogArgBuffer(uint32_t formatId) {
+        memcpy(bytes, &formatId, sizeof(formatId));
+    }
+
+    template <typename T>
+    void put(const T& value) {
+        if constexpr (std::is_pointer_v<T> && std::is_same_v<std::remove_cv_t<std::remove_pointer_t<T>>, char>) {
+            putString(value ? std::string_view(value) : std::string_view("(null)"));
+        }
+        else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            putString(std::string_view(value));
+        }
+        else if constexpr (std::is_floating_point_v<T>) {
+            putValue(LOG_ARG_DOUBLE, static_cast<double>(value));
+        }
+        else if constexpr (std::is_enum_v<T>) {
+            put(static_cast<std::underlying_type_t<T>>(value));
+        }
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            putValue(LOG_ARG_INT, static_cast<int64_t>(value));
+        }
+        else if constexpr (std::is_integral_v<T>) {
+            putValue(LOG_ARG_UINT, static_cast<uint64_t>(value));
+        }
+        else {
+            static_assert(std::is_pointer_v<T>, "unsupported deferred log argument");
+            putValue(LOG_ARG_POINTER, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+        }
+    }
+
+    const unsigned char* data() const { return bytes; }
+
+    size_t size() const { return length; }
+
+private:
+    template <typename V>
+    void putValue(LogArgType type, V value) {
+        if (length + 1 + sizeof(V) > CAPACITY) {
+            return;
+        }
+
+        bytes[length++] = type;
+        memcpy(bytes + length, &value, sizeof(V));
+        length += sizeof(V);
+    }
+
+    void putString(std::string_view value) {
+        if (length + 1 + sizeof(uint16_t) + 1 > CAPACITY) {
+            return;
+        }
+
+        uint16_t size = static_cast<uint16_t>(std::min(value.size(), CAPACITY - length - 1 - sizeof(uint16_t) - 1));
+
+        bytes[length++] = LOG_ARG_STRING;
+        memcpy(bytes + length, &size, sizeof(size));
+        length += sizeof(size);
+        memcpy(bytes + length, value.data(), size);
+        length += size;
+        bytes[length++] = '\0';
+    }
+
+    unsigned char bytes[CAPACITY];
+    size_t length = sizeof(uint32_t);
+};
+
+template <typename... Args>
+inline void logDeferred(LogLevel level, uint32_t formatId, const Args&... args) {
+    LogArgBuffer buffer(formatId);
+
+    (buffer.put(args), ...);
+
+    logDeferredRecord(level, buffer.data(), buffer.size());
+}
+
+// fmt 必须是字符串字面量，每个调用点只登记一次
+#define LOG_DEFERRED(level, fmt, ...) \
+    do { \
+        static const uint32_t logFormatId = registerLogFormat(fmt); \
+        logDeferred(level, logFormatId, ##__VA_ARGS__); \
+    } while (0)
+
+#define LOG_INFO_DEFERRED(fmt, ...)    LOG_DEFERRED(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_WARNING_DEFERRED(fmt, ...) LOG_DEFERRED(LOG_LEVEL_WARNING, fmt, ##__VA_ARGS__)
+#define LOG_ERROR_DEFERRED(fmt, ...)   LOG_DEFERRED(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG_DEFERRED(fmt, ...)   LOG_DEFERRED(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+
+// 原地清洗 JSON 原文：' 替换为空格，\u0000 / \u0027 转义替换为 \u0020，长度不变
+// 没有可疑字符时只是一次向量化扫描，不做任何拷贝和分配
+static void scrubJsonInPlace(char* data, size_t size) {
+
+    char* cursor = data;
+
+    char* end = data + size;
+
+    while (cursor < end) {
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+        // 16 字节一组查找 ' 和 \，整组干净直接跳过
+        const __m128i quote = _mm_set1_epi8('\'');
+
+        const __m128i backslash = _mm_set1_epi8('\\');
+
+        while (end - cursor >= 16) {
+
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cursor));
+
+            int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+
+            if (mask != 0) {
+
+                cursor += countTrailingZeros(static_cast<unsigned int>(mask));
+
+                break;
+            }
+
+            cursor += 16;
+        }
+#endif
+
+        while (cursor < end && *cursor != '\'' && *cursor != '\\') {
+
+            ++cursor;
+
+        }
+
+        if (cursor >= end) {
+
+            return;
+
+        }
+
+        if (*cursor == '\'') {
+
+            *cursor++ = ' ';
+
+            continue;
+        }
+
+        // 转义序列：\uXXXX 占 6 字节，其余占 2 字节（跳过 \\ 避免误判下一个反斜杠）
+        if (end - cursor >= 6 && cursor[1] == 'u' && cursor[2] == '0' && cursor[3] == '0'
+            && ((cursor[4] == '0' && cursor[5] == '0') || (cursor[4] == '2' && cursor[5] == '7'))) {
+
+            cursor[4] = '2';
+
+            cursor[5] = '0';
+
+            cursor += 6;
+
+            continue;
+        }
+
+        cursor += 2;
+    }
+}
+
+namespace {
+    // 辅助函数：构建二进制帧（定长帧头 + 源/目标 ID + 负载），ID 超过 255 字节会被截断
+    // compressionFlags 非 0 表示负载已经压缩过，带上标志原样写入
+    std::pair<unsigned char*, size_t> buildBinaryData(hope::quic::MsquicSocketInterface* msquicSocketInterface, int64_t requestType, int64_t state, std::string_view sourceId, std::string_view targetId, std::string_view payload, uint8_t compressionFlags = 0) {
+
+        hope::quic::BinaryHeader header;
+
+        header.requestType = static_cast<uint16_t>(requestType);
+
+        header.state = static_cast<uint16_t>(state);
+
+        header.sourceIdLength = static_cast<uint8_t>(std::min<size_t>(sourceId.size(), UINT8_MAX));
+
+        header.targetIdLength = static_cast<uint8_t>(std::min<size_t>(targetId.size(), UINT8_MAX));
+
+        header.flags = compressionFlags;
+
+        // 超过阈值的负载直接压缩进发送缓冲区，压缩后没有变小就按原文发送
+        hope::quic::MsquicCompression& compression = hope::quic::MsquicCompression::instance();
+
+        bool compress = compressionFlags == 0 && compression.shouldCompress(payload.size());
+
+        size_t payloadCapacity = compress ? compression.compressBound(payload.size()) : payload.size();
+
+        unsigned char* buffer = msquicSocketInterface->allocateBuffer(hope::quic::BINARY_HEADER_SIZE + header.sourceIdLength + header.targetIdLength + payloadCapacity);
+
+        unsigned char* cursor = buffer + hope::quic::BINARY_HEADER_SIZE;
+
+        memcpy(cursor, sourceId.data(), header.sourceIdLength);
+
+        cursor += header.sourceIdLength;
+
+        memcpy(cursor, targetId.data(), header.targetIdLength);
+
+        cursor += header.targetIdLength;
+
+        size_t payloadLength = compress ? compression.compress(payload, cursor, header.flags) : 0;
+
+        if (payloadLength == 0) {
+
+            memcpy(cursor, payload.data(), payload.size());
+
+            payloadLength = payload.size();
+
+        }
+
+        header.payloadLength = static_cast<uint32_t>(payloadLength);
+
+        hope::quic::encodeBinaryHeader(buffer, header);
+
+        return { buffer, hope::quic::binaryFrameSize(header) };
+    }
+
+    // 重载版本，直接使用 json：增量序列化直接写进发送缓冲区，写满按两倍扩容，最后回填帧头
+    // 二进制客户端的 requestType/state 放进帧头，整个 json 作为负载
+    std::pair<unsigned char*, size_t> buildMessage(const boost::json::object& jsonObj, hope::quic::MsquicSocketInterface* msquicSocketInterface) {
+
+        size_t headerSize = msquicSocketInterface->frameHeaderSize();
+
+        size_t capacity = hope::utils::MsquicSharedBuffer::capacity(headerSize + 512);
+
+        size_t size = headerSize;
+
+        unsigned char* buffer = msquicSocketInterface->allocateBuffer(capacity);
+
+        boost::json::serializer serializer;
+
+        serializer.reset(&jsonObj);
+
+        while (!serializer.done()) {
+
+            if (size == capacity) {
+
+                // 按池的级别扩容，用满整块
+                size_t grownCapacity = hope::utils::MsquicSharedBuffer::capacity(capacity * 2);
+
+                unsigned char* grown = msquicSocketInterface->allocateBuffer(grownCapacity);
+
+                memcpy(grown, buffer, size);
+
+                hope::utils::MsquicSharedBuffer::release(buffer);
+
+                buffer = grown;
+
+                capacity = grownCapacity;
+            }
+
+            size += serializer.read(reinterpret_cast<char*>(buffer + size), capacity - size).size();
+        }
+
+        const boost::json::value* requestType = jsonObj.if_contains("requestType");
+
+        const boost::json::value* state = jsonObj.if_contains("state");
+
+        msquicSocketInterface->encodeFrameHeader(buffer, size - headerSize,
+            requestType && requestType->is_int64() ? requestType->as_int64() : 0,
+            state && state->is_int64() ? state->as_int64() : 0);
+
+        return { buffer, size };
+    }
+
+    // 类型化应答：先算长度，再把帧头和 JSON 直接编码进发送缓冲区，不经过 boost::json::object
+    std::pair<unsigned char*, size_t> buildMessage(const hope::quic::MsquicResponse& response, hope::quic::MsquicSocketInterface* msquicSocketInterface) {
+
+        size_t bodyLength = hope::quic::encodedJsonSize(response);
+
+        size_t headerSize = msquicSocketInterface->frameHeaderSize();
+
+        size_t totalSize = headerSize + bodyLength;
+
+        unsigned char* buffer = msquicSocketInterface->allocateBuffer(totalSize);
+
+        msquicSocketInterface->encodeFrameHeader(buffer, bodyLength, response.requestType, response.state);
+
+        hope::quic::JsonBufferWriter writer(reinterpret_cast<char*>(buffer + headerSize));
+
+        hope::quic::encodeJson(response, writer);
+
+        return { buffer, totalSize };
+    }
+
+    // 二进制负载转 JSON：负载本身是 JSON 对象时直接展开，否则放进 payload 字段
+    boost::json::object binaryPayloadToJson(hope::quic::MsquicData& data) {
+
+        boost::json::object json(data.getStorage());
+
+        boost::json::error_code ec;
+
+        boost::json::value value = boost::json::parse(data.payload, ec, data.getStorage());
+
+        if (!ec && value.is_object()) {
+
+            json = std::move(value.as_object());
+
+        }
+        else if (!data.payload.empty()) {
+
+            json["payload"] = data.payload;
+
+        }
+
+        json["requestType"] = data.requestType;
+
+        json["accountId"] = data.accountId;
+
+        json["targetId"] = data.targetId;
+
+        return json;
+    }
+
+    // 构建转给目标的 DATAGRAM：ID 改写为源 ID，负载原样透传
+    std::pair<unsigned char*, size_t> buildDatagram(hope::quic::MsquicSocketInterface* msquicSocketInterface, std::string_view sourceId, std::string_view payload) {
+
+        sourceId = sourceId.substr(0, UINT8_MAX);
+
+        size_t size = hope::quic::DATAGRAM_HEADER_SIZE + sourceId.size() + payload.size();
+
+        unsigned char* buffer = msquicSocketInterface->allocateBuffer(size);
+
+        size_t headerSize = hope::quic::encodeDatagramHeader(buffer, sourceId);
+
+        memcpy(buffer + headerSize, payload.data(), payload.size());
+
+        return { buffer, size };
+    }
+
+    // 构建转发消息，按目标连接的协议决定编码，二进制负载原样透传
+    // 转给 JSON 目标的压缩负载要先由调用方 inflate
+    std::pair<unsigned char*, size_t> buildForwardMessage(hope::quic::MsquicData& data, hope::quic::MsquicSocketInterface* msquicSocketInterface) {
+
+        if (msquicSocketInterface->getProtocol() == hope::quic::WireProtocol::Binary) {
+
+            // 二进制负载原样透传，压缩过的连同压缩标志一起转发，不解压也不重新压缩；清洗过的 JSON 原文直接作为负载
+            return buildBinaryData(msquicSocketInterface, data.requestType, 200, data.accountId, data.targetId, data.payload, data.compressionFlags);
+        }
+
+        if (data.protocol == hope::quic::WireProtocol::Json && data.hasForwardFields) {
+
+            // 原文自带 state/message，改写 DOM 后重新序列化，不产生重复键
+            boost::json::object& forwardMessage = data.getJson();
+
+            forwardMessage["state"] = 200;
+
+            forwardMessage["message"] = "MsquicServer forward";
+
+            return buildMessage(forwardMessage, msquicSocketInterface);
+        }
+
+        if (data.protocol == hope::quic::WireProtocol::Json) {
+
+            // 在顶层对象的右括号处拼接转发字段，省去 DOM 构建和重新序列化
+            std::string_view forwardFields = "\"state\":200,\"message\":\"MsquicServer forward\"}";
+
+            size_t closing = data.jsonEnd;
+
+            size_t separator = data.memberCount > 0 ? 1 : 0;
+
+            size_t bodyLength = closing + separator + forwardFields.size();
+
+            size_t headerSize = msquicSocketInterface->frameHeaderSize();
+
+            unsigned char* buffer = msquicSocketInterface->allocateBuffer(headerSize + bodyLength);
+
+            unsigned char* cursor = buffer + headerSize;
+
+            memcpy(cursor, data.payload.data(), closing);
+
+            cursor += closing;
+
+            if (separator) {
+
+                *cursor++ = ',';
+
+            }
+
+            memcpy(cursor, forwardFields.data(), forwardFields.size());
+
+            msquicSocketInterface->encodeFrameHeader(buffer, bodyLength, data.requestType, 200);
+
+            return { buffer, headerSize + bodyLength };
+        }
+
+        boost::json::object forwardMessage = binaryPayloadToJson(data);
+
+        forwardMessage["state"] = 200;
+
+        forwardMessage["message"] = "MsquicServer forward";
+
+        return buildMessage(forwardMessage, msquicSocketInterface);
+    }
+}
+
 #endif // UTILS_H
\ No newline at end of file
@@ -1,350 +1,495 @@
-#include "WebRTCSignalSocket.h"
-#include "MsquicManager.h"
-#include "MsquicData.h"
-
-#include "Utils.h"
-
-namespace hope {
-
-    namespace quic {
-
-        WebRTCSignalSocket::WebRTCSignalSocket(boost::asio::io_context& ioContext, hope::quic::MsquicManager * msquicManager)
-            : ioContext(ioContext)
-            , writerChannel(ioContext, 1)
-            , resolver(ioContext)
-            , registrationTimer(ioContext)
-            , webSocket(ioContext)
-            , channelIndex(channelIndex)
-            , msquicManager(msquicManager) {
-        }
-
-        WebRTCSignalSocket::~WebRTCSignalSocket() {
-            clear();
-        }
-
-        boost::asio::ip::tcp::socket& WebRTCSignalSocket::getSocket() {
-
-            return webSocket.next_layer();
-
-        }
-
-        void WebRTCSignalSocket::destroy() { // 统一销毁入口
-            bool expected = false;
-            if (isDeleted.compare_exchange_strong(expected, true)) {
-                this->closeSocket();
-            }
-        }
-
-        boost::asio::io_context& WebRTCSignalSocket::getIoCompletionPorts() {
-            return ioContext;
-        }
-
-        boost::beast::websocket::stream<boost::asio::ip::tcp::socket>& WebRTCSignalSocket::getWebSocket() {
-
-            return webSocket;
-
-        }
-
-        boost::asio::awaitable<void> WebRTCSignalSocket::handShake() {
-            // 假设 webSocket.next_layer() 已经通过 acceptor.async_accept 连接成功
-
-            boost::beast::flat_buffer buffer;
-            boost::beast::http::request<boost::beast::http::string_body> req;
-
-            try {
-                // 1. 异步读取 HTTP Upgrade 请求
-                co_await boost::beast::http::async_read(webSocket.next_layer(), buffer, req, boost::asio::use_awaitable);
-
-                // 打印所有请求头
-                for (auto const& field : req) {
-                    LOG_INFO("  %s: %s",
-                        std::string(field.name_string()).c_str(),
-                        std::string(field.value()).c_str());
-                }
-
-                // 2. 打印请求目标 (客户端 handshake("/", ...) 中的路径)
-                // req.target() 返回 boost::beast::string_view
-                const std::string target(req.target());
-
-                // 3. 执行 WebSocket 服务端握手 (async_accept)
-                co_await webSocket.async_accept(req, boost::asio::use_awaitable);
-
-                setTcpKeepAlive(webSocket.next_layer());
-
-                boost::asio::co_spawn(ioContext, [self = shared_from_this()]() -> boost::asio::awaitable<void> {
-                    co_await self->registrationTimeout();
-                    }, boost::asio::detached);
-
-                buffer.consume(buffer.size());
-            }
-            catch (const boost::system::system_error& se) {
-                LOG_ERROR("WebRTCSignalServer WebSocket handshake failed! ERROR: %s", se.what());
-                // ... 错误处理 ...
-                destroy();
-            }
-        }
-
-        void WebRTCSignalSocket::setTcpKeepAlive(boost::asio::ip::tcp::socket& sock, int idle, int intvl, int probes)
-        {
-            int fd = sock.native_handle();
-
-            /* 1. 先打开 SO_KEEPALIVE 通用开关 */
-            int on = 1;
-            setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE,
-                reinterpret_cast<const char*>(&on), sizeof(on));
-
-#if defined(__linux__)
-            setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
-            setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &intvl, sizeof(intvl));
-            setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &probes, sizeof(probes));
-
-#elif defined(_WIN32)
-            /* Windows 用毫秒结构体 */
-            struct tcp_keepalive kalive {};
-            kalive.onoff = 1;
-            kalive.keepalivetime = idle * 1000;   // ms
-            kalive.keepaliveinterval = intvl * 1000;   // ms
-            DWORD bytes_returned = 0;
-            WSAIoctl(fd, SIO_KEEPALIVE_VALS,
-                &kalive, sizeof(kalive),
-                nullptr, 0, &bytes_returned, nullptr, nullptr);
-
-#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
-            /* macOS / BSD 用秒级 TCP_KEEPALIVE 等选项 */
-            setsockopt(fd, IPPROTO_TCP, TCP_KEEPALIVE, &idle, sizeof(idle));   // 同 Linux 的 IDLE
-            /* 间隔与次数在 BSD 上只有一个 TCP_KEEPINTVL，单位秒 */
-            setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &intvl, sizeof(intvl));
-            /* BSD 没有 KEEPCNT，用 TCP_KEEPALIVE 的初始值+间隔推算，效果相近 */
-#else
-#warning "Unsupported platform, TCP keep-alive parameters not tuned"
-#endif
-        }
-
-        // WebRTCSignalSocket.cpp
-
-        boost::asio::awaitable<void> WebRTCSignalSocket::registrationTimeout() {
-
-            using namespace std::chrono_literals;
-
-            // 1. 设置 10 秒超时
-            registrationTimer.expires_after(10s);
-
-            // 2. 异步等待计时器或被取消
-            boost::system::error_code ec;
-
-            co_await registrationTimer.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
-
-            // 3. 检查是否超时
-            if (ec == boost::asio::error::operation_aborted) {
-                // 计时器被取消 (说明在 10s 内完成了注册)
-                co_return;
-            }
-
-            // 4. 超时发生，且尚未注册，则关闭连接
-            if (!isRegistered.load()) {
-                LOG_WARNING("Rgister Timeout (10s): WebRTCSignalSocket not rigster，close socket.");
-                // 调用 stop() 会执行 closeSocket()
-                destroy();
-            }
-        }
-
-        void WebRTCSignalSocket::runEventLoop() {
-
-            boost::asio::co_spawn(ioContext, reviceCoroutine(), [self = shared_from_this()](std::exception_ptr p) {
-
-                if (p) {
-                    try {
-                        std::rethrow_exception(p);
-                    }
-                    catch (const std::runtime_error& e) {
-
-                        if (self->isRegistered && self->onDisConnectHandle) {
-
-                            self->onDisConnectHandle(self->accountId);
-
-                        }
-                        LOG_ERROR("WebRTCSignalSocket error: %s", e.what());
-                    }
-                }
-
-
-                });
-
-            boost::asio::co_spawn(ioContext, writerCoroutine(),boost::asio::detached);
-
-            webSocket.set_option(boost::beast::websocket::stream_base::timeout::suggested(
-                boost::beast::role_type::server));
-
-        }
-
-        void WebRTCSignalSocket::clear() {
-
-            if (isStop.exchange(true) == false) {
-                LOG_INFO("Stop connect...");
-                // 确保所有 IO 操作中断
-                closeSocket();
-            }
-        }
-
-        hope::quic::SocketType WebRTCSignalSocket::getType()
-        {
-            return hope::quic::SocketType::WebSocket;
-        }
-
-        // WebRTCSignalSocket.cpp
-
-        void WebRTCSignalSocket::closeSocket() {
-
-            boost::system::error_code ec;
-
-            webSocket.next_layer().cancel(ec);
-
-            if (ec) {
-                LOG_ERROR("WebRTCSignalSocket::closeSocket() can't cancel Socket: %s", ec.message().c_str());
-            }
-
-            registrationTimer.cancel();
-
-            // 3. 关闭 WebSocket
-            // 发送 WebSocket 关闭帧
-            if (webSocket.is_open()) {
-                try {
-                    // 使用同步 close，因为我们通常在协程外部或清理阶段调用此函数
-                    // 协程内部调用 close 通常需要 async_close
-                    webSocket.close(boost::beast::websocket::close_code::normal, ec);
-                }
-                catch (const std::exception& e) {
-                    // Beast::close 可能会抛出异常，捕获它
-                    LOG_ERROR("WebRTCSignalSocket::closeSocket() close WebSocket failed: %s", e.what());
-                }
-            }
-
-            // 4. 关闭底层 TCP Socket
-            if (webSocket.next_layer().is_open()) {
-                webSocket.next_layer().shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
-                if (ec && ec != boost::asio::error::not_connected) {
-                    // 忽略 not_connected 错误
-                }
-                webSocket.next_layer().close(ec);
-                if (ec) {
-                    LOG_ERROR("WebRTCSignalSocket::closeSocket() close Tcp Socket failed: %s", ec.message().c_str());
-                }
-            }
-
-            // 5. 关闭 writerChannel
-            writerChannel.close(); // 确保 writerCoroutine 退出等待
-
-
-            LOG_INFO("WebRTCSignalSocket is close");
-        }
-
-        boost::asio::awaitable<void> WebRTCSignalSocket::reviceCoroutine() {
-
-            while (!isStop) {
-
-                boost::beast::flat_buffer buffer;
-
-                co_await webSocket.async_read(buffer, boost::asio::use_awaitable);
-
-                std::string dataStr = boost::beast::buffers_to_string(buffer.data());
-
-                buffer.consume(buffer.size());
-
-                boost::json::object json;
-
-                try {
-
-                    json = boost::json::parse(dataStr).as_object();
-               
-                }
-                catch (std::exception& e) {
-
-                    LOG_ERROR("hope::socket::WebRTCSignalSocket reviceCoroutine  Pase Json Error: %s", e.what());
-
-                    continue;
-                }
-
-                std::shared_ptr< hope::quic::MsquicData > data = std::make_shared < hope::quic::MsquicData > (std::move(json), shared_from_this(), msquicManager);
-
-                msquicManager->getMsquicLogicSystem()->postTaskAsync(data);
-
-            }
-
-        }
-
-        boost::asio::awaitable<void> WebRTCSignalSocket::writerCoroutine() {
-
-            for (;;) {
-
-                std::string str;
-
-                while (writerQueues.try_dequeue(str)) {
-
-                    co_await webSocket.async_write(boost::asio::buffer(str), boost::asio::use_awaitable);
-
-                }
-
-                if (!isStop && !isSuppendWrite.exchange(true)) {
-
-                    co_await writerChannel.async_receive(boost::asio::use_awaitable);
-
-                }
-                else {
-
-                    std::string str;
-
-                    while (writerQueues.try_dequeue(str)) {
-
-                        co_await webSocket.async_write(boost::asio::buffer(str), boost::asio::use_awaitable);
-
-                    }
-
-                    co_return;
-                }
-
-            }
-
-            co_return;
-
-        }
-
-        void WebRTCSignalSocket::writeAsync(unsigned char* data, size_t size)
-        {
-    
-            writeAsync(std::string(reinterpret_cast<const char*>(data), size));
-           
-            if (data) {
-            
-                delete[] data;
-
-                data = nullptr;
-
-            }
-        }
-
-        void WebRTCSignalSocket::writeAsync(std::string str) {
-
-            writerQueues.enqueue(str);
-
-            if (isSuppendWrite.exchange(false)) {
-                writerChannel.async_send(boost::system::error_code(), [](boost::system::error_code ec) {});
-            }
-
-        }
-
-        void WebRTCSignalSocket::setOnDisConnectHandle(std::function<void(std::string)> handle)
-        {
-            this->onDisConnectHandle = handle;
-        }
-
-
-        void WebRTCSignalSocket::setAccountId(const std::string& accountId) { this->accountId = accountId; }
-
-        std::string WebRTCSignalSocket::getAccountId() { return  this->accountId; }
-
-        void WebRTCSignalSocket::setRegistered(bool isRegistered) { this->isRegistered = isRegistered; }
-        
-
-    }
-
+#include "WebRTCSignalSocket.h"
+#include "MsquicManager.h"
+#include "MsquicData.h"
+#include "ConfigManager.h"
+#include "MsquicMetrics.h"
+
+#include "Utils.h"
+
+namespace hope {
+
+    namespace quic {
+
+        WebRTCSignalSocket::WebRTCSignalSocket(boost::asio::io_context& ioContext, hope::quic::MsquicManager * msquicManager)
+            : ioContext(ioContext)
+            , writerChannel(ioContext, 1)
+            , resolver(ioContext)
+            , registrationTimer(ioContext)
+            , webSocket(ioContext)
+            , readBuffer(ConfigManager::Instance().GetInt("WebSocket.maxMessageSize", 8 * 1024 * 1024))
+            , channelIndex(channelIndex)
+            , msquicManager(msquicManager) {
+        }
+
+        WebRTCSignalSocket::~WebRTCSignalSocket() {
+            clear();
+        }
+
+        boost::asio::ip::tcp::socket& WebRTCSignalSocket::getSocket() {
+
+            return webSocket.next_layer().next_layer();
+
+        }
+
+        void WebRTCSignalSocket::destroy() { // 统一销毁入口
+            bool expected = false;
+            if (isDeleted.compare_exchange_strong(expected, true)) {
+                this->closeSocket();
+            }
+        }
+
+        boost::asio::io_context& WebRTCSignalSocket::getIoCompletionPorts() {
+            return ioContext;
+        }
+
+        WebSocketStream& WebRTCSignalSocket::getWebSocket() {
+
+            return webSocket;
+
+        }
+
+        boost::asio::awaitable<void> WebRTCSignalSocket::handShake() {
+            // 假设 getSocket() 已经通过 acceptor.async_accept 连接成功
+
+            boost::beast::flat_buffer buffer;
+            boost::beast::http::request<boost::beast::http::string_body> req;
+
+            try {
+                // 1. 异步读取 HTTP Upgrade 请求
+                co_await boost::beast::http::async_read(getSocket(), buffer, req, boost::asio::use_awaitable);
+
+                // 打印所有请求头
+                for (auto const& field : req) {
+                    LOG_INFO("  %s: %s",
+                        std::string(field.name_string()).c_str(),
+                        std::string(field.value()).c_str());
+                }
+
+                // 2. 打印请求目标 (客户端 handshake("/", ...) 中的路径)
+                // req.target() 返回 boost::beast::string_view
+                const std::string target(req.target());
+
+                // 客户端请求时协商 permessage-deflate，小消息不压缩
+                boost::beast::websocket::permessage_deflate deflate;
+
+                deflate.server_enable = ConfigManager::Instance().GetBool("WebSocket.permessageDeflate", true);
+
+                deflate.compLevel = ConfigManager::Instance().GetInt("WebSocket.deflateLevel", 3);
+
+                deflate.memLevel = 4;
+
+                deflate.msg_size_threshold = ConfigManager::Instance().GetInt("WebSocket.deflateThreshold", 1024);
+
+                webSocket.set_option(deflate);
+
+                // 3. 执行 WebSocket 服务端握手 (async_accept)
+                co_await webSocket.async_accept(req, boost::asio::use_awaitable);
+
+                setTcpKeepAlive(getSocket());
+
+                // 大批次走 MSG_ZEROCOPY，默认关闭；锁页和完成通知的开销只在几十 KB 以上才划算
+                if (ConfigManager::Instance().GetBool("WebSocket.zeroCopy", false)) {
+
+                    size_t threshold = ConfigManager::Instance().GetInt("WebSocket.zeroCopyThreshold", 64 * 1024);
+
+                    if (!webSocket.next_layer().enableZeroCopy(threshold)) {
+                        LOG_WARNING("SO_ZEROCOPY unavailable, WebSocket sends fall back to copying");
+                    }
+                }
+
+                boost::asio::co_spawn(ioContext, [self = shared_from_this()]() -> boost::asio::awaitable<void> {
+                    co_await self->registrationTimeout();
+                    }, boost::asio::detached);
+
+                buffer.consume(buffer.size());
+            }
+            catch (const boost::system::system_error& se) {
+                LOG_ERROR("WebRTCSignalServer WebSocket handshake failed! ERROR: %s", se.what());
+                // ... 错误处理 ...
+                destroy();
+            }
+        }
+
+        void WebRTCSignalSocket::setTcpKeepAlive(boost::asio::ip::tcp::socket& sock, int idle, int intvl, int probes)
+        {
+            int fd = sock.native_handle();
+
+            /* 1. 先打开 SO_KEEPALIVE 通用开关 */
+            int on = 1;
+            setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE,
+                reinterpret_cast<const char*>(&on), sizeof(on));
+
+#if defined(__linux__)
+            setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+            setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &intvl, sizeof(intvl));
+            setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &probes, sizeof(probes));
+
+#elif defined(_WIN32)
+            /* Windows 用毫秒结构体 */
+            struct tcp_keepalive kalive {};
+            kalive.onoff = 1;
+            kalive.keepalivetime = idle * 1000;   // ms
+            kalive.keepaliveinterval = intvl * 1000;   // ms
+            DWORD bytes_returned = 0;
+            WSAIoctl(fd, SIO_KEEPALIVE_VALS,
+                &kalive, sizeof(kalive),
+                nullptr, 0, &bytes_returned, nullptr, nullptr);
+
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+            /* macOS / BSD 用秒级 TCP_KEEPALIVE 等选项 */
+            setsockopt(fd, IPPROTO_TCP, TCP_KEEPALIVE, &idle, sizeof(idle));   // 同 Linux 的 IDLE
+            /* 间隔与次数在 BSD 上只有一个 TCP_KEEPINTVL，单位秒 */
+            setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &intvl, sizeof(intvl));
+            /* BSD 没有 KEEPCNT，用 TCP_KEEPALIVE 的初始值+间隔推算，效果相近 */
+#else
+#warning "Unsupported platform, TCP keep-alive parameters not tuned"
+#endif
+        }
+
+        // WebRTCSignalSocket.cpp
+
+        boost::asio::awaitable<void> WebRTCSignalSocket::registrationTimeout() {
+
+            using namespace std::chrono_literals;
+
+            // 1. 设置 10 秒超时
+            registrationTimer.expires_after(10s);
+
+            // 2. 异步等待计时器或被取消
+            boost::system::error_code ec;
+
+            co_await registrationTimer.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+
+            // 3. 检查是否超时
+            if (ec == boost::asio::error::operation_aborted) {
+                // 计时器被取消 (说明在 10s 内完成了注册)
+                co_return;
+            }
+
+            // 4. 超时发生，且尚未注册，则关闭连接
+            if (!isRegistered.load()) {
+                LOG_WARNING("Rgister Timeout (10s): WebRTCSignalSocket not rigster，close socket.");
+                // 调用 stop() 会执行 closeSocket()
+                destroy();
+            }
+        }
+
+        void WebRTCSignalSocket::runEventLoop() {
+
+            boost::asio::co_spawn(ioContext, reviceCoroutine(), [self = shared_from_this()](std::exception_ptr p) {
+
+                if (p) {
+                    try {
+                        std::rethrow_exception(p);
+                    }
+                    catch (const std::runtime_error& e) {
+
+                        if (self->isRegistered && self->onDisConnectHandle) {
+
+                            self->onDisConnectHandle(self->accountId);
+
+                        }
+                        LOG_ERROR("WebRTCSignalSocket error: %s", e.what());
+                    }
+                }
+
+
+                });
+
+            boost::asio::co_spawn(ioContext, writerCoroutine(),boost::asio::detached);
+
+            webSocket.set_option(boost::beast::websocket::stream_base::timeout::suggested(
+                boost::beast::role_type::server));
+
+            // 超过上限的消息直接读失败，和读缓冲区的上限一致
+            webSocket.read_message_max(readBuffer.max_size());
+
+        }
+
+        void WebRTCSignalSocket::clear() {
+
+            if (isStop.exchange(true) == false) {
+                LOG_INFO("Stop connect...");
+                // 确保所有 IO 操作中断
+                closeSocket();
+            }
+        }
+
+        hope::quic::SocketType WebRTCSignalSocket::getType()
+        {
+            return hope::quic::SocketType::WebSocket;
+        }
+
+        hope::quic::WireProtocol WebRTCSignalSocket::getProtocol()
+        {
+            return hope::quic::WireProtocol::Json;
+        }
+
+        // WebSocket 帧自带长度，正文即消息
+        size_t WebRTCSignalSocket::frameHeaderSize()
+        {
+            return 0;
+        }
+
+        void WebRTCSignalSocket::encodeFrameHeader(unsigned char* header, size_t bodyLength, int64_t requestType, int64_t state)
+        {
+        }
+
+        // WebRTCSignalSocket.cpp
+
+        void WebRTCSignalSocket::closeSocket() {
+
+            boost::system::error_code ec;
+
+            getSocket().cancel(ec);
+
+            if (ec) {
+                LOG_ERROR("WebRTCSignalSocket::closeSocket() can't cancel Socket: %s", ec.message().c_str());
+            }
+
+            registrationTimer.cancel();
+
+            // 3. 关闭 WebSocket
+            // 发送 WebSocket 关闭帧
+            if (webSocket.is_open()) {
+                try {
+                    // 使用同步 close，因为我们通常在协程外部或清理阶段调用此函数
+                    // 协程内部调用 close 通常需要 async_close
+                    webSocket.close(boost::beast::websocket::close_code::normal, ec);
+                }
+                catch (const std::exception& e) {
+                    // Beast::close 可能会抛出异常，捕获它
+                    LOG_ERROR("WebRTCSignalSocket::closeSocket() close WebSocket failed: %s", e.what());
+                }
+            }
+
+            // 4. 关闭底层 TCP Socket
+            if (getSocket().is_open()) {
+                getSocket().shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+                if (ec && ec != boost::asio::error::not_connected) {
+                    // 忽略 not_connected 错误
+                }
+                getSocket().close(ec);
+                if (ec) {
+                    LOG_ERROR("WebRTCSignalSocket::closeSocket() close Tcp Socket failed: %s", ec.message().c_str());
+                }
+            }
+
+            // 5. 关闭 writerChannel
+            writerChannel.close(); // 确保 writerCoroutine 退出等待
+
+
+            LOG_INFO("WebRTCSignalSocket is close");
+        }
+
+        boost::asio::awaitable<void> WebRTCSignalSocket::reviceCoroutine() {
+
+            while (!isStop) {
+
+                co_await webSocket.async_read(readBuffer, boost::asio::use_awaitable);
+
+                std::shared_ptr< hope::quic::MsquicData > data = msquicDataPool->acquire(shared_from_this(), msquicManager);
+
+                boost::json::error_code ec;
+
+                // 直接从读缓冲区的可读区域解析，loadJson 只拷贝一次进 MsquicData 复用的 payload
+                bool loaded = data->loadJson(std::string_view(static_cast<const char*>(readBuffer.data().data()), readBuffer.size()), ec);
+
+                readBuffer.consume(readBuffer.size());
+
+                // 大消息之后释放整块，常驻的只有小缓冲区
+                if (readBuffer.capacity() > READ_BUFFER_RETAIN_CAPACITY) {
+
+                    readBuffer.shrink_to_fit();
+
+                }
+
+                if (!loaded) {
+
+                    LOG_ERROR("hope::socket::WebRTCSignalSocket reviceCoroutine  Pase Json Error: %s", ec.message().c_str());
+
+                    continue;
+                }
+
+                // WebSocket 上没有 DATAGRAM 和批量传输
+                if (!hope::quic::isStreamRequestType(data->requestType)) {
+
+                    LOG_WARNING("Request type %lld not allowed on WebSocket, dropped", static_cast<long long>(data->requestType));
+
+                    continue;
+                }
+
+                // 逻辑线程处理完、MsquicData 回收时归还
+                if (!memoryBudget.tryCharge(data->payload.size())) {
+
+                    hope::utils::MsquicMetrics::add(hope::utils::MsquicMetrics::instance().memoryBudgetExceeded);
+
+                    if (hope::utils::MsquicMemoryBudget::action() == hope::utils::MemoryBudgetAction::Disconnect) {
+
+                        LOG_WARNING("Pending task over memory budget (%zu / %zu bytes), disconnect %s", memoryBudget.used(), memoryBudget.limit(), accountId.c_str());
+
+                        destroy();
+                    }
+
+                    continue;
+                }
+
+                data->chargeMemory(&memoryBudget, data->payload.size());
+
+                msquicManager->getMsquicLogicSystem()->postTaskAsync(data);
+
+            }
+
+        }
+
+        boost::asio::awaitable<void> WebRTCSignalSocket::writerCoroutine() {
+
+            for (;;) {
+
+                co_await writeBatch();
+
+                if (!isStop && !isSuppendWrite.exchange(true)) {
+
+                    co_await writerChannel.async_receive(boost::asio::use_awaitable);
+
+                }
+                else {
+
+                    co_await writeBatch();
+
+                    co_return;
+                }
+
+            }
+
+            co_return;
+
+        }
+
+        boost::asio::awaitable<void> WebRTCSignalSocket::writeBatch() {
+
+            // 不论怎样离开本批（写失败、协程被销毁）都 uncork，并归还还没写出的消息占的预算
+            struct BatchGuard {
+
+                WebRTCSignalSocket& socket;
+
+                WriterMessage* messages;
+
+                size_t count;
+
+                size_t written = 0;
+
+                ~BatchGuard() {
+
+                    for (size_t i = written; i < count; ++i) {
+
+                        messages[i].data.reset();
+
+                        socket.memoryBudget.release(messages[i].size);
+                    }
+
+                    socket.webSocket.next_layer().uncork();
+                }
+
+            };
+
+            WriterMessage messages[WRITER_BATCH_SIZE];
+
+            size_t count = 0;
+
+            boost::system::error_code ec;
+
+            // 一次取出积压，beast 逐条组帧写进合并缓冲区，uncork 时一次系统调用发出整批
+            while ((count = writerQueues.try_dequeue_bulk(messages, WRITER_BATCH_SIZE)) > 0) {
+
+                webSocket.next_layer().cork();
+
+                BatchGuard guard{ *this, messages, count };
+
+                for (; guard.written < count; ++guard.written) {
+
+                    WriterMessage& message = messages[guard.written];
+
+                    co_await webSocket.async_write(boost::asio::buffer(message.data.get(), message.size), boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+
+                    // 对端已断开，剩下的由 guard 归还，队列里的随会话一起释放
+                    if (ec) {
+
+                        LOG_WARNING("WebRTCSignalSocket write failed: %s", ec.message().c_str());
+
+                        co_return;
+                    }
+
+                    message.data.reset();
+
+                    memoryBudget.release(message.size);
+
+                }
+
+            }
+
+        }
+
+        void WebRTCSignalSocket::writeAsync(unsigned char* data, size_t size)
+        {
+
+            // 记到写出为止；连接关闭时没写出的部分随会话预算一起归还
+            if (!memoryBudget.tryCharge(size)) {
+
+                hope::utils::MsquicMetrics::add(hope::utils::MsquicMetrics::instance().memoryBudgetExceeded);
+
+                hope::utils::MsquicSharedBuffer::release(data);
+
+                if (hope::utils::MsquicMemoryBudget::action() == hope::utils::MemoryBudgetAction::Disconnect) {
+
+                    LOG_WARNING("Write queue over memory budget (%zu + %zu / %zu bytes), disconnect %s", memoryBudget.used(), size, memoryBudget.limit(), accountId.c_str());
+
+                    boost::asio::post(ioContext, [self = shared_from_this()]() {
+                        self->destroy();
+                        });
+                }
+
+                return;
+            }
+
+            writerQueues.enqueue(WriterMessage{ std::unique_ptr<unsigned char, hope::utils::MsquicSharedBufferDeleter>(data), size });
+
+            if (isSuppendWrite.exchange(false)) {
+                writerChannel.async_send(boost::system::error_code(), [](boost::system::error_code ec) {});
+            }
+
+        }
+
+        bool WebRTCSignalSocket::tryWriteAsync(unsigned char* data, size_t size)
+        {
+            // 其他线程上的判断是近似的，最终仍由 writeAsync 兜底
+            if (hope::utils::MsquicMemoryBudget::action() == hope::utils::MemoryBudgetAction::Reject && memoryBudget.wouldExceed(size)) {
+
+                hope::utils::MsquicMetrics::add(hope::utils::MsquicMetrics::instance().memoryBudgetExceeded);
+
+                hope::utils::MsquicSharedBuffer::release(data);
+
+                return false;
+            }
+
+            writeAsync(data, size);
+
+            return true;
+        }
+
+        void WebRTCSignalSocket::setOnDisConnectHandle(std::function<void(std::string)> handle)
+        {
+            this->onDisConnectHandle = handle;
+        }
+
+
+        void WebRTCSignalSocket::setAccountId(const std::string& accountId) { this->accountId = accountId; }
+
+        std::string WebRTCSignalSocket::getAccountId() { return  this->accountId; }
+
+        void WebRTCSignalSocket::setRegistered(bool isRegistered) { this->isRegistered = isRegistered; }
+        
+
+    }
+
 }
\ No newline at end of file
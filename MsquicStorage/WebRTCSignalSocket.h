@@ -1,108 +1,145 @@
-#pragma once
-#include <memory>
-#include <boost/asio.hpp>
-#include <boost/beast.hpp>
-#include <boost/asio/experimental/concurrent_channel.hpp>
-#include <boost/json.hpp>
-
-#include "MsquicSocketInterface.h"
-
-#include "concurrentqueue.h"
-
-
-namespace hope {
-
-	namespace quic {
-	
-		class MsquicManager;
-
-		class WebRTCSignalSocket : public hope::quic::MsquicSocketInterface,public std::enable_shared_from_this<WebRTCSignalSocket>
-		{
-		public:
-
-			WebRTCSignalSocket(boost::asio::io_context& ioContext, hope::quic::MsquicManager* msquicServer);
-
-			~WebRTCSignalSocket();
-
-			boost::asio::ip::tcp::socket& getSocket();
-
-			boost::beast::websocket::stream<boost::asio::ip::tcp::socket>& getWebSocket();
-
-			boost::asio::awaitable<void> handShake();
-
-			boost::asio::io_context& getIoCompletionPorts();
-
-			void runEventLoop();
-
-			void clear();
-
-			virtual void writeAsync(unsigned char* data, size_t size);
-
-			void writeAsync(std::string str);
-
-			void setAccountId(const std::string& accountId);
-
-			std::string getAccountId();
-
-			void setRegistered(bool isRegistered);
-
-			void destroy();
-
-			hope::quic::SocketType getType();
-
-			std::string getGameType();
-
-		public:
-
-			void setOnDisConnectHandle(std::function<void(std::string)> handle);
-
-		private:
-
-			void closeSocket();
-
-			boost::asio::awaitable<void> registrationTimeout();
-
-			boost::asio::awaitable<void> reviceCoroutine();
-
-			boost::asio::awaitable<void> writerCoroutine();
-
-			void setTcpKeepAlive(boost::asio::ip::tcp::socket& socket,int idle = 0, int intvl = 3, int probes = 3);
-
-		private:
-
-			hope::quic::MsquicManager* msquicManager;
-
-			boost::asio::io_context& ioContext;
-
-			boost::beast::websocket::stream<boost::asio::ip::tcp::socket> webSocket;
-
-			boost::asio::ip::tcp::resolver resolver;
-
-			moodycamel::ConcurrentQueue<std::string> writerQueues{ 1 };
-
-			boost::asio::experimental::concurrent_channel<void(boost::system::error_code)> writerChannel;
-
-			std::atomic<bool> isStop{ false };
-
-			std::string accountId;
-
-			std::atomic<bool> isSuppendWrite{ false };
-
-			boost::asio::steady_timer registrationTimer; // 计时器成员
-
-			std::atomic<bool> isRegistered{ false }; // 新增：注册状态标志
-
-			int channelIndex;
-
-			std::atomic<bool> isHandleDisConnect{ false };
-
-			std::atomic<bool> isDeleted{ false };
-
-		private:
-
-			std::function<void(std::string)> onDisConnectHandle;
-		};
-
-	}
-
-}
+#pragma once
+#include <memory>
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <boost/asio/experimental/concurrent_channel.hpp>
+#include <boost/json.hpp>
+
+#include "MsquicSocketInterface.h"
+#include "MsquicData.h"
+#include "MsquicCoalescingStream.h"
+
+#include "concurrentqueue.h"
+
+
+namespace hope {
+
+	namespace quic {
+	
+		class MsquicManager;
+
+		// 下层包一层合并写，一批消息一次系统调用
+		using WebSocketStream = boost::beast::websocket::stream<MsquicCoalescingStream<boost::asio::ip::tcp::socket>>;
+
+		class WebRTCSignalSocket : public hope::quic::MsquicSocketInterface,public std::enable_shared_from_this<WebRTCSignalSocket>
+		{
+		public:
+
+			WebRTCSignalSocket(boost::asio::io_context& ioContext, hope::quic::MsquicManager* msquicServer);
+
+			~WebRTCSignalSocket();
+
+			boost::asio::ip::tcp::socket& getSocket();
+
+			WebSocketStream& getWebSocket();
+
+			boost::asio::awaitable<void> handShake();
+
+			boost::asio::io_context& getIoCompletionPorts();
+
+			void runEventLoop();
+
+			void clear();
+
+			using MsquicSocketInterface::writeAsync;
+
+			virtual void writeAsync(unsigned char* data, size_t size);
+
+			using MsquicSocketInterface::tryWriteAsync;
+
+			// 预算策略为拒收且写入队列超出会话预算时返回 false
+			virtual bool tryWriteAsync(unsigned char* data, size_t size);
+
+			void setAccountId(const std::string& accountId);
+
+			std::string getAccountId();
+
+			void setRegistered(bool isRegistered);
+
+			void destroy();
+
+			hope::quic::SocketType getType();
+
+			hope::quic::WireProtocol getProtocol();
+
+			size_t frameHeaderSize();
+
+			void encodeFrameHeader(unsigned char* header, size_t bodyLength, int64_t requestType, int64_t state);
+
+			std::string getGameType();
+
+		public:
+
+			void setOnDisConnectHandle(std::function<void(std::string)> handle);
+
+		private:
+
+			// 出站消息，持有生产者缓冲区的一份引用，不再拷贝成 std::string
+			struct WriterMessage {
+
+				std::unique_ptr<unsigned char, hope::utils::MsquicSharedBufferDeleter> data;
+
+				size_t size = 0;
+
+			};
+
+			void closeSocket();
+
+			boost::asio::awaitable<void> registrationTimeout();
+
+			boost::asio::awaitable<void> reviceCoroutine();
+
+			boost::asio::awaitable<void> writerCoroutine();
+
+			boost::asio::awaitable<void> writeBatch();
+
+			static constexpr size_t WRITER_BATCH_SIZE = 64;
+
+			void setTcpKeepAlive(boost::asio::ip::tcp::socket& socket,int idle = 0, int intvl = 3, int probes = 3);
+
+		private:
+
+			hope::quic::MsquicManager* msquicManager;
+
+			boost::asio::io_context& ioContext;
+
+			WebSocketStream webSocket;
+
+			boost::asio::ip::tcp::resolver resolver;
+
+			// 每个连接复用的读缓冲区，上限为 WebSocket.maxMessageSize
+			boost::beast::flat_buffer readBuffer;
+
+			// 读完后容量超过该值就释放，空闲连接只保留小缓冲区
+			static constexpr size_t READ_BUFFER_RETAIN_CAPACITY = 16 * 1024;
+
+			moodycamel::ConcurrentQueue<WriterMessage> writerQueues{ 1 };
+
+			boost::asio::experimental::concurrent_channel<void(boost::system::error_code)> writerChannel;
+
+			std::shared_ptr<hope::quic::MsquicDataPool> msquicDataPool = std::make_shared<hope::quic::MsquicDataPool>();
+
+			std::atomic<bool> isStop{ false };
+
+			std::string accountId;
+
+			std::atomic<bool> isSuppendWrite{ false };
+
+			boost::asio::steady_timer registrationTimer; // 计时器成员
+
+			std::atomic<bool> isRegistered{ false }; // 新增：注册状态标志
+
+			int channelIndex;
+
+			std::atomic<bool> isHandleDisConnect{ false };
+
+			std::atomic<bool> isDeleted{ false };
+
+		private:
+
+			std::function<void(std::string)> onDisConnectHandle;
+		};
+
+	}
+
+}
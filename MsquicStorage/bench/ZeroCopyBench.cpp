@@ -0,0 +1,258 @@
+// MsquicCoalescingStream 零拷贝阈值的基准：按批次大小比较开关 MSG_ZEROCOPY 时发送线程的 CPU 时间
+// 只支持 Linux，不参与服务器构建，单独编译：
+//   g++ -std=c++20 -O2 -I.. ZeroCopyBench.cpp -o ZeroCopyBench -lpthread
+// 用法：
+//   ZeroCopyBench [totalMB]                       回环，发送端和接收端在同一进程
+//   ZeroCopyBench --listen port                   接收端
+//   ZeroCopyBench --connect host port [totalMB]   发送端，跨主机时才能看到真正的零拷贝
+// 回环上内核总是退化为拷贝（copied 列等于批次数），测到的只是锁页和完成通知的额外开销
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "../MsquicCoalescingStream.h"
+
+using boost::asio::ip::tcp;
+
+using Stream = hope::quic::MsquicCoalescingStream<tcp::socket>;
+
+namespace {
+
+    // 每批发完等接收端回一个字节，保证内核看到的每次发送正好是一批
+    constexpr size_t BATCH_SIZES[] = { 4 * 1024, 16 * 1024, 32 * 1024, 64 * 1024, 128 * 1024, 256 * 1024, 1024 * 1024 };
+
+    double threadCpuSeconds() {
+
+        rusage usage{};
+
+        getrusage(RUSAGE_THREAD, &usage);
+
+        return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    }
+
+    // 接收端：每批先读 8 字节长度，读满后回一个确认字节，长度为 0 表示连接结束
+    void receive(tcp::socket socket) {
+
+        std::vector<char> buffer(1024 * 1024);
+
+        boost::system::error_code ec;
+
+        for (;;) {
+
+            uint64_t batch = 0;
+
+            boost::asio::read(socket, boost::asio::buffer(&batch, sizeof(batch)), ec);
+
+            if (ec || batch == 0) {
+                return;
+            }
+
+            size_t received = 0;
+
+            while (received < batch) {
+
+                size_t n = socket.read_some(boost::asio::buffer(buffer.data(), std::min<size_t>(buffer.size(), batch - received)), ec);
+
+                if (ec) {
+                    return;
+                }
+
+                received += n;
+            }
+
+            char ack = 1;
+
+            boost::asio::write(socket, boost::asio::buffer(&ack, 1), ec);
+
+            if (ec) {
+                return;
+            }
+        }
+    }
+
+    struct Result {
+
+        double cpuSeconds = 0;
+
+        double wallSeconds = 0;
+
+        uint64_t copied = 0;
+
+    };
+
+    // 按 batch 分批发送 totalBytes，返回发送线程的 CPU 时间
+    Result send(boost::asio::io_context& ioContext, Stream& stream, size_t batch, size_t totalBytes) {
+
+        hope::utils::MsquicMetrics& metrics = hope::utils::MsquicMetrics::instance();
+
+        uint64_t copiedBefore = metrics.load(metrics.zeroCopyCopied);
+
+        std::vector<char> payload(batch, 'x');
+
+        uint64_t header = batch;
+
+        size_t rounds = std::max<size_t>(1, totalBytes / batch);
+
+        size_t sent = 0;
+
+        char ack = 0;
+
+        double cpuStart = threadCpuSeconds();
+
+        auto wallStart = std::chrono::steady_clock::now();
+
+        // 批次长度和数据分两次写，cork 住一起发出，内核看到的是一次 batch + 8 字节的发送
+        std::function<void()> next = [&]() {
+
+            stream.cork();
+
+            stream.async_write_some(boost::asio::buffer(&header, sizeof(header)), [](boost::system::error_code, size_t) {});
+
+            stream.async_write_some(boost::asio::buffer(payload), [](boost::system::error_code, size_t) {});
+
+            stream.uncork();
+
+            stream.async_read_some(boost::asio::buffer(&ack, 1), [&](boost::system::error_code ec, size_t) {
+
+                if (ec) {
+                    std::fprintf(stderr, "read ack: %s\n", ec.message().c_str());
+                    return;
+                }
+
+                if (++sent < rounds) {
+                    next();
+                }
+            });
+        };
+
+        next();
+
+        ioContext.restart();
+
+        ioContext.run();
+
+        // 等最后几批的完成通知，零拷贝缓冲区释放之后再计时结束
+        ioContext.restart();
+
+        ioContext.run_for(std::chrono::milliseconds(50));
+
+        Result result;
+
+        result.cpuSeconds = threadCpuSeconds() - cpuStart;
+
+        result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+        result.copied = metrics.load(metrics.zeroCopyCopied) - copiedBefore;
+
+        return result;
+    }
+
+    void runSender(tcp::endpoint endpoint, size_t totalBytes) {
+
+        std::printf("%10s %14s %16s %10s %12s\n", "batch", "copy cpu(s)", "zerocopy cpu(s)", "saving", "copied");
+
+        for (size_t batch : BATCH_SIZES) {
+
+            Result results[2];
+
+            for (int zeroCopy = 0; zeroCopy < 2; ++zeroCopy) {
+
+                boost::asio::io_context ioContext;
+
+                Stream stream(ioContext);
+
+                stream.next_layer().connect(endpoint);
+
+                stream.next_layer().set_option(tcp::no_delay(true));
+
+                if (zeroCopy && !stream.enableZeroCopy(batch)) {
+                    std::fprintf(stderr, "SO_ZEROCOPY unavailable\n");
+                    std::exit(1);
+                }
+
+                results[zeroCopy] = send(ioContext, stream, batch, totalBytes);
+
+                uint64_t end = 0;
+
+                boost::asio::write(stream.next_layer(), boost::asio::buffer(&end, sizeof(end)));
+            }
+
+            double saving = 1.0 - results[1].cpuSeconds / results[0].cpuSeconds;
+
+            std::printf("%10zu %14.3f %16.3f %9.1f%% %12llu\n", batch, results[0].cpuSeconds, results[1].cpuSeconds, saving * 100,
+                static_cast<unsigned long long>(results[1].copied));
+        }
+    }
+
+}
+
+int main(int argc, char** argv) {
+
+    size_t totalMB = 1024;
+
+    if (argc >= 3 && std::strcmp(argv[1], "--listen") == 0) {
+
+        boost::asio::io_context ioContext;
+
+        tcp::acceptor acceptor(ioContext, tcp::endpoint(tcp::v4(), static_cast<unsigned short>(std::atoi(argv[2]))));
+
+        for (;;) {
+            receive(acceptor.accept());
+        }
+    }
+
+    if (argc >= 4 && std::strcmp(argv[1], "--connect") == 0) {
+
+        if (argc >= 5) {
+            totalMB = std::strtoull(argv[4], nullptr, 10);
+        }
+
+        boost::asio::io_context resolverContext;
+
+        tcp::resolver resolver(resolverContext);
+
+        tcp::endpoint endpoint = *resolver.resolve(argv[2], argv[3]).begin();
+
+        runSender(endpoint, totalMB * 1024 * 1024);
+
+        return 0;
+    }
+
+    if (argc >= 2) {
+        totalMB = std::strtoull(argv[1], nullptr, 10);
+    }
+
+    // 回环：接收端在单独线程上逐个接受连接
+    boost::asio::io_context acceptorContext;
+
+    tcp::acceptor acceptor(acceptorContext, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+
+    std::thread receiver([&acceptor]() {
+        for (;;) {
+            boost::system::error_code ec;
+
+            tcp::socket socket = acceptor.accept(ec);
+
+            if (ec) {
+                return;
+            }
+
+            receive(std::move(socket));
+        }
+    });
+
+    runSender(acceptor.local_endpoint(), totalMB * 1024 * 1024);
+
+    acceptor.close();
+
+    receiver.detach();
+
+    return 0;
+}
@@ -1,70 +1,76 @@
-#include <iostream>
-#include <string>
-#include <boost/asio.hpp>
-
-#include "MsquicServer.h"
-#include "MsquicMysqlManagerPools.h"
-#include "ConfigManager.h"
-
-#include "Utils.h"
-
-int main() {
-
-#ifdef _WIN32
-
-    SetConsoleOutputCP(CP_UTF8);
-
-    SetConsoleCP(CP_UTF8);
-#endif
-
-    initLogger();
-
-    setConsoleOutputLevels(0, 1, 1, 0);
-
-    ConfigManager::Instance().Load("config.ini", ConfigManager::Format::Ini);
-
-    boost::asio::io_context ioContext;
-
-    size_t msquicStoragePort = ConfigManager::Instance().GetInt("MsquicStorage.port");
-
-    size_t webSocketPort = ConfigManager::Instance().GetInt("WebSocket.port");
-
-    std::unique_ptr<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> work = std::make_unique<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>>(boost::asio::make_work_guard(ioContext));
-
-    hope::quic::MsquicServer msquicServer(ioContext,msquicStoragePort, webSocketPort);
-
-    hope::mysql::MsquicMysqlManagerPools::getInstance();
-
-    if (!msquicServer.initialize()){
-    
-        LOG_ERROR("hope::quic::MsquicServer::initialize Failed");
-
-        return -1;
-
-    }
-
-    if (!msquicServer.RunEventLoop()) {
-    
-        LOG_ERROR("hope::quic::MsquicServer::RunEventLoop Failed");
-
-        return -1;
-
-    }
-
-    boost::asio::signal_set signals(ioContext, SIGINT, SIGTERM);
-
-    signals.async_wait([&ioContext, &msquicServer, &work](const boost::system::error_code& error, int signal) {
-
-        msquicServer.shutDown();
-
-        work.reset();
-
-        ioContext.stop();
-
-        });
-
-    ioContext.run();
-
-    return 0;
-
+#include <iostream>
+#include <string>
+#include <boost/asio.hpp>
+
+#include "MsquicServer.h"
+#include "MsquicMysqlManagerPools.h"
+#include "ConfigManager.h"
+
+#include "Utils.h"
+
+int main() {
+
+#ifdef _WIN32
+
+    SetConsoleOutputCP(CP_UTF8);
+
+    SetConsoleCP(CP_UTF8);
+#endif
+
+    setConsoleOutputLevels(0, 1, 1, 0);
+
+    ConfigManager::Instance().Load("config.ini", ConfigManager::Format::Ini);
+
+    setLogRotation(static_cast<size_t>(ConfigManager::Instance().GetInt("Log.maxFileSizeMB", 100)) * 1024 * 1024, ConfigManager::Instance().GetInt("Log.rotateHours", 24) * 3600);
+
+    setLogBufferSize(static_cast<size_t>(ConfigManager::Instance().GetInt("Log.bufferKB", 256)) * 1024);
+
+    initLogger();
+
+    boost::asio::io_context ioContext;
+
+    size_t msquicStoragePort = ConfigManager::Instance().GetInt("MsquicStorage.port");
+
+    size_t webSocketPort = ConfigManager::Instance().GetInt("WebSocket.port");
+
+    std::unique_ptr<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> work = std::make_unique<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>>(boost::asio::make_work_guard(ioContext));
+
+    hope::quic::MsquicServer msquicServer(ioContext,msquicStoragePort, webSocketPort);
+
+    hope::mysql::MsquicMysqlManagerPools::getInstance();
+
+    if (!msquicServer.initialize()){
+    
+        LOG_ERROR("hope::quic::MsquicServer::initialize Failed");
+
+        return -1;
+
+    }
+
+    if (!msquicServer.RunEventLoop()) {
+    
+        LOG_ERROR("hope::quic::MsquicServer::RunEventLoop Failed");
+
+        return -1;
+
+    }
+
+    boost::asio::signal_set signals(ioContext, SIGINT, SIGTERM);
+
+    signals.async_wait([&ioContext, &msquicServer, &work](const boost::system::error_code& error, int signal) {
+
+        msquicServer.shutDown();
+
+        work.reset();
+
+        ioContext.stop();
+
+        });
+
+    ioContext.run();
+
+    closeLogger();
+
+    return 0;
+
 }
\ No newline at end of file